@@ -254,6 +254,16 @@ void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc)
 	calendar_AlarmA_ISR();
 }
 
+
+/*
+ * Alarm B callback.
+ */
+void HAL_RTCEx_AlarmBEventCallback(RTC_HandleTypeDef *hrtc)
+{
+	// call ISR for handling calendar events
+	calendar_AlarmB_ISR();
+}
+
 /* USER CODE END 4 */
 
 /**
@@ -6,18 +6,33 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../Modules/Calendar/Src/calendar.c \
+../Modules/Calendar/Src/calendar_trace.c \
+../Modules/Calendar/Src/callback_profiler.c \
+../Modules/Calendar/Src/date_time.c \
 ../Modules/Calendar/Src/event_sll.c \
-../Modules/Calendar/Src/rtc_calendar_control.c 
+../Modules/Calendar/Src/rtc_alarm_driver.c \
+../Modules/Calendar/Src/rtc_calendar_control.c \
+../Modules/Calendar/Src/rtc_calendar_control_binary.c 
 
 OBJS += \
 ./Modules/Calendar/Src/calendar.o \
+./Modules/Calendar/Src/calendar_trace.o \
+./Modules/Calendar/Src/callback_profiler.o \
+./Modules/Calendar/Src/date_time.o \
 ./Modules/Calendar/Src/event_sll.o \
-./Modules/Calendar/Src/rtc_calendar_control.o 
+./Modules/Calendar/Src/rtc_alarm_driver.o \
+./Modules/Calendar/Src/rtc_calendar_control.o \
+./Modules/Calendar/Src/rtc_calendar_control_binary.o 
 
 C_DEPS += \
 ./Modules/Calendar/Src/calendar.d \
+./Modules/Calendar/Src/calendar_trace.d \
+./Modules/Calendar/Src/callback_profiler.d \
+./Modules/Calendar/Src/date_time.d \
 ./Modules/Calendar/Src/event_sll.d \
-./Modules/Calendar/Src/rtc_calendar_control.d 
+./Modules/Calendar/Src/rtc_alarm_driver.d \
+./Modules/Calendar/Src/rtc_calendar_control.d \
+./Modules/Calendar/Src/rtc_calendar_control_binary.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -27,7 +42,7 @@ Modules/Calendar/Src/%.o Modules/Calendar/Src/%.su Modules/Calendar/Src/%.cyclo:
 clean: clean-Modules-2f-Calendar-2f-Src
 
 clean-Modules-2f-Calendar-2f-Src:
-	-$(RM) ./Modules/Calendar/Src/calendar.cyclo ./Modules/Calendar/Src/calendar.d ./Modules/Calendar/Src/calendar.o ./Modules/Calendar/Src/calendar.su ./Modules/Calendar/Src/event_sll.cyclo ./Modules/Calendar/Src/event_sll.d ./Modules/Calendar/Src/event_sll.o ./Modules/Calendar/Src/event_sll.su ./Modules/Calendar/Src/rtc_calendar_control.cyclo ./Modules/Calendar/Src/rtc_calendar_control.d ./Modules/Calendar/Src/rtc_calendar_control.o ./Modules/Calendar/Src/rtc_calendar_control.su
+	-$(RM) ./Modules/Calendar/Src/calendar.cyclo ./Modules/Calendar/Src/calendar.d ./Modules/Calendar/Src/calendar.o ./Modules/Calendar/Src/calendar.su ./Modules/Calendar/Src/calendar_trace.cyclo ./Modules/Calendar/Src/calendar_trace.d ./Modules/Calendar/Src/calendar_trace.o ./Modules/Calendar/Src/calendar_trace.su ./Modules/Calendar/Src/callback_profiler.cyclo ./Modules/Calendar/Src/callback_profiler.d ./Modules/Calendar/Src/callback_profiler.o ./Modules/Calendar/Src/callback_profiler.su ./Modules/Calendar/Src/date_time.cyclo ./Modules/Calendar/Src/date_time.d ./Modules/Calendar/Src/date_time.o ./Modules/Calendar/Src/date_time.su ./Modules/Calendar/Src/event_sll.cyclo ./Modules/Calendar/Src/event_sll.d ./Modules/Calendar/Src/event_sll.o ./Modules/Calendar/Src/event_sll.su ./Modules/Calendar/Src/rtc_alarm_driver.cyclo ./Modules/Calendar/Src/rtc_alarm_driver.d ./Modules/Calendar/Src/rtc_alarm_driver.o ./Modules/Calendar/Src/rtc_alarm_driver.su ./Modules/Calendar/Src/rtc_calendar_control.cyclo ./Modules/Calendar/Src/rtc_calendar_control.d ./Modules/Calendar/Src/rtc_calendar_control.o ./Modules/Calendar/Src/rtc_calendar_control.su ./Modules/Calendar/Src/rtc_calendar_control_binary.cyclo ./Modules/Calendar/Src/rtc_calendar_control_binary.d ./Modules/Calendar/Src/rtc_calendar_control_binary.o ./Modules/Calendar/Src/rtc_calendar_control_binary.su
 
 .PHONY: clean-Modules-2f-Calendar-2f-Src
 
@@ -0,0 +1,39 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		Calendar HAL is the one place the Calendar module includes the STM32
+ *	HAL, so that the module can be built against a stand-in for the HAL, for
+ *	example to run the calendar on a host against a simulated RTC.  Define
+ *	CALENDAR_HAL_HEADER as the header to include in its place, such as
+ *	-DCALENDAR_HAL_HEADER='"host_hal.h"' of Tests > Host.
+ *		A stand-in must provide what the module uses of the HAL and CMSIS:
+ *		- RTC: RTC_HandleTypeDef and RTC_TypeDef (TR, DR, SSR, CR, MISR, SCR,
+ *		ALRMxR, ALRMxSSR, ALRxBINR), their register bit definitions, the
+ *		RTC_ALARM_x, RTC_FORMAT_x and RTC_ALARMx mask definitions,
+ *		HAL_RTC_Set/GetTime, HAL_RTC_Set/GetDate, HAL_RTC_SetAlarm_IT,
+ *		HAL_RTC_GetAlarm, HAL_RTC_DeactivateAlarm, HAL_RTC_AlarmIRQHandler,
+ *		HAL_RTCEx_BKUPRead/Write, the write protection and alarm EXTI macros,
+ *		and HAL_RCCEx_GetPeriphCLKFreq for the binary backend.
+ *		- Interrupts: RTC_LSECSS_IRQn (Cortex-M0+) or RTC_Alarm_IRQn (Cortex-M4)
+ *		unless CALENDAR_RTC_IRQn is defined, HAL_NVIC_EnableIRQ, HAL_NVIC_DisableIRQ,
+ *		HAL_NVIC_ClearPendingIRQ, __get_PRIMASK, __set_PRIMASK, __disable_irq,
+ *		__DMB, and __LDREXW/__STREXW if __CORTEX_M is 3 or more.
+ *		- Timing: HAL_GetTick, HAL_GetTickFreq, and SysTick (LOAD, VAL), or DWT
+ *		and CoreDebug if __CORTEX_M is 3 or more.
+ *		- Registers: READ_REG, WRITE_REG, SET_BIT, CLEAR_BIT.
+ */
+
+#ifndef CALENDAR_INC_CALENDAR_HAL_H_
+#define CALENDAR_INC_CALENDAR_HAL_H_
+
+
+#ifdef CALENDAR_HAL_HEADER
+#include CALENDAR_HAL_HEADER
+#else
+#include "stm32wlxx_hal.h"
+#endif
+
+
+#endif /* CALENDAR_INC_CALENDAR_HAL_H_ */
@@ -0,0 +1,143 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		Calendar Trace records the scheduler's activity (alarms fired and armed,
+ *	events entered and exited, pauses, starts, and time changes) as fixed size
+ *	binary records in a ring buffer in RAM.  Recording is lock-free and takes a
+ *	slot with a single exclusive increment, so records can be made from the
+ *	alarm interrupt and the main loop alike.  The oldest records are overwritten
+ *	once the buffer is full.
+ *		The buffer can be read from a debugger, directly through the pointer from
+ *	calendarTrace_getBuffer(), or record by record with calendarTrace_read() to
+ *	send over a UART.  Tools/calendar_trace_decode.py turns a dump of the
+ *	buffer, or a stream of records, into a timeline.
+ *		The trace is only compiled with CALENDAR_TRACE defined.  Otherwise the
+ *	scheduler does not record, with no overhead.
+ */
+
+#ifndef CALENDAR_INC_CALENDAR_TRACE_H_
+#define CALENDAR_INC_CALENDAR_TRACE_H_
+
+
+#include <calendar_hal.h>
+#include <stdbool.h>
+
+/*
+ * Define to trace the scheduler.
+ */
+//#define CALENDAR_TRACE
+
+/*
+ * Number of records in the trace buffer, must be a power of two.
+ */
+#ifndef CALENDAR_TRACE_SIZE
+#define CALENDAR_TRACE_SIZE 64
+#endif
+
+/*
+ * Marks the start of the trace buffer, for tools reading a memory dump.
+ */
+#define CALENDAR_TRACE_MAGIC 0x43545243
+
+/*
+ * Kinds of trace records, and what their argument holds.  The values are part
+ * of the dump format, add new kinds at the end.
+ */
+typedef enum {
+  CALENDAR_TRACE_ALARM_FIRED = 1,		// alarm (0 = A, 1 = B)
+  CALENDAR_TRACE_ALARM_ARMED,			// alarm
+  CALENDAR_TRACE_ALARM_HOP_ARMED,		// alarm
+  CALENDAR_TRACE_ALARM_REARMED,			// alarm, re-armed from interrupt
+  CALENDAR_TRACE_ALARM_DISARMED,		// alarm
+  CALENDAR_TRACE_EVENT_EXITED,			// event ID
+  CALENDAR_TRACE_EVENT_ENTERED,			// event ID
+  CALENDAR_TRACE_TRIGGER,				// event ID of the trigger
+  CALENDAR_TRACE_PREPARE,				// event ID
+  CALENDAR_TRACE_PAUSED,				// none
+  CALENDAR_TRACE_STARTED,				// none
+  CALENDAR_TRACE_TIME_SET,				// none, seconds is the new time
+  CALENDAR_TRACE_STORM,					// alarm interrupts since the last update
+  CALENDAR_TRACE_MISMATCH				// none
+} CalendarTraceType;
+
+/*
+ * One trace record.
+ */
+typedef struct {
+  uint32_t sequence;	// number of the record from 1, 0 while being written
+  uint32_t seconds;		// cached seconds since the start of the century
+  uint32_t tick;		// HAL tick (ms)
+  uint16_t type;		// CalendarTraceType
+  uint16_t arg;			// argument of the record
+} CalendarTraceRecord;
+
+/*
+ * Trace buffer, laid out for reading from a memory dump.
+ */
+typedef struct {
+  uint32_t magic;		// CALENDAR_TRACE_MAGIC
+  uint16_t size;		// number of records (CALENDAR_TRACE_SIZE)
+  uint16_t recordSize;	// bytes per record
+  volatile uint32_t head;	// number of records taken, the next record's index
+  volatile CalendarTraceRecord records[CALENDAR_TRACE_SIZE];
+} CalendarTrace;
+
+
+#ifdef CALENDAR_TRACE
+
+/* calendarTrace_init
+ *
+ * Function:
+ *	Clears the trace buffer.
+ */
+void calendarTrace_init(void);
+
+/* calendarTrace_record
+ *
+ * Function:
+ *	Records scheduler activity.  Safe to call from interrupts.
+ *
+ * Parameters:
+ *	type - kind of record, a CalendarTraceType
+ *	arg - argument of the record
+ *	seconds - seconds since the start of the century
+ */
+void calendarTrace_record(const CalendarTraceType type, const uint16_t arg,
+		const uint32_t seconds);
+
+/* calendarTrace_read
+ *
+ * Function:
+ *	Reads the next record from the trace buffer.
+ *
+ * Parameters:
+ *	cursor - pointer to the index of the next record to read, start at 0.
+ *			Moved past records that were overwritten before they were read.
+ *	record - pointer to store the record in
+ *
+ * Return:
+ *	bool - true if a record was read, false if there are no new records
+ */
+bool calendarTrace_read(uint32_t* const cursor, CalendarTraceRecord* const record);
+
+/* calendarTrace_getBuffer
+ *
+ * Function:
+ *	Gets the trace buffer, to be read directly by the core recording it.  The
+ *	buffer is in the core's own RAM, not in memory shared with the other core.
+ *
+ * Return:
+ *	const volatile CalendarTrace* - the trace buffer
+ *
+ * Note:
+ *	A record is only complete if its sequence is its index + 1.  Read the
+ *	sequence before and after copying a record.
+ */
+const volatile CalendarTrace* calendarTrace_getBuffer(void);
+
+#endif /* CALENDAR_TRACE */
+
+
+#endif /* CALENDAR_INC_CALENDAR_TRACE_H_ */
@@ -0,0 +1,107 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		Date Time provides the date and time structure shared by the calendar
+ *	modules, and conversions between a date and time and a count of seconds.
+ *	Counting seconds accounts for month lengths and leap years, and gives a
+ *	single value that can be compared or stored in a 32-bit counter.
+ */
+
+#ifndef CALENDAR_INC_DATE_TIME_H_
+#define CALENDAR_INC_DATE_TIME_H_
+
+
+#include <stdint.h>
+
+/*
+ * Structure to hold a date and time.
+ */
+typedef struct {
+  uint8_t year;		// two digit 21st century year 		(0 - 99)
+  uint8_t month;	// two digit month 					(1 - 12)
+  uint8_t day;		// two digit day of month 			(1 - 28/29/30/31)
+  uint8_t hour;		// two digit hour in 24 hour format (0 - 23)
+  uint8_t minute;	// two digit minute 				(0 - 59)
+  uint8_t second;	// two digit second 				(0 - 59)
+  uint16_t millisecond;	// millisecond of the second	(0 - 999)
+} DateTime;
+
+
+/* dateTime_toSeconds
+ *
+ * Function:
+ *	Converts a date and time to seconds since the start of the century
+ *	(00/01/01 00:00:00).
+ *
+ * Parameters:
+ *	dateTime - the date and time to convert.  The millisecond is ignored.
+ *
+ * Return:
+ *	uint32_t - seconds since the start of the century
+ *
+ * Note:
+ *	There is no error checking for inputs outside of valid range and behavior
+ *	undefined if so.
+ */
+uint32_t dateTime_toSeconds(const DateTime dateTime);
+
+/* dateTime_fromSeconds
+ *
+ * Function:
+ *	Converts seconds since the start of the century (00/01/01 00:00:00) to a
+ *	date and time.
+ *
+ * Parameters:
+ *	seconds - seconds since the start of the century
+ *	dateTime - pointer to a DateTime to store the result in.  The millisecond
+ *			is set to 0.
+ */
+void dateTime_fromSeconds(const uint32_t seconds, DateTime* const dateTime);
+
+/* dateTime_addMillis
+ *
+ * Function:
+ *	Moves a date and time later, or earlier, by a number of milliseconds.
+ *
+ * Parameters:
+ *	dateTime - pointer to the DateTime to move
+ *	millis - milliseconds to move by, negative to move earlier
+ *
+ * Note:
+ *	Clamps to the start of the century.
+ */
+void dateTime_addMillis(DateTime* const dateTime, const int32_t millis);
+
+/* dateTime_millisBetween
+ *
+ * Function:
+ *	Gets the milliseconds from one date and time to another.
+ *
+ * Parameters:
+ *	from - the earlier date and time
+ *	to - the later date and time
+ *
+ * Return:
+ *	int32_t - milliseconds from from to to, negative if to is earlier.  Saturates
+ *			at the range of int32_t (about 24 days).
+ */
+int32_t dateTime_millisBetween(const DateTime from, const DateTime to);
+
+/* dateTime_daysInMonth
+ *
+ * Function:
+ *	Gets the number of days in a month.
+ *
+ * Parameters:
+ *	year - two digit 21st century year 		(0 - 99)
+ *	month - two digit month 				(1 - 12)
+ *
+ * Return:
+ *	uint8_t - the number of days in the month (28/29/30/31)
+ */
+uint8_t dateTime_daysInMonth(const uint8_t year, const uint8_t month);
+
+
+#endif /* CALENDAR_INC_DATE_TIME_H_ */
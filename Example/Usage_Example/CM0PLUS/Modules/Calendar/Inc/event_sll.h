@@ -10,8 +10,8 @@
  * 	notable difference that it is statically allocated at compile time,
  * 	giving it a fixed maximum number of events that it can store.
  * 		The sll provides the standar means to insert, remove, and peek
- * 	at events.  An additional function is provided to get the next alarm
- * 	to set within the RTC.
+ * 	at events.  Additional functions are provided to get the next alarm
+ * 	to set within the RTC, and to look ahead to the alarm following it.
  */
 
 #ifndef CALENDAR_INC_EVENT_SLL_H_
@@ -20,11 +20,15 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <date_time.h>
 
 /*
- * Size of the CalendarEvent queue.
+ * Size of the CalendarEvent queue.  Can be set from the build (-DMAX_NUM_EVENTS=n),
+ * for example to measure the queue's operations at other capacities.
  */
+#ifndef MAX_NUM_EVENTS
 #define MAX_NUM_EVENTS 32
+#endif
 
 /*
  * Static linked-list index for end of list.
@@ -32,27 +36,33 @@
 #define EVENTS_SLL_NO_EVENT (-1)
 
 /*
- * Structure to hold a date and time.
+ * Count of the nodes the list's operations step through, to measure their worst
+ * case on a host.  Only compiled with EVENT_SLL_COUNT_VISITS defined.
  */
-typedef struct {
-  uint8_t year;		// two digit 21st century year 		(0 - 99)
-  uint8_t month;	// two digit month 					(1 - 12)
-  uint8_t day;		// two digit day of month 			(1 - 28/29/30/31)
-  uint8_t hour;		// two digit hour in 24 hour format (0 - 23)
-  uint8_t minute;	// two digit minute 				(0 - 59)
-  uint8_t second;	// two digit second 				(0 - 59)
-} DateTime;
+#ifdef EVENT_SLL_COUNT_VISITS
+extern uint32_t eventSLL_visits;
+#define EVENT_SLL_VISIT() (eventSLL_visits++)
+#else
+#define EVENT_SLL_VISIT()
+#endif
 
 /*
  * Structure to hold the start and end DateTime of an event
  * along with callback function pointers to execute when an
- * event starts and ends.
+ * event starts and ends.  An event with the same start and
+ * end is a trigger, only its start callback is executed.  An
+ * event with a prepare callback and lead time has the prepare
+ * callback executed the lead time before it starts.
  */
 typedef struct CalendarEvent {
   DateTime start;
   DateTime end;
   void (*start_callback)(void);
   void (*end_callback)(void);
+  uint16_t slack;	// seconds the event's transitions may run late to share a wakeup
+  void (*prepare_callback)(void);	// called the lead time before the start
+  uint16_t lead;	// milliseconds before the start to call the prepare callback
+  uint8_t latency_class;	// class of dispatch latency to compensate the event's alarms for, 0 for none
 } CalendarEvent;
 
 /*
@@ -108,6 +118,9 @@ bool eventSLL_reset(Event_SLL* const sll);
  *  this can be done after a bulk of insert operations.
  *
  * Note:  monotonic ordering is preserved on start times of events only.
+ *
+ * Note:  worst case visits every event, when the event starts at or after the
+ *  last one.
  */
 bool eventSLL_insert(Event_SLL* const sll, const struct CalendarEvent event);
 
@@ -125,6 +138,8 @@ bool eventSLL_insert(Event_SLL* const sll, const struct CalendarEvent event);
  *
  * Note:  it is recommended to run eventSLL_getNextAlarm() after removing events.
  *  this can be done after a bulk of remove operations.
+ *
+ * Note:  worst case visits every event, when removing the last one.
  */
 bool eventSLL_remove(Event_SLL* const sll, const unsigned int id);
 
@@ -159,8 +174,115 @@ bool eventSLL_peekIdx(Event_SLL* const sll, const unsigned int id, struct Calend
  *
  * Note:  call eventSLL_getNextAlarm() after updating inserting or removing events
  * 	to prevent undefined behavior.
+ *
+ * Note:  worst case visits every event twice, once for prepares and once in
+ * 	start order, when no event has ended before the DateTime.
  */
 bool eventSLL_getNextAlarm(Event_SLL* const sll, const DateTime dateTime, DateTime* const alarm);
 
+/* eventSLL_peekNextAlarm
+ *
+ * Function:
+ * 	Gets the next alarm to the DateTime passed in without updating the event in
+ * 	progress.  Used to look ahead past the next alarm, e.g. passing in the alarm
+ * 	returned by eventSLL_getNextAlarm() gives the alarm that follows it.
+ *
+ * Parameters:
+ * 	sll - pointer to an Event_SLL
+ * 	dateTime - a DateTime to get the next alarm to
+ *
+ * Return:
+ * 	bool - true if an alarm was found and returned, false otherwise
+ * 	alarm - pointer to a DateTime to store the result in
+ */
+bool eventSLL_peekNextAlarm(Event_SLL* const sll, const DateTime dateTime, DateTime* const alarm);
+
+/* eventSLL_peekInProgress
+ *
+ * Function:
+ * 	Gets the event in progress at the DateTime passed in without updating the
+ * 	event in progress.  Used to step through the events in progress at each alarm
+ * 	between two DateTimes.
+ *
+ * Parameters:
+ * 	sll - pointer to an Event_SLL
+ * 	dateTime - a DateTime to get the event in progress at
+ *
+ * Return:
+ * 	int - index of the event in progress, or EVENTS_SLL_NO_EVENT if none
+ */
+int eventSLL_peekInProgress(Event_SLL* const sll, const DateTime dateTime);
+
+/* eventSLL_nextTrigger
+ *
+ * Function:
+ * 	Gets the next trigger at the DateTime passed in.  A trigger is an event with
+ * 	the same start and end, it is never in progress and has only its start
+ * 	callback called.  Call repeatedly to iterate over all triggers at the
+ * 	DateTime in list order.
+ *
+ * Parameters:
+ * 	sll - pointer to an Event_SLL
+ * 	dateTime - a DateTime to get the triggers at
+ * 	idx - pointer to the index of the previous trigger, EVENTS_SLL_NO_EVENT to
+ * 			start from the first.  Set to the index of the trigger found.
+ *
+ * Return:
+ * 	bool - true if a trigger was found, false otherwise
+ */
+bool eventSLL_nextTrigger(Event_SLL* const sll, const DateTime dateTime, int* const idx);
+
+/* eventSLL_getSlack
+ *
+ * Function:
+ * 	Gets the slack of an alarm, the least slack of the events that start or end
+ * 	at the alarm.
+ *
+ * Parameters:
+ * 	sll - pointer to an Event_SLL
+ * 	alarm - a DateTime of an alarm returned by eventSLL_getNextAlarm() or
+ * 			eventSLL_peekNextAlarm()
+ *
+ * Return:
+ * 	uint16_t - the slack in seconds, 0 if no event starts or ends at the alarm
+ */
+uint16_t eventSLL_getSlack(Event_SLL* const sll, const DateTime alarm);
+
+/* eventSLL_nextPrepare
+ *
+ * Function:
+ * 	Gets the next event to prepare at the DateTime passed in, the event's start
+ * 	less its lead time.  Call repeatedly to iterate over all events prepared at
+ * 	the DateTime in list order.
+ *
+ * Parameters:
+ * 	sll - pointer to an Event_SLL
+ * 	dateTime - a DateTime to get the prepared events at
+ * 	idx - pointer to the index of the previous event, EVENTS_SLL_NO_EVENT to start
+ * 			from the first.  Set to the index of the event found.
+ *
+ * Return:
+ * 	bool - true if an event was found, false otherwise
+ */
+bool eventSLL_nextPrepare(Event_SLL* const sll, const DateTime dateTime, int* const idx);
+
+/* eventSLL_getLatencyClass
+ *
+ * Function:
+ * 	Gets the latency class of an alarm, the class of the first event in list
+ * 	order that starts, ends, or is prepared at the alarm.
+ *
+ * Parameters:
+ * 	sll - pointer to an Event_SLL
+ * 	alarm - a DateTime of an alarm returned by eventSLL_getNextAlarm() or
+ * 			eventSLL_peekNextAlarm()
+ * 	latencyClass - pointer to store the latency class in
+ *
+ * Return:
+ * 	bool - true if an event starts, ends, or is prepared at the alarm
+ */
+bool eventSLL_getLatencyClass(Event_SLL* const sll, const DateTime alarm,
+		uint8_t* const latencyClass);
+
 
 #endif /* CALENDAR_INC_EVENT_SLL_H_ */
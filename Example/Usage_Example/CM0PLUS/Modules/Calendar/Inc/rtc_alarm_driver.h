@@ -0,0 +1,97 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		RTC Alarm Driver arms and disarms the RTC's alarms by writing the alarm
+ *	registers directly, for the RTC Calendar Control backends.  Arming compares
+ *	against the values already in the alarm's registers and skips the write if
+ *	the alarm is already armed with them.  Writes are confirmed by reading the
+ *	registers back, with a bounded number of attempts, so that failures are
+ *	reported rather than ignored.  Fired alarms can be cleared from the RTC's
+ *	interrupt directly, without the HAL's interrupt dispatch.
+ */
+
+#ifndef CALENDAR_INC_RTC_ALARM_DRIVER_H_
+#define CALENDAR_INC_RTC_ALARM_DRIVER_H_
+
+
+#include <calendar_hal.h>
+#include <stdbool.h>
+#include <rtc_calendar_control.h>
+
+/*
+ * Number of register reads to confirm an alarm write before giving up.
+ */
+#define RTC_ALARM_DRIVER_CONFIRM_READS 16
+
+/* rtcAlarmDriver_arm
+ *
+ * Function:
+ *	Arms an RTC alarm with an interrupt enabled, unless it is already armed with
+ *	the same register values.
+ *
+ * Parameters:
+ *	hrtc - a RTC_HandleTypeDef pointer to an initialized HAL RTC handle
+ *	whichAlarm - RTC_ALARM_A or RTC_ALARM_B
+ *	alarmReg - value for the alarm register (ALRMxR), the BCD day and time
+ *			fields and masks.  Not used if the RTC is in binary only mode.
+ *	subSecondMaskReg - value for the alarm sub-second register (ALRMxSSR), the
+ *			sub-second mask and binary auto clear settings
+ *	subSeconds - sub-second counter value to compare (ALRxBINR)
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if the handle is not initialized
+ *		RTC_CALENDAR_CONTROL_TIMEOUT - if the registers did not read back as
+ *				written
+ *		RTC_CALENDAR_CONTROL_OKAY - if armed, or already armed
+ *
+ * Note:
+ *	Does not take the HAL RTC lock, do not call alongside other HAL RTC calls
+ *	from interrupts.
+ */
+RtcUtilsStatus rtcAlarmDriver_arm(RTC_HandleTypeDef* const hrtc, const uint32_t whichAlarm,
+		const uint32_t alarmReg, const uint32_t subSecondMaskReg, const uint32_t subSeconds);
+
+/* rtcAlarmDriver_disarm
+ *
+ * Function:
+ *	Disarms an RTC alarm and clears its flag, unless it is already disarmed.
+ *
+ * Parameters:
+ *	hrtc - a RTC_HandleTypeDef pointer to an initialized HAL RTC handle
+ *	whichAlarm - RTC_ALARM_A or RTC_ALARM_B
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if the handle is not initialized
+ *		RTC_CALENDAR_CONTROL_TIMEOUT - if the alarm did not read back as disabled
+ *		RTC_CALENDAR_CONTROL_OKAY - if disarmed, or already disarmed
+ */
+RtcUtilsStatus rtcAlarmDriver_disarm(RTC_HandleTypeDef* const hrtc, const uint32_t whichAlarm);
+
+/* rtcAlarmDriver_clearFired
+ *
+ * Function:
+ *	Clears the flags of fired RTC alarms (A and B).  For use at the start of the
+ *	RTC alarm interrupt.
+ *
+ * Parameters:
+ *	hrtc - a RTC_HandleTypeDef pointer to an initialized HAL RTC handle
+ *	pending - pointer to store the other RTC interrupt sources pending (RTC_MISR
+ *			flags), from the same read
+ *
+ * Return:
+ *	uint32_t - the fired alarms' flags (RTC_MISR_ALRAMF and RTC_MISR_ALRBMF), 0 if
+ *			no alarm fired
+ *
+ * Note:
+ *	Reads the masked interrupt status once and writes the clear register once, if
+ *	an alarm fired.  An alarm that fires after the read keeps its flag set and
+ *	takes the interrupt again.
+ */
+uint32_t rtcAlarmDriver_clearFired(RTC_HandleTypeDef* const hrtc, uint32_t* const pending);
+
+
+#endif /* CALENDAR_INC_RTC_ALARM_DRIVER_H_ */
@@ -7,16 +7,120 @@
 
 
 #include <rtc_calendar_control.h>
+#include <rtc_alarm_driver.h>
 #include <calendar.h>
+#include <calendar_trace.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
+#include <limits.h>
+
+
+/*
+ * Indexes of the RTC alarms used by the scheduler.  The next two transitions
+ * are kept armed at once, alternating between Alarm A and Alarm B.
+ */
+#define ALARM_A 0
+#define ALARM_B 1
+#define NUM_ALARMS 2
+
+/*
+ * Number of transitions after the two armed alarms that are encoded ahead of time,
+ * so that the alarm interrupt can re-arm the alarm that fired without waiting for
+ * the next update.
+ */
+#define LOOKAHEAD_SIZE 4
+
+/*
+ * Number of alarm interrupts between scheduler updates above which the alarm
+ * interrupt is treated as a storm.  Between updates each armed alarm can fire,
+ * and each transition in the lookahead can be armed by the interrupt and fire,
+ * so more fires than those can not be genuine.
+ */
+#define STORM_FIRES (NUM_ALARMS + LOOKAHEAD_SIZE)
+
+/*
+ * Dispatch latency compensation.  Each error between a callback and its transition
+ * is folded into the estimate of its class with a gain of 1 / LATENCY_GAIN.  The
+ * estimate is limited to 0 - LATENCY_MAX_MS.
+ */
+#define LATENCY_GAIN 4
+#define LATENCY_MAX_MS 1000
+
+/*
+ * Least time from now that a compensated alarm is armed for, so that it is not in
+ * the past by the time it is written.  A transition whose compensated alarm would
+ * be sooner is run immediately instead.
+ */
+#define ALARM_MIN_LEAD_MS 10
+
+/*
+ * Limit of transitions for an update that runs every passed transition.
+ */
+#define ALL_TRANSITIONS UINT_MAX
+
+/*
+ * Calls a callback of the event at an index, timed by the callback profiler if
+ * it is compiled in.
+ */
+#ifdef CALENDAR_PROFILE_CALLBACKS
+#define RUN_CALLBACK(idx, callback) callbackProfiler_run((idx), (callback))
+#else
+#define RUN_CALLBACK(idx, callback) (*(callback))()
+#endif
+
+/*
+ * Records scheduler activity in the trace, if it is compiled in.
+ */
+#ifdef CALENDAR_TRACE
+#define TRACE(type, arg) calendarTrace_record((type), (uint16_t)(arg), _cachedEpoch)
+#else
+#define TRACE(type, arg)
+#endif
+
+
+/*
+ * Transition encoded ahead of time for arming from the alarm interrupt.
+ */
+typedef struct {
+	DateTime alarm;				// date and time of the transition
+	RtcAlarmRegisters regs;		// alarm register values of the transition
+} LookaheadEntry;
 
 
 /*
  * Private function prototypes.
  */
-void _update(void);
+CalendarStatus _updateScheduler(const unsigned int maxTransitions);
+bool _update(const bool isFromAlarm, const unsigned int maxTransitions);
+void _alarmFired(void);
+uint32_t _takePendingFires(void);
+void _recoverFromStorm(void);
+void _disarmAlarms(void);
+void _resetStats(void);
+int _fillLookahead(const DateTime now, DateTime after, LookaheadEntry* const entries);
+bool _nextWakeup(const DateTime after, DateTime* const wakeup);
+void _applySlack(DateTime* const wakeup);
+void _compensate(const DateTime now, DateTime* const wakeup);
+void _measureLatency(const DateTime transition);
+void _stampAlarm(const RtcTimestamp* const timestamp);
+void _recordDispatch(void);
+uint32_t _countPassedTransitions(const DateTime now);
+void _rearmFromLookahead(const int alarmIdx);
+bool _armAlarms(const DateTime* const nextAlarm, const bool nextIsHop,
+		const DateTime* const followingAlarm);
+bool _armAlarm(const int alarmIdx, const DateTime* const alarm, const bool isHop);
+bool _isArmedWith(const int alarmIdx, const DateTime* const alarm);
+bool _isReached(const DateTime now, const DateTime alarm);
+bool _isPassed(const DateTime alarm);
+bool _runPassedTransitions(int* const exited, const DateTime now,
+		const unsigned int maxTransitions, DateTime* const resumeAt);
+void _runTransition(const int exited, const int entered, const DateTime at);
+void _enterActive(const int idx, const uint32_t seconds, const uint16_t millisecond);
+void _exitActive(const uint32_t seconds, const uint16_t millisecond);
+uint64_t _activeSoFar(void);
+void _runTriggers(const DateTime at);
+void _runPrepares(const DateTime at);
 
 
 /*
@@ -25,8 +129,44 @@ void _update(void);
  */
 static bool _isInit = false;		// signals if the module has been initialized
 static bool _isRunning = false;		// signals if the calendar is running
-volatile static bool _alarmAFired = false;	// signals if Alarm A has fired, need to update calendar
+volatile static uint32_t _pendingFires = 0;	// alarm interrupts not yet taken by an update
+static bool _isUpdateDue = false;	// signals if the scheduler needs to update without an alarm
 static Event_SLL _eventQueue;		// queue of events to execute on the calendar
+static DateTime _armedAlarms[NUM_ALARMS];	// date and time each RTC alarm is armed with
+static bool _isArmed[NUM_ALARMS] = {false, false};	// signals if each RTC alarm is armed
+static bool _isHop[NUM_ALARMS] = {false, false};	// signals if each RTC alarm is armed with a hop
+static uint32_t _hopWakeups = 0;	// number of hop alarms that have been reached
+volatile static uint32_t _cachedEpoch = 0;	// cached seconds since the start of the century
+volatile static RtcTimestamp _alarmTimestamp;	// RTC registers when the last alarm was handled
+volatile static uint32_t _alarmIrqCount = 0;	// number of alarms handled by the alarm interrupt
+static uint32_t _dispatchedIrqCount = 0;	// alarm count when the last dispatch was recorded
+static CalendarLatencyHistogram _latencyHistogram;	// alarm to callback latencies
+volatile static bool _isStormMasked = false;	// signals if the alarm interrupt was masked for a storm
+static uint32_t _stormCount = 0;	// number of alarm interrupt storms recovered from
+static uint32_t _mismatchCount = 0;	// number of alarm updates where no armed alarm was reached
+static uint32_t _updateCount = 0;	// number of updates run
+volatile static uint32_t _alarmFireCount = 0;	// number of alarm interrupts
+static uint32_t _transitionCount = 0;	// number of event changes, triggers, and prepares run
+static uint32_t _skippedCount = 0;	// number of transitions passed while paused
+volatile static uint32_t _rearmCount = 0;	// number of alarms re-armed from interrupt
+static uint32_t _maxUpdateCycles = 0;	// most cycles of an update
+static unsigned int _maxEventCount = 0;	// most events in the calendar at once
+static uint64_t _activeMillis[MAX_NUM_EVENTS];	// time each event was active, ended spans (ms)
+static uint64_t _classActiveMillis[CALENDAR_LATENCY_CLASSES];	// time each class was active (ms)
+static int _activeIdx = EVENTS_SLL_NO_EVENT;	// index of the event entered and not yet exited
+static uint32_t _activeSeconds;		// seconds when the active event was entered
+static uint16_t _activeMillisecond;	// millisecond when the active event was entered
+static int32_t _latencyEstimate[CALENDAR_LATENCY_CLASSES];	// estimated dispatch latency of each class (ms)
+static int32_t _latencyError[CALENDAR_LATENCY_CLASSES];	// last error of a callback of each class (ms)
+static LookaheadEntry _lookahead[LOOKAHEAD_SIZE];	// transitions to re-arm with from interrupt
+volatile static int _lookaheadHead = 0;	// index of the next transition in the lookahead
+volatile static int _lookaheadCount = 0;	// number of transitions in the lookahead
+volatile static bool _isRearmed = false;	// signals if an alarm was re-armed from interrupt
+static DateTime _rearmedAlarm;		// transition replaced by the last re-arm from interrupt
+static DateTime _lastUpdate;		// date and time of the last update
+static bool _hasLastUpdate = false;	// signals if transitions since the last update are run
+static bool _isReplaying = false;	// signals if a bounded update left passed transitions to run
+static int _replayInProgress;		// event in progress after the last transition a bounded update ran
 
 
 /* calendar_init
@@ -38,6 +178,8 @@ static Event_SLL _eventQueue;		// queue of events to execute on the calendar
  */
 CalendarStatus calendar_init(RTC_HandleTypeDef* hrtc)
 {
+	uint32_t seconds;
+
 	// check for pointer to initialized RTC handle
 	if (hrtc != NULL && hrtc->Instance != NULL)
 	{
@@ -47,8 +189,34 @@ CalendarStatus calendar_init(RTC_HandleTypeDef* hrtc)
 			// pass pointer to alarm control
 			rtcCalendarControl_init(hrtc);
 
+			// start with both alarms disarmed so that no alarm left over from
+			// the RTC's configuration fires into the scheduler
+			rtcCalendarControl_diableAlarm_A();
+			rtcCalendarControl_diableAlarm_B();
+			_isArmed[ALARM_A] = false;
+			_isArmed[ALARM_B] = false;
+			_resetStats();
+			callbackProfiler_initCycles();
+			memset(_latencyEstimate, 0, sizeof(_latencyEstimate));
+			memset(_latencyError, 0, sizeof(_latencyError));
+			memset(&_latencyHistogram, 0, sizeof(_latencyHistogram));
+			_dispatchedIrqCount = _alarmIrqCount;
+
 			// initialize the calendar
 			eventSLL_reset(&_eventQueue);
+			memset(_activeMillis, 0, sizeof(_activeMillis));
+			memset(_classActiveMillis, 0, sizeof(_classActiveMillis));
+			_activeIdx = EVENTS_SLL_NO_EVENT;
+#ifdef CALENDAR_PROFILE_CALLBACKS
+			callbackProfiler_init();
+#endif
+#ifdef CALENDAR_TRACE
+			calendarTrace_init();
+#endif
+
+			// start the cached date and time from the RTC
+			rtcCalendarControl_getEpoch(&seconds, NULL);
+			_cachedEpoch = seconds;
 
 			// set init flag
 			_isInit = true;
@@ -67,14 +235,59 @@ CalendarStatus calendar_init(RTC_HandleTypeDef* hrtc)
 
 /* calendar_resetEvents
  *
- * Reset the events linked list.
+ * Reset the events linked list, stopping the scheduler and disarming the alarms
+ * armed with the events' transitions.
  */
 CalendarStatus calendar_resetEvents(void)
 {
+	uint32_t primask;
+
 	// if the module is initialized
 	if (_isInit)
 	{
+		// stop the scheduler
+		if (_isRunning)
+		{
+			_isRunning = false;
+			TRACE(CALENDAR_TRACE_PAUSED, 0);
+		}
+
+		// end the active time of the active event, its end callback will not run
+		if (_activeIdx != EVENTS_SLL_NO_EVENT)
+			_exitActive(_cachedEpoch, 0);
+
+		// drop the transitions to re-arm with from interrupt, then disarm the
+		// alarms, unmasking the alarm interrupt if a storm masked it
+		primask = __get_PRIMASK();
+		__disable_irq();
+		_lookaheadHead = 0;
+		_lookaheadCount = 0;
+		_isRearmed = false;
+		__set_PRIMASK(primask);
+		if (_isStormMasked)
+			_recoverFromStorm();
+		else
+			_disarmAlarms();
+
+		// forget the alarms fired and the transitions left to run for the events
+		_takePendingFires();
+		_isUpdateDue = false;
+		_hasLastUpdate = false;
+		_isReplaying = false;
+		_replayInProgress = EVENTS_SLL_NO_EVENT;
+
+		// start the statistics over, with interrupts disabled as the alarm
+		// interrupt counts some of them
+		primask = __get_PRIMASK();
+		__disable_irq();
+		_resetStats();
+		__set_PRIMASK(primask);
+
 		eventSLL_reset(&_eventQueue);
+		memset(_activeMillis, 0, sizeof(_activeMillis));
+#ifdef CALENDAR_PROFILE_CALLBACKS
+		callbackProfiler_init();
+#endif
 
 		return CALENDAR_OKAY;
 	}
@@ -96,16 +309,44 @@ CalendarStatus calendar_resetEvents(void)
  */
 CalendarStatus calendar_startScheduler(void)
 {
+	DateTime now;
+	uint32_t nowSeconds;
+	uint16_t nowMillisecond;
+
 	// if the module has been initialized
 	if (_isInit)
 	{
 		// only start if the calendar has been paused
 		if (!_isRunning)
 		{
-			_update();
-
 			// set is running flag
 			_isRunning = true;
+			TRACE(CALENDAR_TRACE_STARTED, 0);
+
+			// ignore transitions passed while paused, counting them as skipped
+			// along with any a bounded update left to run
+			if (_hasLastUpdate && rtcCalendarControl_getEpoch(&nowSeconds, &nowMillisecond)
+					== RTC_CALENDAR_CONTROL_OKAY)
+			{
+				dateTime_fromSeconds(nowSeconds, &now);
+				now.millisecond = nowMillisecond;
+				_skippedCount += _countPassedTransitions(now);
+			}
+
+			// a bounded update left the event it last entered in progress, the
+			// first update exits it rather than the event in progress at the
+			// time it stopped at
+			if (_isReplaying)
+				_eventQueue.inProgress = _replayInProgress;
+			_hasLastUpdate = false;
+			_isReplaying = false;
+
+			// if the RTC alarms could not be armed, retry on the next update
+			if (!_update(false, ALL_TRANSITIONS))
+			{
+				_isUpdateDue = true;
+				return CALENDAR_RTC_ERROR;
+			}
 
 			return CALENDAR_OKAY;
 		}
@@ -140,6 +381,7 @@ CalendarStatus calendar_pauseScheduler(void)
 		if (_isRunning)
 		{
 			_isRunning = false;
+			TRACE(CALENDAR_TRACE_PAUSED, 0);
 
 			return CALENDAR_OKAY;
 		}
@@ -174,6 +416,8 @@ CalendarStatus calendar_setDateTime(const DateTime dateTime)
 			// set the date and time in the RTC
 			rtcCalendarControl_setDateTime(dateTime.year, dateTime.month, dateTime.day,
 					dateTime.hour, dateTime.minute, dateTime.second);
+			_cachedEpoch = dateTime_toSeconds(dateTime);
+			TRACE(CALENDAR_TRACE_TIME_SET, 0);
 
 			return CALENDAR_OKAY;
 		}
@@ -204,7 +448,7 @@ CalendarStatus calendar_getDateTime(DateTime* const dateTime)
 		// get the date and time in the RTC
 		rtcCalendarControl_getDateTime(&(dateTime->year), &(dateTime->month),
 				&(dateTime->day), &(dateTime->hour), &(dateTime->minute),
-				&(dateTime->second));
+				&(dateTime->second), &(dateTime->millisecond));
 
 		return CALENDAR_OKAY;
 	}
@@ -217,36 +461,22 @@ CalendarStatus calendar_getDateTime(DateTime* const dateTime)
 }
 
 
-/* calendar_addEvent
+/* calendar_getEpoch
  *
- * Add an event to the calendar's event linked list.
+ * Get the date/time within the RTC as seconds since the start of the century.
  */
-CalendarStatus calendar_addEvent(const struct CalendarEvent event)
+CalendarStatus calendar_getEpoch(uint32_t* const seconds, uint16_t* const millisecond)
 {
-	// add only if the calendar has been initialized
+	// if the module is initialized
 	if (_isInit)
 	{
-		// if the calendar is paused
-		if (!_isRunning)
-		{
-			// attempt to add event and report success/failure
-			if (eventSLL_insert(&_eventQueue, event))
-			{
-				return CALENDAR_OKAY;
-			}
-			else
-			{
-				return CALENDAR_FULL;
-			}
-		}
+		rtcCalendarControl_getEpoch(seconds, millisecond);
+		_cachedEpoch = *seconds;
 
-		else
-		{
-			return CALENDAR_RUNNING;
-		}
+		return CALENDAR_OKAY;
 	}
 
-	// the calendar has not been initialized
+	// the module has not been initialized
 	else
 	{
 		return CALENDAR_NOT_INIT;
@@ -254,28 +484,31 @@ CalendarStatus calendar_addEvent(const struct CalendarEvent event)
 }
 
 
-/* calendar_peekEvent
+/* calendar_getCachedEpoch
  *
- * Gets info on the event at the provided index within the linked list.
- * Index from iterating across linkages, not index of array.
+ * Get the cached date/time as seconds since the start of the century.
  */
-CalendarStatus calendar_peekEvent(unsigned int id, CalendarEvent* const event)
+uint32_t calendar_getCachedEpoch(void)
 {
-	// if the calendar module has been initialized
+	return _cachedEpoch;
+}
+
+
+/* calendar_getTimeResolution
+ *
+ * Get the resolution of date/times and alarms from the RTC's sub-second counter.
+ */
+CalendarStatus calendar_getTimeResolution(uint32_t* const resolution_us)
+{
+	// if the module is initialized
 	if (_isInit)
 	{
-		if (eventSLL_peekIdx(&_eventQueue, id, event))
-		{
-			return CALENDAR_OKAY;
-		}
+		rtcCalendarControl_getResolution(resolution_us);
 
-		else
-		{
-			return CALENDAR_PARAMETER_ERROR;
-		}
+		return CALENDAR_OKAY;
 	}
 
-	// the module is not initialized
+	// the module has not been initialized
 	else
 	{
 		return CALENDAR_NOT_INIT;
@@ -283,36 +516,21 @@ CalendarStatus calendar_peekEvent(unsigned int id, CalendarEvent* const event)
 }
 
 
-/* calendar_removeEvent
+/* calendar_getHopWakeups
  *
- * Removes the event at the provided index within the linked list.
- * Index from iterating across linkages, not index of array.
+ * Get the number of hop alarms that have been reached.
  */
-CalendarStatus calendar_removeEvent(unsigned int id)
+CalendarStatus calendar_getHopWakeups(uint32_t* const count)
 {
-	// if the calendar module has been initialized
+	// if the module is initialized
 	if (_isInit)
 	{
-		// if the calendar is paused
-		if (!_isRunning)
-		{
-			if (eventSLL_remove(&_eventQueue, id))
-			{
-				return CALENDAR_OKAY;
-			}
-
-			else
-			{
-			return CALENDAR_PARAMETER_ERROR;
-			}
-		}
+		*count = _hopWakeups;
 
-		else
-		{
-			return CALENDAR_RUNNING;
-		}
+		return CALENDAR_OKAY;
 	}
 
+	// the module has not been initialized
 	else
 	{
 		return CALENDAR_NOT_INIT;
@@ -320,115 +538,1471 @@ CalendarStatus calendar_removeEvent(unsigned int id)
 }
 
 
-/* calendar_update
- *
- * Update loop.  Updates the state of the calendar (changing events) if the
- * RTC Alarm A has fired to signal an event change.
+/* calendar_getAlarmFaults
  *
- * Dependency on _update().
+ * Get the number of alarm interrupt storms recovered from and alarm updates where
+ * no armed alarm was reached.
+ */
+CalendarStatus calendar_getAlarmFaults(uint32_t* const storms, uint32_t* const mismatches)
+{
+	// if the module is initialized
+	if (_isInit)
+	{
+		*storms = _stormCount;
+		*mismatches = _mismatchCount;
+
+		return CALENDAR_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
+
+
+/* calendar_getLatency
  *
- * Note:
- * 	Will not run if the module has not been initialized and if the calendar
- * 	is not running.
+ * Get the latency estimate and last error of a latency class.
  */
-CalendarStatus calendar_updateScheduler(void)
+CalendarStatus calendar_getLatency(const uint8_t latencyClass, int32_t* const estimate,
+		int32_t* const lastError)
 {
-	// if the calendar module has been initialized
+	// if the module is initialized
 	if (_isInit)
 	{
-		// only update if the calendar is running
-		if (_isRunning)
+		if (latencyClass >= CALENDAR_LATENCY_CLASSES)
 		{
-			// only update if an alarm has fired
-			if (_alarmAFired) {
-				// update the calendar's state
-				_update();
+			return CALENDAR_PARAMETER_ERROR;
+		}
 
-				// reset alarm fired flag
-				_alarmAFired = false;
-			}
+		*estimate = _latencyEstimate[latencyClass];
+		*lastError = _latencyError[latencyClass];
 
-			return CALENDAR_OKAY;
-		}
+		return CALENDAR_OKAY;
+	}
 
-		// report that the calendar is paused
-		else
+	// the module has not been initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
+
+
+#ifdef CALENDAR_PROFILE_CALLBACKS
+/* calendar_getCallbackProfile
+ *
+ * Get the timing of an event's callbacks.
+ */
+CalendarStatus calendar_getCallbackProfile(unsigned int id, CallbackProfile* const profile)
+{
+	CalendarEvent event;
+
+	// if the module is initialized
+	if (_isInit)
+	{
+		// the ID must be of an event in the calendar
+		if (id >= MAX_NUM_EVENTS || !eventSLL_peekIdx(&_eventQueue, id, &event))
 		{
-			return CALENDAR_PAUSED;
+			return CALENDAR_PARAMETER_ERROR;
 		}
+
+		callbackProfiler_get(id, profile);
+
+		return CALENDAR_OKAY;
 	}
 
-	// the module is not initialized
+	// the module has not been initialized
 	else
 	{
 		return CALENDAR_NOT_INIT;
 	}
 }
+#endif
 
 
-/* calendar_AlarmA_ISR
+/* calendar_getLatencyHistogram
  *
- * RTC Alarm A interrupt service routine.  To only be called within the
- * RTC Alarm A ISR (HAL_RTC_AlarmAEventCallback()).
+ * Get a snapshot of the alarm to callback latency histogram.
  */
-void calendar_AlarmA_ISR(void)
+CalendarStatus calendar_getLatencyHistogram(CalendarLatencyHistogram* const histogram)
 {
-	// set flag that an alarm fired
-	_alarmAFired = true;
+	// if the module is initialized
+	if (_isInit)
+	{
+		*histogram = _latencyHistogram;
+
+		return CALENDAR_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
 }
 
 
-/* _update
- *
- * Update loop for module.  If an alarm to signal an event start/end has fired,
- * then this loop will call the callback functions for ending and starting events
- * appropriately.
+/* calendar_resetLatencyHistogram
  *
- * Also handles reseting the alarm for events that occur in a following month/year.
+ * Clear the alarm to callback latency histogram.
  */
-void _update(void)
+CalendarStatus calendar_resetLatencyHistogram(void)
 {
-	DateTime nextAlarm;
-	DateTime now;
-	int prevInProgress;
+	// if the module is initialized
+	if (_isInit)
+	{
+		memset(&_latencyHistogram, 0, sizeof(_latencyHistogram));
 
-	// get calendar alarm for next alarm in event list relative to now
-	rtcCalendarControl_getDateTime(&(now.year), &(now.month), &(now.day),
-			&(now.hour), &(now.minute), &(now.second));
+		return CALENDAR_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
 
-	// store the currently running event to test index to check if an
-	// event change has occurred
-	prevInProgress = _eventQueue.inProgress;
 
-	// if there is an alarm to set upon updating the events queue
-	if (eventSLL_getNextAlarm(&_eventQueue, now, &nextAlarm))
+/* calendar_getStats
+ *
+ * Get the scheduler's cumulative counters.
+ */
+CalendarStatus calendar_getStats(CalendarStats* const stats)
+{
+	// if the module is initialized
+	if (_isInit)
 	{
-		// set Alarm A
-		rtcCalendarControl_setAlarm_A(nextAlarm.day, nextAlarm.hour,
-				nextAlarm.minute, nextAlarm.second);
+		stats->updates = _updateCount;
+		stats->alarmsFired = _alarmFireCount;
+		stats->spuriousAlarms = _mismatchCount;
+		stats->storms = _stormCount;
+		stats->transitions = _transitionCount;
+		stats->skippedTransitions = _skippedCount;
+		stats->rearms = _rearmCount;
+		stats->maxUpdateCycles = _maxUpdateCycles;
+		stats->maxEvents = _maxEventCount;
+
+		return CALENDAR_OKAY;
 	}
 
-	// if there is no alarm to set, disable the alarm
+	// the module has not been initialized
 	else
 	{
-		rtcCalendarControl_diableAlarm_A();
+		return CALENDAR_NOT_INIT;
 	}
+}
 
-	// if exiting an event
-	if (_eventQueue.inProgress != prevInProgress
-			&& prevInProgress != EVENTS_SLL_NO_EVENT)
+
+/* calendar_getActiveTime
+ *
+ * Get how long an event has actually been active.
+ */
+CalendarStatus calendar_getActiveTime(unsigned int id, uint32_t* const seconds,
+		bool* const isActive)
+{
+	CalendarEvent event;
+	uint64_t millis;
+
+	// if the module is initialized
+	if (_isInit)
 	{
-		// call end event callback for exited event (if registered)
-		if (_eventQueue.events[prevInProgress].event.end_callback != NULL)
-			(*_eventQueue.events[prevInProgress].event.end_callback)();
+		// the ID must be of an event in the calendar
+		if (id >= MAX_NUM_EVENTS || !eventSLL_peekIdx(&_eventQueue, id, &event))
+		{
+			return CALENDAR_PARAMETER_ERROR;
+		}
+
+		millis = _activeMillis[id];
+		if ((int)id == _activeIdx)
+			millis += _activeSoFar();
+
+		*seconds = (uint32_t)(millis / 1000);
+		if (isActive != NULL)
+			*isActive = ((int)id == _activeIdx);
+
+		return CALENDAR_OKAY;
 	}
 
-	// if entering an event
-	if (_eventQueue.inProgress != EVENTS_SLL_NO_EVENT
-			&& _eventQueue.inProgress != prevInProgress)
+	// the module has not been initialized
+	else
 	{
-		// call start event callback for entered event (if registered)
-		if (_eventQueue.events[_eventQueue.inProgress].event.start_callback != NULL)
-			(*_eventQueue.events[_eventQueue.inProgress].event.start_callback)();
+		return CALENDAR_NOT_INIT;
 	}
 }
+
+
+/* calendar_getClassActiveTime
+ *
+ * Get how long the events of a latency class have actually been active.
+ */
+CalendarStatus calendar_getClassActiveTime(const uint8_t latencyClass, uint32_t* const seconds)
+{
+	uint64_t millis;
+
+	// if the module is initialized
+	if (_isInit)
+	{
+		if (latencyClass >= CALENDAR_LATENCY_CLASSES)
+		{
+			return CALENDAR_PARAMETER_ERROR;
+		}
+
+		millis = _classActiveMillis[latencyClass];
+		if (_activeIdx != EVENTS_SLL_NO_EVENT
+				&& _eventQueue.events[_activeIdx].event.latency_class == latencyClass)
+			millis += _activeSoFar();
+
+		*seconds = (uint32_t)(millis / 1000);
+
+		return CALENDAR_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
+
+
+/* calendar_addEvent
+ *
+ * Add an event to the calendar's event linked list.
+ */
+CalendarStatus calendar_addEvent(const struct CalendarEvent event)
+{
+	// add only if the calendar has been initialized
+	if (_isInit)
+	{
+		// if the calendar is paused
+		if (!_isRunning)
+		{
+			// attempt to add event and report success/failure
+			if (eventSLL_insert(&_eventQueue, event))
+			{
+				if (_eventQueue.count > _maxEventCount)
+					_maxEventCount = _eventQueue.count;
+
+				return CALENDAR_OKAY;
+			}
+			else
+			{
+				return CALENDAR_FULL;
+			}
+		}
+
+		else
+		{
+			return CALENDAR_RUNNING;
+		}
+	}
+
+	// the calendar has not been initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
+
+
+/* calendar_addTrigger
+ *
+ * Add a trigger to the calendar's event linked list, an event with the same start
+ * and end.
+ */
+CalendarStatus calendar_addTrigger(const DateTime at, void (*callback)(void))
+{
+	CalendarEvent trigger = {.start = at, .end = at, .start_callback = callback};
+
+	return calendar_addEvent(trigger);
+}
+
+
+/* calendar_peekEvent
+ *
+ * Gets info on the event at the provided index within the linked list.
+ * Index from iterating across linkages, not index of array.
+ */
+CalendarStatus calendar_peekEvent(unsigned int id, CalendarEvent* const event)
+{
+	// if the calendar module has been initialized
+	if (_isInit)
+	{
+		if (eventSLL_peekIdx(&_eventQueue, id, event))
+		{
+			return CALENDAR_OKAY;
+		}
+
+		else
+		{
+			return CALENDAR_PARAMETER_ERROR;
+		}
+	}
+
+	// the module is not initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
+
+
+/* calendar_removeEvent
+ *
+ * Removes the event at the provided index within the linked list.
+ * Index from iterating across linkages, not index of array.
+ */
+CalendarStatus calendar_removeEvent(unsigned int id)
+{
+	// if the calendar module has been initialized
+	if (_isInit)
+	{
+		// if the calendar is paused
+		if (!_isRunning)
+		{
+			// end the active time of the event, its end callback will not run
+			if ((int)id == _activeIdx)
+				_exitActive(_cachedEpoch, 0);
+
+			if (eventSLL_remove(&_eventQueue, id))
+			{
+				_activeMillis[id] = 0;
+#ifdef CALENDAR_PROFILE_CALLBACKS
+				callbackProfiler_clear(id);
+#endif
+				return CALENDAR_OKAY;
+			}
+
+			else
+			{
+			return CALENDAR_PARAMETER_ERROR;
+			}
+		}
+
+		else
+		{
+			return CALENDAR_RUNNING;
+		}
+	}
+
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
+
+
+/* calendar_update
+ *
+ * Update loop.  Updates the state of the calendar (changing events) if the
+ * RTC Alarm A has fired to signal an event change.
+ *
+ * Dependency on _update().
+ *
+ * Note:
+ * 	Will not run if the module has not been initialized and if the calendar
+ * 	is not running.
+ */
+CalendarStatus calendar_updateScheduler(void)
+{
+	return _updateScheduler(ALL_TRANSITIONS);
+}
+
+
+/* calendar_updateSchedulerBounded
+ *
+ * Update loop that runs at most a number of passed transitions per call, leaving
+ * the rest for the next call.
+ */
+CalendarStatus calendar_updateSchedulerBounded(const unsigned int maxTransitions,
+		bool* const isPending)
+{
+	CalendarStatus status;
+
+	// at least one transition must be run for the update to progress
+	if (maxTransitions == 0)
+	{
+		return CALENDAR_PARAMETER_ERROR;
+	}
+
+	status = _updateScheduler(maxTransitions);
+
+	if (isPending != NULL)
+		*isPending = _isReplaying;
+
+	return status;
+}
+
+
+/* _updateScheduler
+ *
+ * Updates the state of the calendar if an alarm has fired or an update is due,
+ * running at most a number of passed transitions.
+ */
+CalendarStatus _updateScheduler(const unsigned int maxTransitions)
+{
+	uint32_t fires;
+
+	// if the calendar module has been initialized
+	if (_isInit)
+	{
+		// only update if the calendar is running
+		if (_isRunning)
+		{
+			// take the alarms fired so far, an alarm firing during the update is
+			// left pending for the next update
+			fires = _takePendingFires();
+
+			// only update if an alarm has fired or an update is due
+			if (fires > 0 || _isUpdateDue)
+			{
+				_isUpdateDue = false;
+
+				// recover from an alarm interrupt storm, the alarms are re-armed
+				// from a disarmed state by the update
+				if (_isStormMasked)
+				{
+					_recoverFromStorm();
+					fires = 0;
+				}
+
+				// update the calendar's state
+				// if the RTC alarms could not be armed, retry on the next update
+				if (!_update(fires > 0, maxTransitions))
+				{
+					_isUpdateDue = true;
+					return CALENDAR_RTC_ERROR;
+				}
+			}
+
+			return CALENDAR_OKAY;
+		}
+
+		// report that the calendar is paused
+		else
+		{
+			return CALENDAR_PAUSED;
+		}
+	}
+
+	// the module is not initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
+
+
+/* calendar_AlarmA_ISR
+ *
+ * RTC Alarm A interrupt service routine.  To only be called within the
+ * RTC Alarm A ISR (HAL_RTC_AlarmAEventCallback()).
+ */
+void calendar_AlarmA_ISR(void)
+{
+	RtcTimestamp timestamp;
+
+	// set flag that an alarm fired, and record when
+	_alarmFired();
+	if (rtcCalendarControl_captureTimestamp(&timestamp) == RTC_CALENDAR_CONTROL_OKAY)
+		_stampAlarm(&timestamp);
+	TRACE(CALENDAR_TRACE_ALARM_FIRED, ALARM_A);
+	_rearmFromLookahead(ALARM_A);
+}
+
+
+/* calendar_AlarmB_ISR
+ *
+ * RTC Alarm B interrupt service routine.  To only be called within the
+ * RTC Alarm B ISR (HAL_RTCEx_AlarmBEventCallback()).
+ */
+void calendar_AlarmB_ISR(void)
+{
+	RtcTimestamp timestamp;
+
+	// set flag that an alarm fired, and record when
+	_alarmFired();
+	if (rtcCalendarControl_captureTimestamp(&timestamp) == RTC_CALENDAR_CONTROL_OKAY)
+		_stampAlarm(&timestamp);
+	TRACE(CALENDAR_TRACE_ALARM_FIRED, ALARM_B);
+	_rearmFromLookahead(ALARM_B);
+}
+
+
+/* calendar_RTC_IRQHandler
+ *
+ * RTC alarm interrupt entry.  To only be called within the RTC alarm interrupt
+ * (RTC_LSECSS_IRQHandler()).  Clears the fired alarms and signals the scheduler
+ * before anything else, without the HAL's dispatch.  Other sources pending with
+ * them are handed to the HAL handler that clears them, or the interrupt would be
+ * taken again as soon as it returns.
+ */
+void calendar_RTC_IRQHandler(RTC_HandleTypeDef* const hrtc)
+{
+	RtcTimestamp timestamp;
+	uint32_t fired;
+	uint32_t pending;
+
+	// clear fired alarms and set flag that an alarm fired, then record when
+	fired = rtcAlarmDriver_clearFired(hrtc, &pending);
+	if (fired != 0U)
+	{
+		_alarmFired();
+		if (rtcCalendarControl_captureTimestamp(&timestamp) == RTC_CALENDAR_CONTROL_OKAY)
+			_stampAlarm(&timestamp);
+
+		// re-arm the fired alarms with the transitions after the armed ones
+		if (fired & RTC_MISR_ALRAMF)
+		{
+			TRACE(CALENDAR_TRACE_ALARM_FIRED, ALARM_A);
+			_rearmFromLookahead(ALARM_A);
+		}
+		if (fired & RTC_MISR_ALRBMF)
+		{
+			TRACE(CALENDAR_TRACE_ALARM_FIRED, ALARM_B);
+			_rearmFromLookahead(ALARM_B);
+		}
+	}
+
+#ifdef CORE_CM0PLUS
+	// hand the other sources pending with the alarms to the HAL handler that
+	// clears them, they share the interrupt on the Cortex-M0+ only.  A source
+	// flagged after the read takes the interrupt again
+	if (pending & RTC_MISR_WUTMF)
+		HAL_RTCEx_WakeUpTimerIRQHandler(hrtc);
+	if (pending & (RTC_MISR_TSMF | RTC_MISR_TSOVMF | RTC_MISR_ITSMF))
+		HAL_RTCEx_TimeStampIRQHandler(hrtc);
+	if (pending & RTC_MISR_SSRUMF)
+		HAL_RTCEx_SSRUIRQHandler(hrtc);
+
+	// tamper events are flagged in the tamper block, only read when the RTC had
+	// nothing pending
+	if (fired == 0U && pending == 0U && READ_REG(TAMP->MISR) != 0U)
+		HAL_RTCEx_TamperIRQHandler(hrtc);
+#else
+	(void)pending;
+#endif
+}
+
+
+/* calendar_getLastAlarmTime
+ *
+ * Get the time of the last alarm handled by the alarm interrupt.  Copies the
+ * captured registers again if an alarm was handled while copying.
+ */
+CalendarStatus calendar_getLastAlarmTime(uint32_t* const seconds, uint16_t* const millisecond)
+{
+	RtcTimestamp timestamp;
+	uint32_t count;
+
+	// if the module is initialized
+	if (_isInit)
+	{
+		// copy the registers consistently with the interrupt
+		do
+		{
+			count = _alarmIrqCount;
+			timestamp = _alarmTimestamp;
+		} while (count != _alarmIrqCount);
+
+		// no alarm has been handled
+		if (count == 0)
+		{
+			return CALENDAR_PARAMETER_ERROR;
+		}
+
+		rtcCalendarControl_timestampToEpoch(&timestamp, seconds, millisecond);
+
+		return CALENDAR_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return CALENDAR_NOT_INIT;
+	}
+}
+
+
+/* calendar_secondTick_ISR
+ *
+ * Once per second interrupt service routine.  Refreshes the cached date/time.
+ */
+void calendar_secondTick_ISR(void)
+{
+	uint32_t seconds;
+
+	if (_isInit && rtcCalendarControl_getEpoch(&seconds, NULL) == RTC_CALENDAR_CONTROL_OKAY)
+		_cachedEpoch = seconds;
+}
+
+
+/* _update
+ *
+ * Update loop for module.  If an alarm to signal an event start/end has fired,
+ * then this loop will call the callback functions for ending and starting events
+ * appropriately.
+ *
+ * The next two transitions are kept armed at once on Alarm A and Alarm B so that
+ * the transition following the one that fired is already armed while this runs.
+ *
+ * Transitions too far away for the RTC to fire directly are reached through hop
+ * alarms planned by the RTC Calendar Control, each re-planned from here when it
+ * is reached.
+ *
+ * The RTC only fires an alarm on an exact match, so the next alarm is checked
+ * against the time after it is armed.  If it was reached while being armed it
+ * will not fire, and the fired flag is set so that the next update processes it.
+ *
+ * The transitions after the two armed alarms are encoded into the lookahead so
+ * that the alarm interrupt can re-arm the alarm that fired on its own.  The alarms
+ * and lookahead are updated with interrupts disabled, since the interrupt also
+ * changes them.
+ *
+ * Every transition between the last update and now is run in order, so that an
+ * event that started and ended between updates still has its callbacks called.
+ * Transitions at the same instant are run in one pass, ending an event before
+ * starting the next.  At most maxTransitions are run, the update then resumes
+ * after the last of them on the next call.
+ *
+ * An update from an alarm where no armed alarm has been reached means the alarm
+ * registers do not hold what was armed, both alarms are then disarmed so that
+ * they are re-armed from a known state.
+ *
+ * Returns false if the RTC alarms could not be armed.
+ */
+bool _update(const bool isFromAlarm, const unsigned int maxTransitions)
+{
+	DateTime nextAlarm;
+	DateTime followingAlarm;
+	DateTime plannedAlarm;
+	DateTime armedAlarm;
+	DateTime transition;
+	DateTime now;
+	DateTime resumeAt;
+	uint8_t latencyClass;
+	bool isDispatched;
+	bool isMeasured;
+	uint32_t nowSeconds;
+	uint16_t nowMillisecond;
+	int prevInProgress;
+	int alarmIdx;
+	bool hasNext;
+	bool hasFollowing;
+	bool nextIsHop = false;
+	bool isArmed;
+	bool isAnyReached = false;
+	LookaheadEntry lookahead[LOOKAHEAD_SIZE];
+	int lookaheadCount;
+	uint32_t primask;
+	uint32_t startCycles = callbackProfiler_readCycles();
+	uint32_t cycles;
+
+	// get calendar alarm for next alarm in event list relative to now
+	// read now once as seconds, which also refreshes the cached date and time
+	rtcCalendarControl_getEpoch(&nowSeconds, &nowMillisecond);
+	_cachedEpoch = nowSeconds;
+	dateTime_fromSeconds(nowSeconds, &now);
+	now.millisecond = nowMillisecond;
+
+	// a transition due within the latency estimate of its class was armed that
+	// much early, run it now, as well as one whose compensated alarm would be too
+	// soon to arm.  Uncompensated transitions only run once reached
+	if (eventSLL_peekNextAlarm(&_eventQueue, now, &transition)
+			&& eventSLL_getLatencyClass(&_eventQueue, transition, &latencyClass)
+			&& latencyClass != CALENDAR_LATENCY_UNCOMPENSATED
+			&& latencyClass < CALENDAR_LATENCY_CLASSES
+			&& dateTime_millisBetween(now, transition)
+					<= _latencyEstimate[latencyClass] + ALARM_MIN_LEAD_MS)
+		now = transition;
+
+	// an update from an alarm that runs a transition dispatches callbacks, measure
+	// the latency of the first transition unless it was moved by slack
+	isDispatched = isFromAlarm && _hasLastUpdate
+			&& eventSLL_peekNextAlarm(&_eventQueue, _lastUpdate, &transition)
+			&& _isReached(now, transition);
+	isMeasured = isDispatched && eventSLL_getSlack(&_eventQueue, transition) == 0;
+
+	// store the currently running event to test index to check if an
+	// event change has occurred, resuming from the last transition a bounded
+	// update ran
+	prevInProgress = _isReplaying ? _replayInProgress : _eventQueue.inProgress;
+
+	// find the next alarm, and plan a hop to it if it is too far away
+	// the next alarm is moved later within the slack of the transitions to share
+	// a wakeup
+	hasNext = eventSLL_getNextAlarm(&_eventQueue, now, &nextAlarm);
+	if (hasNext)
+	{
+		_applySlack(&nextAlarm);
+		armedAlarm = nextAlarm;
+		_compensate(now, &armedAlarm);
+		nextIsHop = !rtcCalendarControl_planAlarm(now, armedAlarm, &plannedAlarm);
+	}
+
+	// find the alarm following the next alarm
+	// the following alarm is only armed if the RTC cannot fire it before it is due,
+	// otherwise it is left to be armed on a later update
+	hasFollowing = hasNext && !nextIsHop
+			&& _nextWakeup(nextAlarm, &followingAlarm);
+	if (hasFollowing)
+	{
+		armedAlarm = followingAlarm;
+		_compensate(now, &armedAlarm);
+		hasFollowing = rtcCalendarControl_isAlarmDirect(now, armedAlarm);
+	}
+
+	// encode the transitions after the following alarm
+	lookaheadCount = hasFollowing ? _fillLookahead(now, followingAlarm, lookahead) : 0;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	// count hop alarms that have been reached, an alarm re-armed from interrupt
+	// was reached if the transition it replaced was
+	isAnyReached = _isRearmed && _isReached(now, _rearmedAlarm);
+	_isRearmed = false;
+	for (alarmIdx = 0; alarmIdx < NUM_ALARMS; alarmIdx++)
+	{
+		if (_isArmed[alarmIdx] && _isReached(now, _armedAlarms[alarmIdx]))
+		{
+			isAnyReached = true;
+
+			if (_isHop[alarmIdx])
+			{
+				_hopWakeups++;
+				_isHop[alarmIdx] = false;
+			}
+		}
+	}
+
+	// an alarm fired that was not armed, re-arm both from a known state
+	if (isFromAlarm && !isAnyReached)
+	{
+		_mismatchCount++;
+		TRACE(CALENDAR_TRACE_MISMATCH, 0);
+		_disarmAlarms();
+	}
+
+	// arm (or disarm) Alarm A and Alarm B
+	isArmed = _armAlarms(hasNext ? &plannedAlarm : NULL, nextIsHop,
+			hasFollowing ? &armedAlarm : NULL);
+
+	// replace the lookahead
+	memcpy(_lookahead, lookahead, sizeof(LookaheadEntry) * lookaheadCount);
+	_lookaheadHead = 0;
+	_lookaheadCount = lookaheadCount;
+
+	__set_PRIMASK(primask);
+
+	// if the next alarm passed while it was armed, process it on the next update
+	if (hasNext && _isPassed(plannedAlarm))
+		_isUpdateDue = true;
+
+	if (isMeasured)
+		_measureLatency(transition);
+	if (isDispatched)
+		_recordDispatch();
+
+	// run the transitions passed since the last update, then into the event in
+	// progress now
+	// if the limit was reached, resume after the last transition run
+	resumeAt = now;
+	_isReplaying = _hasLastUpdate
+			&& _runPassedTransitions(&prevInProgress, now, maxTransitions, &resumeAt);
+	if (_isReplaying)
+	{
+		_replayInProgress = prevInProgress;
+		_isUpdateDue = true;
+	}
+	else
+	{
+		_runTransition(prevInProgress, _eventQueue.inProgress, now);
+	}
+
+	_lastUpdate = _isReplaying ? resumeAt : now;
+	_hasLastUpdate = true;
+
+	_updateCount++;
+	cycles = callbackProfiler_readCycles() - startCycles;
+	if (cycles > _maxUpdateCycles)
+		_maxUpdateCycles = cycles;
+
+	return isArmed;
+}
+
+
+/* _runPassedTransitions
+ *
+ * Runs the transitions from the last update up to and including now, in order,
+ * up to maxTransitions of them.  At each, events are ended and started, then
+ * triggers are run, then events are prepared.  Updates exited to the event in
+ * progress after the last of them.  Returns true if the limit was reached with
+ * transitions left, resumeAt is then set to the last transition run.
+ */
+bool _runPassedTransitions(int* const exited, const DateTime now,
+		const unsigned int maxTransitions, DateTime* const resumeAt)
+{
+	DateTime transition = _lastUpdate;
+	unsigned int count = 0;
+	int entered;
+
+	while (eventSLL_peekNextAlarm(&_eventQueue, transition, &transition)
+			&& _isReached(now, transition))
+	{
+		if (count == maxTransitions)
+			return true;
+
+		entered = eventSLL_peekInProgress(&_eventQueue, transition);
+		_runTransition(*exited, entered, now);
+		_runTriggers(transition);
+		_runPrepares(transition);
+		*exited = entered;
+
+		*resumeAt = transition;
+		count++;
+	}
+
+	return false;
+}
+
+
+/* _countPassedTransitions
+ *
+ * Counts the transitions from the last update up to and including now.
+ */
+uint32_t _countPassedTransitions(const DateTime now)
+{
+	DateTime transition = _lastUpdate;
+	uint32_t count = 0;
+
+	while (eventSLL_peekNextAlarm(&_eventQueue, transition, &transition)
+			&& _isReached(now, transition))
+		count++;
+
+	return count;
+}
+
+
+/* _runTransition
+ *
+ * Calls the end callback of the exited event, then the start callback of the
+ * entered event, if they are different events.  The active time of the events
+ * is ended and started at the date and time the callbacks run.
+ */
+void _runTransition(const int exited, const int entered, const DateTime at)
+{
+	uint32_t seconds;
+
+	// no event change
+	if (exited == entered)
+		return;
+
+	_transitionCount++;
+	seconds = dateTime_toSeconds(at);
+
+	// call end event callback for exited event (if registered)
+	if (exited != EVENTS_SLL_NO_EVENT)
+	{
+		TRACE(CALENDAR_TRACE_EVENT_EXITED, exited);
+		if (exited == _activeIdx)
+			_exitActive(seconds, at.millisecond);
+		if (_eventQueue.events[exited].event.end_callback != NULL)
+			RUN_CALLBACK(exited, _eventQueue.events[exited].event.end_callback);
+	}
+
+	// call start event callback for entered event (if registered)
+	if (entered != EVENTS_SLL_NO_EVENT)
+	{
+		TRACE(CALENDAR_TRACE_EVENT_ENTERED, entered);
+		_enterActive(entered, seconds, at.millisecond);
+		if (_eventQueue.events[entered].event.start_callback != NULL)
+			RUN_CALLBACK(entered, _eventQueue.events[entered].event.start_callback);
+	}
+}
+
+
+/* _enterActive
+ *
+ * Starts the active time of an event, ending that of an event still active.
+ */
+void _enterActive(const int idx, const uint32_t seconds, const uint16_t millisecond)
+{
+	if (_activeIdx != EVENTS_SLL_NO_EVENT)
+		_exitActive(seconds, millisecond);
+
+	_activeIdx = idx;
+	_activeSeconds = seconds;
+	_activeMillisecond = millisecond;
+}
+
+
+/* _exitActive
+ *
+ * Ends the active time of the active event, adding it to the event and its class.
+ */
+void _exitActive(const uint32_t seconds, const uint16_t millisecond)
+{
+	int64_t millis = (((int64_t)seconds - _activeSeconds) * 1000) + millisecond - _activeMillisecond;
+	uint8_t latencyClass = _eventQueue.events[_activeIdx].event.latency_class;
+
+	// the time was set back while the event was active
+	if (millis < 0)
+		millis = 0;
+
+	_activeMillis[_activeIdx] += (uint64_t)millis;
+	if (latencyClass < CALENDAR_LATENCY_CLASSES)
+		_classActiveMillis[latencyClass] += (uint64_t)millis;
+
+	_activeIdx = EVENTS_SLL_NO_EVENT;
+}
+
+
+/* _activeSoFar
+ *
+ * Gets the time the active event has been active so far, to the cached date and
+ * time.
+ */
+uint64_t _activeSoFar(void)
+{
+	int64_t millis = (((int64_t)_cachedEpoch - _activeSeconds) * 1000) - _activeMillisecond;
+
+	return (millis < 0) ? 0 : (uint64_t)millis;
+}
+
+
+/* _runTriggers
+ *
+ * Calls the callbacks of the triggers at a date and time, in the order they were
+ * added.
+ */
+void _runTriggers(const DateTime at)
+{
+	int idx = EVENTS_SLL_NO_EVENT;
+
+	while (eventSLL_nextTrigger(&_eventQueue, at, &idx))
+	{
+		TRACE(CALENDAR_TRACE_TRIGGER, idx);
+		_transitionCount++;
+		if (_eventQueue.events[idx].event.start_callback != NULL)
+			RUN_CALLBACK(idx, _eventQueue.events[idx].event.start_callback);
+	}
+}
+
+
+/* _runPrepares
+ *
+ * Calls the prepare callbacks of the events prepared at a date and time, in list
+ * order.
+ */
+void _runPrepares(const DateTime at)
+{
+	int idx = EVENTS_SLL_NO_EVENT;
+
+	while (eventSLL_nextPrepare(&_eventQueue, at, &idx))
+	{
+		TRACE(CALENDAR_TRACE_PREPARE, idx);
+		_transitionCount++;
+		RUN_CALLBACK(idx, _eventQueue.events[idx].event.prepare_callback);
+	}
+}
+
+
+/* _alarmFired
+ *
+ * Signals that an alarm has fired, from interrupt.  Masks the RTC alarm interrupt
+ * if it fires more often than the armed alarms can, so that an interrupt storm
+ * cannot starve the main loop.  The interrupt is unmasked by the next update.
+ */
+void _alarmFired(void)
+{
+	_alarmFireCount++;
+
+	if (++_pendingFires > STORM_FIRES)
+	{
+		HAL_NVIC_DisableIRQ(CALENDAR_RTC_IRQn);
+		_isStormMasked = true;
+		TRACE(CALENDAR_TRACE_STORM, _pendingFires);
+	}
+}
+
+
+/* _takePendingFires
+ *
+ * Takes the number of alarms fired since the last call, resetting it to zero in
+ * one step with the alarm interrupt.  Uses exclusive access on cores that have it
+ * (Cortex-M3 and up), and masks interrupts for the exchange otherwise (Cortex-M0+).
+ */
+uint32_t _takePendingFires(void)
+{
+	uint32_t fires;
+
+#if (__CORTEX_M >= 3U)
+	// an interrupt between the load and store clears the exclusive monitor, the
+	// store then fails and the exchange is retried
+	do
+	{
+		fires = __LDREXW(&_pendingFires);
+	} while (__STREXW(0U, &_pendingFires) != 0U);
+#else
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	fires = _pendingFires;
+	_pendingFires = 0U;
+	__set_PRIMASK(primask);
+#endif
+
+	return fires;
+}
+
+
+/* _recoverFromStorm
+ *
+ * Recovers from an alarm interrupt storm.  Disarms both alarms, clearing their
+ * flags, before unmasking the RTC alarm interrupt.  The alarms are then re-armed
+ * by the update.
+ */
+void _recoverFromStorm(void)
+{
+	_stormCount++;
+
+	_disarmAlarms();
+
+	_isStormMasked = false;
+	HAL_NVIC_ClearPendingIRQ(CALENDAR_RTC_IRQn);
+	HAL_NVIC_EnableIRQ(CALENDAR_RTC_IRQn);
+}
+
+
+/* _disarmAlarms
+ *
+ * Disarms both RTC alarms regardless of what they are marked as armed with.
+ */
+void _disarmAlarms(void)
+{
+	rtcCalendarControl_diableAlarm_A();
+	rtcCalendarControl_diableAlarm_B();
+	TRACE(CALENDAR_TRACE_ALARM_DISARMED, ALARM_A);
+	TRACE(CALENDAR_TRACE_ALARM_DISARMED, ALARM_B);
+
+	_isArmed[ALARM_A] = false;
+	_isArmed[ALARM_B] = false;
+	_isHop[ALARM_A] = false;
+	_isHop[ALARM_B] = false;
+}
+
+
+/* _resetStats
+ *
+ * Zeroes the scheduler's statistics and alarm fault counters.
+ */
+void _resetStats(void)
+{
+	_hopWakeups = 0;
+	_stormCount = 0;
+	_mismatchCount = 0;
+	_updateCount = 0;
+	_alarmFireCount = 0;
+	_transitionCount = 0;
+	_skippedCount = 0;
+	_rearmCount = 0;
+	_maxUpdateCycles = 0;
+	_maxEventCount = 0;
+}
+
+
+/* _fillLookahead
+ *
+ * Encodes the transitions after a date and time that the RTC can fire directly,
+ * up to LOOKAHEAD_SIZE of them.  Returns the number encoded.  Each is compensated
+ * from the transition before it, as it is re-armed when that one fires.
+ */
+int _fillLookahead(const DateTime now, DateTime after, LookaheadEntry* const entries)
+{
+	DateTime wakeup;
+	DateTime alarm;
+	int count = 0;
+
+	while (count < LOOKAHEAD_SIZE && _nextWakeup(after, &wakeup))
+	{
+		alarm = wakeup;
+		_compensate(after, &alarm);
+
+		if (!rtcCalendarControl_isAlarmDirect(now, alarm)
+				|| rtcCalendarControl_encodeAlarm(alarm, &entries[count].regs)
+						!= RTC_CALENDAR_CONTROL_OKAY)
+			break;
+
+		entries[count].alarm = alarm;
+		after = wakeup;
+		count++;
+	}
+
+	return count;
+}
+
+
+/* _nextWakeup
+ *
+ * Finds the wakeup for the transitions after a date and time, the next transition
+ * moved later within the slack of the transitions.  Returns false if there are no
+ * transitions after it.
+ */
+bool _nextWakeup(const DateTime after, DateTime* const wakeup)
+{
+	if (!eventSLL_peekNextAlarm(&_eventQueue, after, wakeup))
+		return false;
+
+	_applySlack(wakeup);
+
+	return true;
+}
+
+
+/* _applySlack
+ *
+ * Moves a transition later to the latest date and time that is within the slack
+ * of it and of every transition up to that date and time.  All of them then share
+ * one wakeup.  Transitions without slack are not moved.
+ */
+void _applySlack(DateTime* const wakeup)
+{
+	DateTime transition = *wakeup;
+	DateTime latest;
+	DateTime candidate;
+	uint16_t slack;
+
+	slack = eventSLL_getSlack(&_eventQueue, transition);
+	if (slack == 0)
+		return;
+
+	latest = transition;
+	dateTime_addMillis(&latest, (int32_t)slack * 1000);
+
+	// bring in the transitions due by the latest wakeup, limiting it by their slack
+	while (eventSLL_peekNextAlarm(&_eventQueue, transition, &transition)
+			&& _isReached(latest, transition))
+	{
+		slack = eventSLL_getSlack(&_eventQueue, transition);
+		candidate = transition;
+		dateTime_addMillis(&candidate, (int32_t)slack * 1000);
+
+		if (!_isReached(candidate, latest))
+			latest = candidate;
+	}
+
+	*wakeup = latest;
+}
+
+
+/* _compensate
+ *
+ * Moves the alarm for a transition earlier by the latency estimate of its class,
+ * so that its callbacks run on the transition.  Wakeups that are not at a
+ * transition, moved by slack, are not compensated, nor are transitions of the
+ * uncompensated class.  An alarm is not moved earlier than ALARM_MIN_LEAD_MS
+ * after now, since the RTC would not fire it.
+ */
+void _compensate(const DateTime now, DateTime* const wakeup)
+{
+	DateTime earliest = now;
+	uint8_t latencyClass;
+
+	if (eventSLL_getLatencyClass(&_eventQueue, *wakeup, &latencyClass)
+			&& latencyClass != CALENDAR_LATENCY_UNCOMPENSATED
+			&& latencyClass < CALENDAR_LATENCY_CLASSES)
+	{
+		dateTime_addMillis(wakeup, -_latencyEstimate[latencyClass]);
+
+		dateTime_addMillis(&earliest, ALARM_MIN_LEAD_MS);
+		if (!_isReached(*wakeup, earliest))
+			*wakeup = earliest;
+	}
+}
+
+
+/* _measureLatency
+ *
+ * Measures the error between now, as callbacks are about to run, and a transition,
+ * and folds it into the latency estimate of the transition's class.  The estimate
+ * of the uncompensated class stays 0.
+ */
+void _measureLatency(const DateTime transition)
+{
+	DateTime now;
+	uint32_t nowSeconds;
+	uint16_t nowMillisecond;
+	uint8_t latencyClass;
+	int32_t estimate;
+
+	if (!eventSLL_getLatencyClass(&_eventQueue, transition, &latencyClass)
+			|| latencyClass >= CALENDAR_LATENCY_CLASSES
+			|| rtcCalendarControl_getEpoch(&nowSeconds, &nowMillisecond)
+					!= RTC_CALENDAR_CONTROL_OKAY)
+		return;
+
+	dateTime_fromSeconds(nowSeconds, &now);
+	now.millisecond = nowMillisecond;
+
+	_latencyError[latencyClass] = dateTime_millisBetween(transition, now);
+	if (latencyClass == CALENDAR_LATENCY_UNCOMPENSATED)
+		return;
+
+	estimate = _latencyEstimate[latencyClass] + (_latencyError[latencyClass] / LATENCY_GAIN);
+	if (estimate < 0)
+		estimate = 0;
+	if (estimate > LATENCY_MAX_MS)
+		estimate = LATENCY_MAX_MS;
+	_latencyEstimate[latencyClass] = estimate;
+}
+
+
+/* _stampAlarm
+ *
+ * Records the RTC's registers captured when an alarm fired, from interrupt.
+ */
+void _stampAlarm(const RtcTimestamp* const timestamp)
+{
+	_alarmTimestamp = *timestamp;
+	_alarmIrqCount++;
+}
+
+
+/* _recordDispatch
+ *
+ * Adds the latency between the last alarm firing and now, as its callbacks are
+ * about to run, to the latency histogram.  Each alarm is recorded once.
+ */
+void _recordDispatch(void)
+{
+	RtcTimestamp timestamp;
+	uint32_t count;
+	uint32_t firedSeconds;
+	uint16_t firedMillisecond;
+	uint32_t nowSeconds;
+	uint16_t nowMillisecond;
+	int64_t latency;
+	uint32_t millis;
+	int bucket;
+
+	// copy the registers consistently with the interrupt
+	do
+	{
+		count = _alarmIrqCount;
+		timestamp = _alarmTimestamp;
+	} while (count != _alarmIrqCount);
+
+	// the alarm was already recorded, or was not timestamped
+	if (count == _dispatchedIrqCount)
+		return;
+	_dispatchedIrqCount = count;
+
+	if (rtcCalendarControl_timestampToEpoch(&timestamp, &firedSeconds, &firedMillisecond)
+					!= RTC_CALENDAR_CONTROL_OKAY
+			|| rtcCalendarControl_getEpoch(&nowSeconds, &nowMillisecond)
+					!= RTC_CALENDAR_CONTROL_OKAY)
+		return;
+
+	latency = (((int64_t)nowSeconds - firedSeconds) * 1000) + nowMillisecond - firedMillisecond;
+	if (latency < 0)
+		latency = 0;
+	if (latency > UINT32_MAX)
+		latency = UINT32_MAX;
+	millis = (uint32_t)latency;
+
+	// bucket n holds latencies under 2^(n + 1) ms
+	for (bucket = 0; bucket < CALENDAR_LATENCY_BUCKETS - 1 && millis >= (2U << bucket); bucket++);
+
+	_latencyHistogram.buckets[bucket]++;
+	_latencyHistogram.count++;
+	if (millis > _latencyHistogram.maxMillis)
+		_latencyHistogram.maxMillis = millis;
+}
+
+
+/* _rearmFromLookahead
+ *
+ * Re-arms an alarm that fired with the next transition in the lookahead, from
+ * interrupt.  Only an alarm armed with a transition is re-armed, hops are
+ * re-planned by the update.  A transition due within ALARM_MIN_LEAD_MS of the
+ * alarm that fired may be past by the time it is written, and is left to the
+ * update.  The update is still signalled to run callbacks and refill the
+ * lookahead.
+ */
+void _rearmFromLookahead(const int alarmIdx)
+{
+	const LookaheadEntry* entry;
+	DateTime earliest;
+	RtcUtilsStatus status;
+
+	if (!_isRunning || _lookaheadCount == 0 || !_isArmed[alarmIdx] || _isHop[alarmIdx])
+		return;
+
+	entry = &_lookahead[_lookaheadHead];
+	earliest = _armedAlarms[alarmIdx];
+	dateTime_addMillis(&earliest, ALARM_MIN_LEAD_MS);
+	if (!_isReached(entry->alarm, earliest))
+		return;
+	if (alarmIdx == ALARM_A)
+		status = rtcCalendarControl_armEncoded_A(&entry->regs);
+	else
+		status = rtcCalendarControl_armEncoded_B(&entry->regs);
+
+	_rearmedAlarm = _armedAlarms[alarmIdx];
+	_isRearmed = true;
+	_armedAlarms[alarmIdx] = entry->alarm;
+	_isArmed[alarmIdx] = (status == RTC_CALENDAR_CONTROL_OKAY);
+	TRACE(CALENDAR_TRACE_ALARM_REARMED, alarmIdx);
+	_rearmCount++;
+
+	_lookaheadHead = (_lookaheadHead + 1) % LOOKAHEAD_SIZE;
+	_lookaheadCount--;
+}
+
+
+/* _armAlarms
+ *
+ * Arms the next alarm and the alarm following it across Alarm A and Alarm B.  An
+ * alarm already armed with the next alarm is left untouched so that it cannot be
+ * missed while the other alarm is being armed.  Passing NULL disarms.  Returns
+ * false if either alarm could not be armed.
+ */
+bool _armAlarms(const DateTime* const nextAlarm, const bool nextIsHop,
+		const DateTime* const followingAlarm)
+{
+	int nextIdx;
+	bool isArmed;
+
+	// no next alarm, nothing to arm
+	if (nextAlarm == NULL)
+	{
+		return _armAlarm(ALARM_A, NULL, false) & _armAlarm(ALARM_B, NULL, false);
+	}
+
+	// find the alarm already armed with the next alarm, if any
+	if (_isArmedWith(ALARM_A, nextAlarm))
+	{
+		nextIdx = ALARM_A;
+	}
+	else if (_isArmedWith(ALARM_B, nextAlarm))
+	{
+		nextIdx = ALARM_B;
+	}
+	else
+	{
+		nextIdx = ALARM_A;
+	}
+	isArmed = _armAlarm(nextIdx, nextAlarm, nextIsHop);
+
+	// arm the other alarm with the following alarm
+	isArmed &= _armAlarm((nextIdx == ALARM_A) ? ALARM_B : ALARM_A, followingAlarm, false);
+
+	return isArmed;
+}
+
+
+/* _armAlarm
+ *
+ * Arms one of the RTC alarms with the day and time of an alarm, or disarms it if
+ * NULL is passed.  Skips the RTC if the alarm is already in that state.  Marks if
+ * the alarm is a hop, so that reaching it is counted as a hop wakeup.  Returns
+ * false if the RTC failed, the alarm is then marked as disarmed so that the next
+ * update writes it again.
+ */
+bool _armAlarm(const int alarmIdx, const DateTime* const alarm, const bool isHop)
+{
+	RtcUtilsStatus status = RTC_CALENDAR_CONTROL_OKAY;
+
+	_isHop[alarmIdx] = (alarm != NULL) && isHop;
+
+	// disarm
+	if (alarm == NULL)
+	{
+		if (_isArmed[alarmIdx])
+		{
+			if (alarmIdx == ALARM_A)
+				status = rtcCalendarControl_diableAlarm_A();
+			else
+				status = rtcCalendarControl_diableAlarm_B();
+
+			// if disarming failed the alarm may still fire, which only causes an
+			// extra update
+			_isArmed[alarmIdx] = false;
+			TRACE(CALENDAR_TRACE_ALARM_DISARMED, alarmIdx);
+		}
+	}
+
+	// arm if not already armed with the alarm
+	else if (!_isArmedWith(alarmIdx, alarm))
+	{
+		if (alarmIdx == ALARM_A)
+			status = rtcCalendarControl_setAlarm_A(alarm->year, alarm->month, alarm->day,
+					alarm->hour, alarm->minute, alarm->second, alarm->millisecond);
+		else
+			status = rtcCalendarControl_setAlarm_B(alarm->year, alarm->month, alarm->day,
+					alarm->hour, alarm->minute, alarm->second, alarm->millisecond);
+
+		_armedAlarms[alarmIdx] = *alarm;
+		_isArmed[alarmIdx] = (status == RTC_CALENDAR_CONTROL_OKAY);
+		TRACE(isHop ? CALENDAR_TRACE_ALARM_HOP_ARMED : CALENDAR_TRACE_ALARM_ARMED, alarmIdx);
+	}
+
+	return status == RTC_CALENDAR_CONTROL_OKAY;
+}
+
+
+/* _isArmedWith
+ *
+ * Checks if one of the RTC alarms is armed with the date and time of an alarm.
+ */
+bool _isArmedWith(const int alarmIdx, const DateTime* const alarm)
+{
+	return _isArmed[alarmIdx]
+			&& _armedAlarms[alarmIdx].year == alarm->year
+			&& _armedAlarms[alarmIdx].month == alarm->month
+			&& _armedAlarms[alarmIdx].day == alarm->day
+			&& _armedAlarms[alarmIdx].hour == alarm->hour
+			&& _armedAlarms[alarmIdx].minute == alarm->minute
+			&& _armedAlarms[alarmIdx].second == alarm->second
+			&& _armedAlarms[alarmIdx].millisecond == alarm->millisecond;
+}
+
+
+/* _isReached
+ *
+ * Checks if now is at or after the date and time of an alarm.
+ */
+bool _isReached(const DateTime now, const DateTime alarm)
+{
+	uint32_t nowSeconds = dateTime_toSeconds(now);
+	uint32_t alarmSeconds = dateTime_toSeconds(alarm);
+
+	return nowSeconds > alarmSeconds
+			|| (nowSeconds == alarmSeconds && now.millisecond >= alarm.millisecond);
+}
+
+
+/* _isPassed
+ *
+ * Checks if the RTC's date and time, read now, is at or after the date and time
+ * of an alarm.  Assumes the alarm has passed if the RTC cannot be read.
+ */
+bool _isPassed(const DateTime alarm)
+{
+	DateTime now;
+	uint32_t nowSeconds;
+	uint16_t nowMillisecond;
+
+	if (rtcCalendarControl_getEpoch(&nowSeconds, &nowMillisecond) != RTC_CALENDAR_CONTROL_OKAY)
+		return true;
+
+	dateTime_fromSeconds(nowSeconds, &now);
+	now.millisecond = nowMillisecond;
+
+	return _isReached(now, alarm);
+}
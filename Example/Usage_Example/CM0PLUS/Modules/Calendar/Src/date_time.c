@@ -0,0 +1,166 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ */
+
+
+#include "date_time.h"
+
+
+/*
+ * Constants for converting between a date and time and seconds.
+ */
+#define SECONDS_PER_DAY 86400
+#define DAYS_PER_YEAR 365
+#define DAYS_PER_LEAP_CYCLE 1461	// days in four years, one of which is a leap year
+
+
+/*
+ * Days before the start of each month in a year that is not a leap year.
+ */
+static const uint16_t _daysBeforeMonth[12] = {
+		0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+};
+
+
+/*
+ * Private function prototypes.
+ */
+uint16_t _daysInYear(const uint8_t year);
+
+
+/* dateTime_toSeconds
+ *
+ * Converts a date and time to seconds since the start of the century.
+ *
+ * Note: every fourth year (including year 0) of the 21st century is a leap year.
+ */
+uint32_t dateTime_toSeconds(const DateTime dateTime)
+{
+	uint32_t days;
+
+	// days in the years before, one leap day per started four years
+	days = ((uint32_t)dateTime.year * DAYS_PER_YEAR) + ((dateTime.year + 3) / 4);
+
+	// days in the months before, plus the leap day if past February
+	days += _daysBeforeMonth[dateTime.month - 1];
+	if (dateTime.month > 2 && _daysInYear(dateTime.year) > DAYS_PER_YEAR)
+		days++;
+
+	// days before within the month
+	days += dateTime.day - 1;
+
+	return (days * SECONDS_PER_DAY)
+			+ ((uint32_t)dateTime.hour * 3600)
+			+ ((uint32_t)dateTime.minute * 60)
+			+ dateTime.second;
+}
+
+
+/* dateTime_fromSeconds
+ *
+ * Converts seconds since the start of the century to a date and time.
+ */
+void dateTime_fromSeconds(const uint32_t seconds, DateTime* const dateTime)
+{
+	uint32_t days = seconds / SECONDS_PER_DAY;
+	uint32_t secondOfDay = seconds % SECONDS_PER_DAY;
+	uint8_t year, month;
+
+	// whole four year cycles, then the remaining years of the cycle
+	year = (uint8_t)((days / DAYS_PER_LEAP_CYCLE) * 4);
+	days %= DAYS_PER_LEAP_CYCLE;
+	while (days >= _daysInYear(year))
+	{
+		days -= _daysInYear(year);
+		year++;
+	}
+
+	// months of the year
+	month = 1;
+	while (days >= dateTime_daysInMonth(year, month))
+	{
+		days -= dateTime_daysInMonth(year, month);
+		month++;
+	}
+
+	dateTime->year = year;
+	dateTime->month = month;
+	dateTime->day = (uint8_t)(days + 1);
+	dateTime->hour = (uint8_t)(secondOfDay / 3600);
+	dateTime->minute = (uint8_t)((secondOfDay % 3600) / 60);
+	dateTime->second = (uint8_t)(secondOfDay % 60);
+	dateTime->millisecond = 0;
+}
+
+
+/* dateTime_addMillis
+ *
+ * Moves a date and time by a number of milliseconds, through milliseconds since
+ * the start of the century.
+ */
+void dateTime_addMillis(DateTime* const dateTime, const int32_t millis)
+{
+	int64_t total = ((int64_t)dateTime_toSeconds(*dateTime) * 1000)
+			+ dateTime->millisecond + millis;
+
+	if (total < 0)
+		total = 0;
+
+	dateTime_fromSeconds((uint32_t)(total / 1000), dateTime);
+	dateTime->millisecond = (uint16_t)(total % 1000);
+}
+
+
+/* dateTime_millisBetween
+ *
+ * Gets the milliseconds between two dates and times, saturated to int32_t.
+ */
+int32_t dateTime_millisBetween(const DateTime from, const DateTime to)
+{
+	int64_t millis = (((int64_t)dateTime_toSeconds(to) - dateTime_toSeconds(from)) * 1000)
+			+ to.millisecond - from.millisecond;
+
+	if (millis > INT32_MAX)
+		return INT32_MAX;
+	if (millis < INT32_MIN)
+		return INT32_MIN;
+
+	return (int32_t)millis;
+}
+
+
+/* dateTime_daysInMonth
+ *
+ * Gets the number of days in a month, accounting for leap years.
+ */
+uint8_t dateTime_daysInMonth(const uint8_t year, const uint8_t month)
+{
+	// February
+	if (month == 2)
+	{
+		return (_daysInYear(year) > DAYS_PER_YEAR) ? 29 : 28;
+	}
+
+	// December
+	else if (month == 12)
+	{
+		return 31;
+	}
+
+	// all other months
+	else
+	{
+		return (uint8_t)(_daysBeforeMonth[month] - _daysBeforeMonth[month - 1]);
+	}
+}
+
+
+/* _daysInYear
+ *
+ * Gets the number of days in a year of the 21st century.
+ */
+uint16_t _daysInYear(const uint8_t year)
+{
+	return (year % 4 == 0) ? DAYS_PER_YEAR + 1 : DAYS_PER_YEAR;
+}
@@ -0,0 +1,220 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ */
+
+
+#include <rtc_alarm_driver.h>
+
+
+/*
+ * Macro function to check if the RTC has been initialized in HAL.
+ */
+#define IS_RTC_INIT(rtc_handle) (rtc_handle != NULL && rtc_handle->Instance != NULL)
+
+
+/*
+ * Registers and bits of one RTC alarm.
+ */
+typedef struct {
+	volatile uint32_t* alarmReg;		// ALRMxR
+	volatile uint32_t* subSecondMaskReg;	// ALRMxSSR
+	volatile uint32_t* subSecondReg;	// ALRxBINR
+	uint32_t subSecondClearBit;		// ALRMxSSR SSCLR
+	uint32_t enableBits;			// CR ALRxE and ALRxIE
+	uint32_t clearFlag;				// SCR CALRxF
+	uint32_t featureFlag;			// handle IsEnabled.RtcFeatures MISR ALRxMF
+} AlarmRegisters;
+
+
+/*
+ * Private function prototypes.
+ */
+void _getRegisters(RTC_HandleTypeDef* const hrtc, const uint32_t whichAlarm,
+		AlarmRegisters* const regs);
+bool _registersMatch(RTC_HandleTypeDef* const hrtc, const AlarmRegisters* const regs,
+		const uint32_t alarmReg, const uint32_t subSecondMaskReg, const uint32_t subSeconds);
+bool _registersDisarmed(RTC_HandleTypeDef* const hrtc, const AlarmRegisters* const regs);
+
+
+/* rtcAlarmDriver_arm
+ *
+ * Arms an RTC alarm by writing its registers, skipping the write if the alarm is
+ * already armed with the same values.  Follows the sequence of
+ * HAL_RTC_SetAlarm_IT() without the parameter conversion and HAL state.
+ */
+RtcUtilsStatus rtcAlarmDriver_arm(RTC_HandleTypeDef* const hrtc, const uint32_t whichAlarm,
+		const uint32_t alarmReg, const uint32_t subSecondMaskReg, const uint32_t subSeconds)
+{
+	AlarmRegisters regs;
+	int reads;
+
+	// the handle must be initialized
+	if (!IS_RTC_INIT(hrtc))
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+
+	_getRegisters(hrtc, whichAlarm, &regs);
+
+	// skip a no-op re-arm
+	if (_registersMatch(hrtc, &regs, alarmReg, subSecondMaskReg, subSeconds))
+	{
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	__HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+
+	// disable the alarm and clear its flag while it is written
+	CLEAR_BIT(hrtc->Instance->CR, regs.enableBits);
+	WRITE_REG(hrtc->Instance->SCR, regs.clearFlag);
+
+	// write the alarm, the alarm register is not used in binary only mode
+	if (hrtc->Init.BinMode != RTC_BINARY_ONLY)
+		WRITE_REG(*regs.alarmReg, alarmReg);
+	WRITE_REG(*regs.subSecondMaskReg, subSecondMaskReg);
+	WRITE_REG(*regs.subSecondReg, subSeconds);
+
+	// enable the alarm, its interrupt, and the alarm's EXTI line
+	SET_BIT(hrtc->IsEnabled.RtcFeatures, regs.featureFlag);
+	SET_BIT(hrtc->Instance->CR, regs.enableBits);
+	__HAL_RTC_ALARM_EXTI_ENABLE_IT();
+
+	__HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+	// confirm the write
+	for (reads = 0; reads < RTC_ALARM_DRIVER_CONFIRM_READS; reads++)
+	{
+		if (_registersMatch(hrtc, &regs, alarmReg, subSecondMaskReg, subSeconds))
+			return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	return RTC_CALENDAR_CONTROL_TIMEOUT;
+}
+
+
+/* rtcAlarmDriver_disarm
+ *
+ * Disarms an RTC alarm by writing its registers, skipping the write if the alarm
+ * is already disarmed.  Follows the sequence of HAL_RTC_DeactivateAlarm().
+ */
+RtcUtilsStatus rtcAlarmDriver_disarm(RTC_HandleTypeDef* const hrtc, const uint32_t whichAlarm)
+{
+	AlarmRegisters regs;
+	int reads;
+
+	// the handle must be initialized
+	if (!IS_RTC_INIT(hrtc))
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+
+	_getRegisters(hrtc, whichAlarm, &regs);
+
+	// skip a no-op disarm
+	if (_registersDisarmed(hrtc, &regs))
+	{
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	__HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+
+	// disable the alarm and its interrupt, then clear its flag
+	CLEAR_BIT(hrtc->Instance->CR, regs.enableBits);
+	CLEAR_BIT(*regs.subSecondMaskReg, regs.subSecondClearBit);
+	CLEAR_BIT(hrtc->IsEnabled.RtcFeatures, regs.featureFlag);
+	WRITE_REG(hrtc->Instance->SCR, regs.clearFlag);
+
+	__HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+	// confirm the write
+	for (reads = 0; reads < RTC_ALARM_DRIVER_CONFIRM_READS; reads++)
+	{
+		if (_registersDisarmed(hrtc, &regs))
+			return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	return RTC_CALENDAR_CONTROL_TIMEOUT;
+}
+
+
+/* rtcAlarmDriver_clearFired
+ *
+ * Clears the flags of fired alarms.  Reads the masked interrupt status once and
+ * writes the clear register once.
+ */
+uint32_t rtcAlarmDriver_clearFired(RTC_HandleTypeDef* const hrtc, uint32_t* const pending)
+{
+	uint32_t status = READ_REG(hrtc->Instance->MISR);
+	uint32_t fired = status & (RTC_MISR_ALRAMF | RTC_MISR_ALRBMF);
+
+	// clear only the fired alarms' flags, the clear bits share the status bits'
+	// positions
+	if (fired != 0U)
+	{
+		WRITE_REG(hrtc->Instance->SCR, fired);
+	}
+
+	*pending = status & ~fired;
+
+	return fired;
+}
+
+
+/* _getRegisters
+ *
+ * Gets the registers and bits of an RTC alarm (RTC_ALARM_A or RTC_ALARM_B).
+ */
+void _getRegisters(RTC_HandleTypeDef* const hrtc, const uint32_t whichAlarm,
+		AlarmRegisters* const regs)
+{
+	if (whichAlarm == RTC_ALARM_A)
+	{
+		regs->alarmReg = &(hrtc->Instance->ALRMAR);
+		regs->subSecondMaskReg = &(hrtc->Instance->ALRMASSR);
+		regs->subSecondReg = &(hrtc->Instance->ALRABINR);
+		regs->subSecondClearBit = RTC_ALRMASSR_SSCLR;
+		regs->enableBits = RTC_CR_ALRAE | RTC_CR_ALRAIE;
+		regs->clearFlag = RTC_SCR_CALRAF;
+		regs->featureFlag = RTC_MISR_ALRAMF;
+	}
+	else
+	{
+		regs->alarmReg = &(hrtc->Instance->ALRMBR);
+		regs->subSecondMaskReg = &(hrtc->Instance->ALRMBSSR);
+		regs->subSecondReg = &(hrtc->Instance->ALRBBINR);
+		regs->subSecondClearBit = RTC_ALRMBSSR_SSCLR;
+		regs->enableBits = RTC_CR_ALRBE | RTC_CR_ALRBIE;
+		regs->clearFlag = RTC_SCR_CALRBF;
+		regs->featureFlag = RTC_MISR_ALRBMF;
+	}
+}
+
+
+/* _registersMatch
+ *
+ * Checks if an RTC alarm and its interrupt are enabled with the register values.
+ * The sub-second field of the sub-second mask register reads back the low bits
+ * of the sub-second register, so only the rest of it is compared.
+ */
+bool _registersMatch(RTC_HandleTypeDef* const hrtc, const AlarmRegisters* const regs,
+		const uint32_t alarmReg, const uint32_t subSecondMaskReg, const uint32_t subSeconds)
+{
+	return (READ_REG(hrtc->Instance->CR) & regs->enableBits) == regs->enableBits
+			&& (READ_REG(hrtc->IsEnabled.RtcFeatures) & regs->featureFlag) != 0U
+			&& (hrtc->Init.BinMode == RTC_BINARY_ONLY || READ_REG(*regs->alarmReg) == alarmReg)
+			&& (READ_REG(*regs->subSecondMaskReg) & ~RTC_ALRMASSR_SS)
+					== (subSecondMaskReg & ~RTC_ALRMASSR_SS)
+			&& READ_REG(*regs->subSecondReg) == subSeconds;
+}
+
+
+/* _registersDisarmed
+ *
+ * Checks if an RTC alarm and its interrupt are disabled.
+ */
+bool _registersDisarmed(RTC_HandleTypeDef* const hrtc, const AlarmRegisters* const regs)
+{
+	return (READ_REG(hrtc->Instance->CR) & regs->enableBits) == 0U
+			&& (READ_REG(hrtc->IsEnabled.RtcFeatures) & regs->featureFlag) == 0U;
+}
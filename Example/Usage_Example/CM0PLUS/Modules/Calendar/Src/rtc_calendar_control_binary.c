@@ -0,0 +1,674 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Binary backend for RTC Calendar Control.  The RTC runs in binary mode
+ * (BinMode = RTC_BINARY_ONLY) as a free-running 32-bit counter in RTC_SSR that
+ * counts down from 0xFFFFFFFF at the asynchronous prescaler's rate.  The date and
+ * time are read as a single count, and alarms compare all 32 bits of the counter
+ * so they fire on an absolute count rather than a day of the month.
+ *
+ * The count is converted to a date and time with a base: the seconds since the
+ * start of the century at a known count.  The base is kept in the RTC backup
+ * registers so it survives a reset, and is moved forward as the counter runs so
+ * that it never falls more than half the counter's range behind.
+ */
+
+#include <rtc_calendar_control.h>
+#include <rtc_alarm_driver.h>
+#include <stdbool.h>
+
+
+#ifdef RTC_CALENDAR_CONTROL_BINARY
+
+
+/*
+ * Macro function to check if the RTC has been initialized in HAL
+ * and within this module.
+ */
+#define IS_RTC_INIT(rtc_handle) (rtc_handle != NULL && rtc_handle->Instance != NULL)
+
+/*
+ * Backup registers holding the base seconds and the count they were taken at.
+ */
+#define BASE_SECONDS_BKP_REG RTC_BKP_DR0
+#define BASE_TICKS_BKP_REG RTC_BKP_DR1
+
+/*
+ * Ticks elapsed since the base after which the base is moved forward.  Half the
+ * counter's range, so that alarms up to the other half ahead do not wrap.
+ */
+#define REBASE_TICKS 0x80000000UL
+
+/*
+ * Milliseconds in a second, over which its ticks are spread evenly.
+ */
+#define MILLIS_PER_SECOND 1000U
+
+
+/*
+ * Private function prototypes.
+ */
+RtcUtilsStatus _setAlarm(const uint32_t whichAlarm, const DateTime alarmDateTime);
+RtcUtilsStatus _getAlarm(const uint32_t whichAlarm, uint8_t* const year,
+		uint8_t* const month, uint8_t* const day, uint8_t* const hour,
+		uint8_t* const minute, uint8_t* const second, uint16_t* const millisecond);
+RtcUtilsStatus _disableAlarm(const uint32_t whichAlarm);
+RtcUtilsStatus _armEncoded(const uint32_t whichAlarm, const RtcAlarmRegisters* const regs);
+uint32_t _readElapsedTicks(void);
+void _rebase(const uint32_t elapsedTicks);
+void _ticksToDateTime(const uint32_t elapsedTicks, DateTime* const dateTime);
+uint32_t _dateTimeToTicks(const DateTime dateTime);
+void _ticksToEpoch(const uint32_t elapsedTicks, uint32_t* const seconds,
+		uint16_t* const millisecond);
+
+
+/*
+ * Static operational variables for module operation across function calls.
+ */
+RTC_HandleTypeDef* _rtc_handle;
+static uint32_t _ticksPerSecond;	// rate of the binary counter
+static uint32_t _baseSeconds;		// seconds since the start of the century at the base
+static uint32_t _baseTicks;			// elapsed ticks of the counter at the base
+
+
+/* rtcCalendarControl_init
+ *
+ * Initializes the module, stores a pointer to the HAL RTC handle and restores
+ * the base from the backup registers.
+ *
+ * Note: will not reinitialize if already initialized.
+ */
+RtcUtilsStatus rtcCalendarControl_init(RTC_HandleTypeDef* const hrtc)
+{
+	// if an initialized RTC handle has been passed
+	if (!IS_RTC_INIT(_rtc_handle))
+	{
+		// the RTC must be running in binary mode
+		if (hrtc == NULL || hrtc->Init.BinMode != RTC_BINARY_ONLY)
+		{
+			return RTC_CALENDAR_CONTROL_ERROR;
+		}
+
+		// the counter runs at the RTC clock divided by the asynchronous prescaler
+		_ticksPerSecond = HAL_RCCEx_GetPeriphCLKFreq(RCC_PERIPHCLK_RTC)
+				/ (hrtc->Init.AsynchPrediv + 1);
+		if (_ticksPerSecond < 2)
+		{
+			return RTC_CALENDAR_CONTROL_ERROR;
+		}
+
+		_rtc_handle = hrtc;		// store handle pointer
+
+		// restore the base
+		_baseSeconds = HAL_RTCEx_BKUPRead(_rtc_handle, BASE_SECONDS_BKP_REG);
+		_baseTicks = HAL_RTCEx_BKUPRead(_rtc_handle, BASE_TICKS_BKP_REG);
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// an invalid handle or uninitialized handle passed
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_setDateTime
+ *
+ * Set the date and time within the RTC.  Setting the time resets the counter to
+ * 0xFFFFFFFF, so the base is set to the date and time at zero elapsed ticks.
+ *
+ * Note: does not check if parameters are within correct range.
+ */
+RtcUtilsStatus rtcCalendarControl_setDateTime(const uint8_t year, const uint8_t month,
+		const uint8_t day, const uint8_t hour, const uint8_t minute,
+		const uint8_t second)
+{
+	RTC_TimeTypeDef time = {0};
+	DateTime dateTime = {year, month, day, hour, minute, second, 0};
+
+	// if module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// reset the counter
+		if (HAL_RTC_SetTime(_rtc_handle, &time, RTC_FORMAT_BIN) != HAL_OK) {
+			// HAL timeout
+			return RTC_CALENDAR_CONTROL_TIMEOUT;
+		}
+
+		// set and store the base
+		_baseSeconds = dateTime_toSeconds(dateTime);
+		_baseTicks = 0;
+		HAL_RTCEx_BKUPWrite(_rtc_handle, BASE_SECONDS_BKP_REG, _baseSeconds);
+		HAL_RTCEx_BKUPWrite(_rtc_handle, BASE_TICKS_BKP_REG, _baseTicks);
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_getDateTime
+ *
+ * Gets the date and time within the RTC from a single read of the counter.
+ */
+RtcUtilsStatus rtcCalendarControl_getDateTime(uint8_t* const year, uint8_t* const month,
+		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
+		uint8_t* const second, uint16_t* const millisecond)
+{
+	DateTime dateTime;
+	uint32_t elapsedTicks;
+	uint32_t primask;
+
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// read the counter, keep the base within range of it, and convert with
+		// interrupts disabled, since an interrupt reading the time also rebases
+		primask = __get_PRIMASK();
+		__disable_irq();
+		elapsedTicks = _readElapsedTicks();
+		_rebase(elapsedTicks);
+		_ticksToDateTime(elapsedTicks, &dateTime);
+		__set_PRIMASK(primask);
+
+		// Return through parameters
+		*year = dateTime.year;
+		*month = dateTime.month;
+		*day = dateTime.day;
+		*hour = dateTime.hour;
+		*minute = dateTime.minute;
+		*second = dateTime.second;
+		*millisecond = dateTime.millisecond;
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_getEpoch
+ *
+ * Gets the date and time within the RTC as seconds since the start of the
+ * century from a single read of the counter.
+ */
+RtcUtilsStatus rtcCalendarControl_getEpoch(uint32_t* const seconds,
+		uint16_t* const millisecond)
+{
+	uint32_t elapsedTicks;
+	uint32_t primask;
+
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// read the counter, keep the base within range of it, and convert with
+		// interrupts disabled, since an interrupt reading the time also rebases
+		primask = __get_PRIMASK();
+		__disable_irq();
+		elapsedTicks = _readElapsedTicks();
+		_rebase(elapsedTicks);
+		_ticksToEpoch(elapsedTicks, seconds, millisecond);
+		__set_PRIMASK(primask);
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_captureTimestamp
+ *
+ * Captures the counter.  Only the sub-second register is used.
+ */
+RtcUtilsStatus rtcCalendarControl_captureTimestamp(RtcTimestamp* const timestamp)
+{
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		timestamp->subSecondReg = ~_readElapsedTicks();
+		timestamp->timeReg = 0;
+		timestamp->dateReg = 0;
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_timestampToEpoch
+ *
+ * Converts a captured counter to seconds since the start of the century.  Only
+ * the sub-second register is used.
+ */
+RtcUtilsStatus rtcCalendarControl_timestampToEpoch(const RtcTimestamp* const timestamp,
+		uint32_t* const seconds, uint16_t* const millisecond)
+{
+	uint32_t primask;
+
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// the base is read whole, an interrupt reading the time can move it
+		primask = __get_PRIMASK();
+		__disable_irq();
+		_ticksToEpoch(~(timestamp->subSecondReg), seconds, millisecond);
+		__set_PRIMASK(primask);
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_getResolution
+ *
+ * Gets the length of one tick of the binary counter in microseconds.
+ */
+RtcUtilsStatus rtcCalendarControl_getResolution(uint32_t* const resolution_us)
+{
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		*resolution_us = 1000000 / _ticksPerSecond;
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_isAlarmDirect
+ *
+ * Checks if an alarm armed now would first fire at its date and time.  Alarms
+ * compare the whole counter, so this is the case when the alarm is within half
+ * the counter's range ahead of now.
+ */
+bool rtcCalendarControl_isAlarmDirect(const DateTime now, const DateTime alarm)
+{
+	uint32_t nowSeconds = dateTime_toSeconds(now);
+	uint32_t alarmSeconds = dateTime_toSeconds(alarm);
+
+	return alarmSeconds >= nowSeconds
+			&& (alarmSeconds - nowSeconds) < (REBASE_TICKS / _ticksPerSecond);
+}
+
+
+/* rtcCalendarControl_planAlarm
+ *
+ * Plans the alarm to arm for a target date and time.  If the target can not be
+ * armed directly, hops to the furthest count ahead of now that an alarm can
+ * reach.
+ */
+bool rtcCalendarControl_planAlarm(const DateTime now, const DateTime target,
+		DateTime* const alarm)
+{
+	// target can be armed directly
+	if (rtcCalendarControl_isAlarmDirect(now, target))
+	{
+		*alarm = target;
+		return true;
+	}
+
+	// hop to the last whole second within reach
+	dateTime_fromSeconds(dateTime_toSeconds(now)
+			+ (REBASE_TICKS / _ticksPerSecond) - 1, alarm);
+
+	return false;
+}
+
+
+/* rtcCalendarControl_setAlarm_A
+ *
+ * Sets and enables RTC Alarm A with an interrupt enabled.  The alarm fires on the
+ * count of the date and time.
+ *
+ * Note: does not validate that parameters are within valid range.
+ */
+RtcUtilsStatus rtcCalendarControl_setAlarm_A(const uint8_t year, const uint8_t month,
+		const uint8_t day, const uint8_t hour, const uint8_t minute,
+		const uint8_t second, const uint16_t millisecond)
+{
+	DateTime alarm = {year, month, day, hour, minute, second, millisecond};
+
+	return _setAlarm(RTC_ALARM_A, alarm);
+}
+
+
+/* rtcCalendarControl_getAlarm_A
+ *
+ * Gets the date and time that RTC Alarm A is set to trigger.
+ *
+ * Note: Does not distinguish if the alarm is enabled or not.
+ */
+RtcUtilsStatus rtcCalendarControl_getAlarm_A(uint8_t* const year, uint8_t* const month,
+		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
+		uint8_t* const second, uint16_t* const millisecond)
+{
+	return _getAlarm(RTC_ALARM_A, year, month, day, hour, minute, second, millisecond);
+}
+
+
+/* rtcCalendarControl_diableAlarm_A
+ *
+ * Disables alarm A from firing.
+ */
+RtcUtilsStatus rtcCalendarControl_diableAlarm_A(void)
+{
+	return _disableAlarm(RTC_ALARM_A);
+}
+
+
+/* rtcCalendarControl_armEncoded_A
+ *
+ * Arms alarm A with encoded register values.
+ */
+RtcUtilsStatus rtcCalendarControl_armEncoded_A(const RtcAlarmRegisters* const regs)
+{
+	return _armEncoded(RTC_ALARM_A, regs);
+}
+
+
+/* rtcCalendarControl_setAlarm_B
+ *
+ * Sets and enables RTC Alarm B with an interrupt enabled.  The alarm fires on the
+ * count of the date and time.
+ *
+ * Note: does not validate that parameters are within valid range.
+ */
+RtcUtilsStatus rtcCalendarControl_setAlarm_B(const uint8_t year, const uint8_t month,
+		const uint8_t day, const uint8_t hour, const uint8_t minute,
+		const uint8_t second, const uint16_t millisecond)
+{
+	DateTime alarm = {year, month, day, hour, minute, second, millisecond};
+
+	return _setAlarm(RTC_ALARM_B, alarm);
+}
+
+
+/* rtcCalendarControl_getAlarm_B
+ *
+ * Gets the date and time that RTC Alarm B is set to trigger.
+ *
+ * Note: Does not distinguish if the alarm is enabled or not.
+ */
+RtcUtilsStatus rtcCalendarControl_getAlarm_B(uint8_t* const year, uint8_t* const month,
+		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
+		uint8_t* const second, uint16_t* const millisecond)
+{
+	return _getAlarm(RTC_ALARM_B, year, month, day, hour, minute, second, millisecond);
+}
+
+
+/* rtcCalendarControl_diableAlarm_B
+ *
+ * Disables alarm B from firing.
+ */
+RtcUtilsStatus rtcCalendarControl_diableAlarm_B(void)
+{
+	return _disableAlarm(RTC_ALARM_B);
+}
+
+
+/* rtcCalendarControl_armEncoded_B
+ *
+ * Arms alarm B with encoded register values.
+ */
+RtcUtilsStatus rtcCalendarControl_armEncoded_B(const RtcAlarmRegisters* const regs)
+{
+	return _armEncoded(RTC_ALARM_B, regs);
+}
+
+
+/* _setAlarm
+ *
+ * Sets and enables an RTC alarm (RTC_ALARM_A or RTC_ALARM_B) with an interrupt
+ * enabled.  Skips the RTC if the alarm is already set to the count.
+ */
+RtcUtilsStatus _setAlarm(const uint32_t whichAlarm, const DateTime alarmDateTime)
+{
+	RtcAlarmRegisters regs;
+	RtcUtilsStatus status;
+
+	status = rtcCalendarControl_encodeAlarm(alarmDateTime, &regs);
+	if (status != RTC_CALENDAR_CONTROL_OKAY)
+		return status;
+
+	return _armEncoded(whichAlarm, &regs);
+}
+
+
+/* rtcCalendarControl_encodeAlarm
+ *
+ * Encodes the alarm register values for the count of the date and time.  A rebase
+ * does not change the count of a date and time, so encoded values stay valid.
+ */
+RtcUtilsStatus rtcCalendarControl_encodeAlarm(const DateTime alarm,
+		RtcAlarmRegisters* const regs)
+{
+	uint32_t primask;
+
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// the counter counts down, compare all bits against the count at the
+		// date and time
+		// the base is read whole, an interrupt reading the time can move it
+		regs->alarmReg = 0;
+		regs->subSecondMaskReg = RTC_ALARMSUBSECONDBINMASK_NONE
+				| RTC_ALARMSUBSECONDBIN_AUTOCLR_NO;
+		primask = __get_PRIMASK();
+		__disable_irq();
+		regs->subSeconds = ~_dateTimeToTicks(alarm);
+		__set_PRIMASK(primask);
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* _armEncoded
+ *
+ * Arms an RTC alarm (RTC_ALARM_A or RTC_ALARM_B) with encoded register values.
+ */
+RtcUtilsStatus _armEncoded(const uint32_t whichAlarm, const RtcAlarmRegisters* const regs)
+{
+	return rtcAlarmDriver_arm(_rtc_handle, whichAlarm, regs->alarmReg,
+			regs->subSecondMaskReg, regs->subSeconds);
+}
+
+
+/* _getAlarm
+ *
+ * Gets the date and time that an RTC alarm (RTC_ALARM_A or RTC_ALARM_B) is set
+ * to trigger.
+ */
+RtcUtilsStatus _getAlarm(const uint32_t whichAlarm, uint8_t* const year,
+		uint8_t* const month, uint8_t* const day, uint8_t* const hour,
+		uint8_t* const minute, uint8_t* const second, uint16_t* const millisecond)
+{
+	DateTime dateTime;
+	uint32_t count;
+
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// read the compared count
+		if (whichAlarm == RTC_ALARM_A)
+			count = READ_REG(_rtc_handle->Instance->ALRABINR);
+		else
+			count = READ_REG(_rtc_handle->Instance->ALRBBINR);
+
+		_ticksToDateTime(~count, &dateTime);
+
+		// Return through parameters
+		*year = dateTime.year;
+		*month = dateTime.month;
+		*day = dateTime.day;
+		*hour = dateTime.hour;
+		*minute = dateTime.minute;
+		*second = dateTime.second;
+		*millisecond = dateTime.millisecond;
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* _disableAlarm
+ *
+ * Disables an RTC alarm (RTC_ALARM_A or RTC_ALARM_B) from firing.
+ */
+RtcUtilsStatus _disableAlarm(const uint32_t whichAlarm)
+{
+	return rtcAlarmDriver_disarm(_rtc_handle, whichAlarm);
+}
+
+
+/* _readElapsedTicks
+ *
+ * Reads the ticks elapsed since the counter was reset.  The counter counts down
+ * from 0xFFFFFFFF.
+ */
+uint32_t _readElapsedTicks(void)
+{
+	return ~READ_REG(_rtc_handle->Instance->SSR);
+}
+
+
+/* _rebase
+ *
+ * Moves the base forward by whole seconds once it falls half the counter's
+ * range behind, and stores it in the backup registers.  Called with interrupts
+ * disabled from reading the counter to converting it, so that a rebase from an
+ * interrupt cannot move the base under a read in progress.
+ */
+void _rebase(const uint32_t elapsedTicks)
+{
+	uint32_t seconds;
+
+	if ((elapsedTicks - _baseTicks) >= REBASE_TICKS)
+	{
+		seconds = (elapsedTicks - _baseTicks) / _ticksPerSecond;
+		_baseSeconds += seconds;
+		_baseTicks += seconds * _ticksPerSecond;
+
+		HAL_RTCEx_BKUPWrite(_rtc_handle, BASE_SECONDS_BKP_REG, _baseSeconds);
+		HAL_RTCEx_BKUPWrite(_rtc_handle, BASE_TICKS_BKP_REG, _baseTicks);
+	}
+}
+
+
+/* _ticksToDateTime
+ *
+ * Converts elapsed ticks of the counter to a date and time.
+ */
+void _ticksToDateTime(const uint32_t elapsedTicks, DateTime* const dateTime)
+{
+	uint32_t ticks = elapsedTicks - _baseTicks;
+	uint32_t tickOfSecond = ticks % _ticksPerSecond;
+
+	dateTime_fromSeconds(_baseSeconds + (ticks / _ticksPerSecond), dateTime);
+	dateTime->millisecond = (uint16_t)((tickOfSecond * MILLIS_PER_SECOND) / _ticksPerSecond);
+}
+
+
+/* _dateTimeToTicks
+ *
+ * Converts a date and time to elapsed ticks of the counter.  Rounds up to the
+ * next tick so that the RTC never reads before the millisecond when an alarm
+ * fires, a millisecond after the last tick of a second starts going to the start
+ * of the next second.
+ *
+ * Note: the date and time must be within the counter's range of the base.
+ */
+uint32_t _dateTimeToTicks(const DateTime dateTime)
+{
+	uint32_t tickOfSecond;
+
+	tickOfSecond = ((dateTime.millisecond * _ticksPerSecond) + (MILLIS_PER_SECOND - 1U))
+			/ MILLIS_PER_SECOND;
+
+	return _baseTicks
+			+ ((dateTime_toSeconds(dateTime) - _baseSeconds) * _ticksPerSecond)
+			+ tickOfSecond;
+}
+
+
+/* _ticksToEpoch
+ *
+ * Converts elapsed ticks of the counter to seconds since the start of the century
+ * and milliseconds.  Handles ticks from shortly before the base, which a count
+ * captured before a rebase can be.
+ */
+void _ticksToEpoch(const uint32_t elapsedTicks, uint32_t* const seconds,
+		uint16_t* const millisecond)
+{
+	uint32_t ticks = elapsedTicks - _baseTicks;
+	uint32_t secondsBefore;
+
+	// after the base
+	if (ticks < REBASE_TICKS)
+	{
+		secondsBefore = 0;
+	}
+
+	// before the base, step back whole seconds so that ticks are after
+	else
+	{
+		secondsBefore = ((_baseTicks - elapsedTicks) + _ticksPerSecond - 1) / _ticksPerSecond;
+		ticks += secondsBefore * _ticksPerSecond;
+	}
+
+	// Return through parameters
+	*seconds = _baseSeconds - secondsBefore + (ticks / _ticksPerSecond);
+	if (millisecond != NULL)
+		*millisecond = (uint16_t)(((ticks % _ticksPerSecond) * MILLIS_PER_SECOND)
+				/ _ticksPerSecond);
+}
+
+
+#endif /* RTC_CALENDAR_CONTROL_BINARY */
@@ -26,9 +26,45 @@
 
 
 #include <stdint.h>
-#include <stm32wlxx_hal.h>
+#include <calendar_hal.h>
 #include <stdbool.h>
 #include <event_sll.h>
+#include <callback_profiler.h>
+
+/*
+ * Interrupt line of the RTC alarms, masked through an alarm interrupt storm.  The
+ * RTC shares RTC_LSECSS_IRQn on the Cortex-M0+ core, and its alarms have
+ * RTC_Alarm_IRQn on the Cortex-M4 core.  Can be set from the build for other
+ * devices.
+ */
+#ifndef CALENDAR_RTC_IRQn
+#ifdef CORE_CM0PLUS
+#define CALENDAR_RTC_IRQn RTC_LSECSS_IRQn
+#else
+#define CALENDAR_RTC_IRQn RTC_Alarm_IRQn
+#endif
+#endif
+
+/*
+ * Number of latency classes, each with its own estimate of the delay between an
+ * alarm and its callbacks.  An event's latency_class must be less than this, or
+ * its alarms are not compensated.
+ */
+#define CALENDAR_LATENCY_CLASSES 4
+
+/*
+ * Latency class of events whose alarms are not compensated, the default of a
+ * zeroed CalendarEvent.  Its latency is measured but never estimated, so its
+ * transitions always run at or after their time.
+ */
+#define CALENDAR_LATENCY_UNCOMPENSATED 0
+
+/*
+ * Number of buckets in the alarm to callback latency histogram.  Bucket n counts
+ * latencies under 2^(n + 1) milliseconds that are not in a lower bucket, and the
+ * last bucket counts all longer latencies.
+ */
+#define CALENDAR_LATENCY_BUCKETS 8
 
 /*
  * Return status codes for the calendar module.
@@ -39,9 +75,34 @@ typedef enum {
 	CALENDAR_NOT_INIT,
 	CALENDAR_FULL,
 	CALENDAR_PAUSED,
-	CALENDAR_RUNNING
+	CALENDAR_RUNNING,
+	CALENDAR_RTC_ERROR
 } CalendarStatus;
 
+/*
+ * Histogram of the latency between an alarm firing and its callbacks running.
+ */
+typedef struct {
+  uint32_t buckets[CALENDAR_LATENCY_BUCKETS];	// number of latencies in each bucket
+  uint32_t count;			// number of latencies measured
+  uint32_t maxMillis;		// longest latency measured (ms)
+} CalendarLatencyHistogram;
+
+/*
+ * Cumulative counters of the scheduler's operation.
+ */
+typedef struct {
+  uint32_t updates;			// scheduler updates run
+  uint32_t alarmsFired;		// RTC alarm interrupts
+  uint32_t spuriousAlarms;	// alarm updates where no armed alarm had been reached
+  uint32_t storms;			// alarm interrupt storms recovered from
+  uint32_t transitions;		// event changes, triggers, and prepares run
+  uint32_t skippedTransitions;	// transitions passed while paused, not run
+  uint32_t rearms;			// alarms re-armed from the alarm interrupt
+  uint32_t maxUpdateCycles;	// most CPU cycles of an update, callbacks included
+  uint32_t maxEvents;		// most events in the calendar at once
+} CalendarStats;
+
 /* calendar_init
  *
  * Function:
@@ -73,6 +134,12 @@ CalendarStatus calendar_init(RTC_HandleTypeDef* hrtc);
  * 	CalendarStatus
  * 		CALENDAR_NOT_INIT - if the calendar module has not been initialized
  * 		CALENDAR_OKAY - if successful
+ *
+ * Note:
+ * 	The RTC alarms are disarmed, and alarms fired and transitions left to run
+ * 	for the cleared events are dropped.  The active event's active time ends
+ * 	without its end callback.  The statistics, hop wakeups and alarm faults
+ * 	are zeroed.
  */
 CalendarStatus calendar_resetEvents(void);
 
@@ -86,6 +153,8 @@ CalendarStatus calendar_resetEvents(void);
  *	CalendarStatus
  *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
  *		CALENDAR_RUNNING - if the calendar is already running (not an error)
+ *		CALENDAR_RTC_ERROR - if the calendar was started but the RTC alarms could
+ *				not be armed, they are retried by calendar_updateScheduler()
  *		CALENDAR_OKAY - if the calendar was started
  *
  * Note:
@@ -121,7 +190,8 @@ CalendarStatus calendar_pauseScheduler(void);
  *	Set the date and time of the RTC.
  *
  * Parameters:
- *	dateTime - the time and date to set the RTC to.
+ *	dateTime - the time and date to set the RTC to.  The millisecond is ignored,
+ *			the RTC is set to the start of the second.
  *
  * Return:
  * 	CalendarStatus
@@ -153,6 +223,254 @@ CalendarStatus calendar_setDateTime(const DateTime dateTime);
  */
 CalendarStatus calendar_getDateTime(DateTime* const dateTime);
 
+/* calendar_getEpoch
+ *
+ * Function:
+ *	Get the date and time of the RTC as seconds since the start of the century
+ *	(00/01/01 00:00:00).  Faster than calendar_getDateTime() and directly
+ *	comparable, see dateTime_toSeconds() and dateTime_fromSeconds().
+ *
+ * Parameters:
+ *	seconds - pointer to store the seconds since the start of the century.
+ *	millisecond - pointer to store the millisecond of the second, or NULL if not
+ *			needed.
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_OKAY - if the calendar's date and time were read
+ */
+CalendarStatus calendar_getEpoch(uint32_t* const seconds, uint16_t* const millisecond);
+
+/* calendar_getCachedEpoch
+ *
+ * Function:
+ *	Get a cached copy of the date and time as seconds since the start of the
+ *	century.  Does not access the RTC, for application code that needs the time
+ *	often and cheaply.
+ *
+ * Return:
+ *	uint32_t - cached seconds since the start of the century, 0 if the module
+ *			hasn't been initialized
+ *
+ * Note:
+ * 	The cache is refreshed by calendar_secondTick_ISR(), by each scheduler update,
+ * 	and when the date and time are set or read with calendar_getEpoch().  Without
+ * 	calendar_secondTick_ISR() called once per second it may be stale.
+ */
+uint32_t calendar_getCachedEpoch(void);
+
+/* calendar_getTimeResolution
+ *
+ * Function:
+ *	Get the resolution that the calendar reads date/times and fires event
+ *	transitions at.  Event start/end times are given in milliseconds, but are
+ *	rounded up to a tick of the RTC's sub-second counter.
+ *
+ * Parameters:
+ *	resolution_us - pointer to store the resolution in microseconds.
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_OKAY - if the resolution was read
+ *
+ * Note:
+ * 	The resolution is set by the RTC's synchronous prescaler.  A SynchPrediv of 255
+ * 	gives a resolution of 3906 microseconds.
+ */
+CalendarStatus calendar_getTimeResolution(uint32_t* const resolution_us);
+
+/* calendar_getHopWakeups
+ *
+ * Function:
+ *	Get the number of hop wakeups since the module was initialized or the events
+ *	were reset.  A hop wakeup is an alarm that fired only to reach a transition
+ *	too far away for the RTC to arm directly, not at an event transition.
+ *
+ * Parameters:
+ *	count - pointer to store the number of hop wakeups.
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_OKAY - if the count was read
+ *
+ * Note:
+ * 	Hops are planned for the fewest wakeups.  With the BCD RTC backend a
+ * 	transition up to about a month away needs no hops, and each hop covers one
+ * 	to two months.
+ */
+CalendarStatus calendar_getHopWakeups(uint32_t* const count);
+
+/* calendar_getAlarmFaults
+ *
+ * Function:
+ *	Get the number of RTC alarm faults the scheduler has recovered from since the
+ *	module was initialized or the events were reset.
+ *
+ * Parameters:
+ *	storms - pointer to store the number of alarm interrupt storms, where the
+ *			alarm interrupt fired more often than the armed alarms and the
+ *			lookahead can and was masked until the next update.
+ *	mismatches - pointer to store the number of alarm updates where no armed
+ *			alarm had been reached.
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_OKAY - if the counts were read
+ *
+ * Note:
+ * 	On either fault both RTC alarms are disarmed and re-armed by the update.
+ */
+CalendarStatus calendar_getAlarmFaults(uint32_t* const storms, uint32_t* const mismatches);
+
+/* calendar_getLatency
+ *
+ * Function:
+ *	Get the dispatch latency compensation of a latency class.  The scheduler
+ *	measures the error between each callback and its transition, and arms the
+ *	class's alarms early by a running estimate of the latency so that callbacks
+ *	run on the transition.  The estimate of CALENDAR_LATENCY_UNCOMPENSATED is
+ *	always 0, its last error is still measured.
+ *
+ * Parameters:
+ *	latencyClass - the latency class (0 - CALENDAR_LATENCY_CLASSES - 1)
+ *	estimate - pointer to store the milliseconds alarms are armed early by
+ *	lastError - pointer to store the milliseconds the last measured callback ran
+ *			after its transition, negative if before
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_PARAMETER_ERROR - if the latency class is out of range
+ *		CALENDAR_OKAY - if the compensation was read
+ */
+CalendarStatus calendar_getLatency(const uint8_t latencyClass, int32_t* const estimate,
+		int32_t* const lastError);
+
+/* calendar_getLatencyHistogram
+ *
+ * Function:
+ *	Get a snapshot of the histogram of the latency between an alarm firing and
+ *	the callbacks of its transitions running, since the module was initialized or
+ *	the histogram was reset.  Each alarm is measured once, from the time its
+ *	interrupt captured the RTC to the time its update starts running callbacks.
+ *
+ * Parameters:
+ *	histogram - pointer to store the histogram in
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_OKAY - if the histogram was read
+ *
+ * Note:
+ *	Latencies are measured at the resolution of the RTC's sub-second counter.
+ */
+CalendarStatus calendar_getLatencyHistogram(CalendarLatencyHistogram* const histogram);
+
+/* calendar_resetLatencyHistogram
+ *
+ * Function:
+ *	Clear the alarm to callback latency histogram.
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_OKAY - if the histogram was cleared
+ */
+CalendarStatus calendar_resetLatencyHistogram(void);
+
+/* calendar_getStats
+ *
+ * Function:
+ *	Get the scheduler's cumulative counters since the module was initialized or
+ *	the events were reset.
+ *
+ * Parameters:
+ *	stats - pointer to store the counters in
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_OKAY - if the counters were read
+ *
+ * Note:
+ *	Each counter is written by one context only, so counters are read without
+ *	locking.  Counters written by the alarm interrupt may be one ahead of the
+ *	others.
+ */
+CalendarStatus calendar_getStats(CalendarStats* const stats);
+
+/* calendar_getActiveTime
+ *
+ * Function:
+ *	Get how long an event has actually been active, from each time its start
+ *	callback ran to the time its end callback ran.  Overlaps, pauses, and late
+ *	updates are accounted for, so this can differ from the event's scheduled
+ *	window.  Includes the time so far if the event is active.
+ *
+ * Parameters:
+ *	id - ID of the event
+ *	seconds - pointer to store the seconds the event has been active
+ *	isActive - pointer to store if the event is active, or NULL if not needed
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_PARAMETER_ERROR - if there is no event with the ID
+ *		CALENDAR_OKAY - if the active time was read
+ *
+ * Note:
+ *	The time so far of an active event is counted to the cached date and time.
+ *	Removing an active event ends its active time.
+ */
+CalendarStatus calendar_getActiveTime(unsigned int id, uint32_t* const seconds,
+		bool* const isActive);
+
+/* calendar_getClassActiveTime
+ *
+ * Function:
+ *	Get how long the events of a latency class have actually been active in
+ *	total, including removed events.  See calendar_getActiveTime().
+ *
+ * Parameters:
+ *	latencyClass - the latency class (0 - CALENDAR_LATENCY_CLASSES - 1)
+ *	seconds - pointer to store the seconds the class's events have been active
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_PARAMETER_ERROR - if the latency class is out of range
+ *		CALENDAR_OKAY - if the active time was read
+ */
+CalendarStatus calendar_getClassActiveTime(const uint8_t latencyClass, uint32_t* const seconds);
+
+#ifdef CALENDAR_PROFILE_CALLBACKS
+/* calendar_getCallbackProfile
+ *
+ * Function:
+ *	Get the timing of an event's callbacks, in CPU cycles, since the event was
+ *	added.
+ *
+ * Parameters:
+ *	id - ID of the event
+ *	profile - pointer to store the timing in
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_PARAMETER_ERROR - if there is no event with the ID
+ *		CALENDAR_OKAY - if the timing was read
+ *
+ * Note:
+ *	Only available with CALENDAR_PROFILE_CALLBACKS defined.
+ */
+CalendarStatus calendar_getCallbackProfile(unsigned int id, CallbackProfile* const profile);
+#endif
+
 /* calendar_addEvent
  *
  * Function:
@@ -170,6 +488,31 @@ CalendarStatus calendar_getDateTime(DateTime* const dateTime);
  */
 CalendarStatus calendar_addEvent(const struct CalendarEvent event);
 
+/* calendar_addTrigger
+ *
+ * Function:
+ *	Add a trigger to the calendar, a one-shot action at an instant.  A trigger
+ *	costs one alarm and one callback, and is never the event in progress, so it
+ *	runs even within another event.
+ *
+ * Parameters:
+ *	at - date and time to call the callback at
+ *	callback - function to call at the date and time
+ *
+ * Return:
+ *	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_FULL - if the calendar's queue is full
+ *		CALENDAR_RUNNING - if the calendar is not paused
+ *		CALENDAR_OKAY - if the trigger was successfully added
+ *
+ * Note:
+ *	A trigger is stored as an event with the same start and end, and start
+ *	callback.  Adding such an event with calendar_addEvent() also adds a trigger.
+ *	Triggers share storage with events, and are peeked and removed the same way.
+ */
+CalendarStatus calendar_addTrigger(const DateTime at, void (*callback)(void));
+
 /* calendar_peekEvent
  *
  * Function:
@@ -216,6 +559,8 @@ CalendarStatus calendar_removeEvent(unsigned int id);
  * Return:
  *	CALENDAR_NOT_INITIALIZED - if the module has not been initialized
  *	CALENDAR_PAUSED - if the calendar is currently paused
+ *	CALENDAR_RTC_ERROR - if the RTC alarms could not be armed, the update is
+ *			retried on the next call
  *	CALENDAR_OKAY - otherwise (does not distinguish if any events began/ended.
  *
  * Note:
@@ -224,19 +569,118 @@ CalendarStatus calendar_removeEvent(unsigned int id);
  * 	that the execution of callback functions for starting or ending an event may be
  * 	delayed for some time after the event actually began/ended.  This is up to the
  * 	application to determine response time.
+ *
+ * 	An update's time grows with the number of events (n) and the number of
+ * 	transitions it runs, see the README's Worst-Case Execution.  Interrupts are
+ * 	only masked while the RTC alarms are armed, which does not depend on n.
  */
 CalendarStatus calendar_updateScheduler(void);
 
+/* calendar_updateSchedulerBounded
+ *
+ * Function:
+ *	Performs an update like calendar_updateScheduler(), but runs at most a number
+ *	of the transitions passed since the last update.  The rest are run by the
+ *	next calls, in order, so scheduler work can be interleaved with tight control
+ *	loops.
+ *
+ * Parameters:
+ *	maxTransitions - most transitions to run, at least 1.  A transition is an
+ *			instant where events end, start, trigger, or are prepared.
+ *	isPending - pointer to store if passed transitions are left to run, or NULL
+ *			if not needed
+ *
+ * Return:
+ *	CALENDAR_NOT_INITIALIZED - if the module has not been initialized
+ *	CALENDAR_PARAMETER_ERROR - if maxTransitions is 0
+ *	CALENDAR_PAUSED - if the calendar is currently paused
+ *	CALENDAR_RTC_ERROR - if the RTC alarms could not be armed, the update is
+ *			retried on the next call
+ *	CALENDAR_OKAY - otherwise
+ *
+ * Note:
+ * 	Each call finds and arms the next alarms, at a cost that does not depend on
+ * 	the limit, then runs up to maxTransitions transitions at about 6n event visits
+ * 	each (n events) plus their callbacks.  A call with transitions left is
+ * 	followed by another update on the next call without waiting for an alarm.
+ * 	Transitions left when the calendar is paused are skipped on restart, and the
+ * 	event the replay last entered is ended then.
+ */
+CalendarStatus calendar_updateSchedulerBounded(const unsigned int maxTransitions,
+		bool* const isPending);
+
 /* calendar_AlarmA_ISR
  *
  * Function:
  *	Sets a flag to signal to the calendar_update() function that an event has either
- *	began or ended.
+ *	began or ended, and records the time the alarm fired.
  *
  * Note:
  * 	Call only within HAL_RTC_AlarmAEventCallback().  Otherwise the behavior is undefined.
  */
 void calendar_AlarmA_ISR(void);
 
+/* calendar_AlarmB_ISR
+ *
+ * Function:
+ *	Sets a flag to signal to the calendar_update() function that an event has either
+ *	began or ended, and records the time the alarm fired.  The scheduler alternates
+ *	between Alarm A and Alarm B so that the next transition is always armed before
+ *	the current one fires.
+ *
+ * Note:
+ * 	Call only within HAL_RTCEx_AlarmBEventCallback().  Otherwise the behavior is undefined.
+ */
+void calendar_AlarmB_ISR(void);
+
+/* calendar_RTC_IRQHandler
+ *
+ * Function:
+ *	Lean RTC alarm interrupt entry.  Clears the flags of fired alarms, signals
+ *	the calendar_update() function that an event has either began or ended, and
+ *	records the time they fired.  Any other RTC interrupt pending with them is
+ *	handed to the HAL handler of its source (wakeup timer, timestamp, sub-second
+ *	underflow, or tamper), which clears it.
+ *
+ * Parameters:
+ *	hrtc - pointer to the HAL RTC handle passed to calendar_init().
+ *
+ * Note:
+ * 	Call only within RTC_LSECSS_IRQHandler(), in place of HAL_RTC_AlarmIRQHandler().
+ * 	The HAL alarm callbacks (and calendar_AlarmA_ISR() and calendar_AlarmB_ISR())
+ * 	are then not called for the calendar's alarms.
+ */
+void calendar_RTC_IRQHandler(RTC_HandleTypeDef* const hrtc);
+
+/* calendar_getLastAlarmTime
+ *
+ * Function:
+ *	Get the time that the alarm interrupt last handled a fired alarm, as seconds
+ *	since the start of the century.
+ *
+ * Parameters:
+ *	seconds - pointer to store the seconds since the start of the century.
+ *	millisecond - pointer to store the millisecond of the second, or NULL if not
+ *			needed.
+ *
+ * Return:
+ * 	CalendarStatus
+ *		CALENDAR_NOT_INIT - if the calendar module hasn't been initialized
+ *		CALENDAR_PARAMETER_ERROR - if no alarm has been handled
+ *		CALENDAR_OKAY - if the time was read
+ */
+CalendarStatus calendar_getLastAlarmTime(uint32_t* const seconds, uint16_t* const millisecond);
+
+/* calendar_secondTick_ISR
+ *
+ * Function:
+ *	Refreshes the cached date and time read by calendar_getCachedEpoch().
+ *
+ * Note:
+ * 	Call once per second from an interrupt, such as the RTC wakeup timer's
+ * 	HAL_RTCEx_WakeUpTimerEventCallback() with the timer clocked at 1 Hz.
+ */
+void calendar_secondTick_ISR(void);
+
 
 #endif /* INC_CALENDAR_H_ */
@@ -0,0 +1,116 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		Callback Profiler times the event callbacks called by the calendar's
+ *	scheduler in CPU cycles and keeps the minimum, maximum and mean of each
+ *	event, and how often its callbacks ran over a budget.  Cycles are counted
+ *	with the DWT cycle counter on the Cortex-M4, and with SysTick and the HAL's
+ *	tick on the Cortex-M0+, which has no DWT.
+ *		The profiler is only compiled with CALENDAR_PROFILE_CALLBACKS defined.
+ *	Otherwise the scheduler calls callbacks directly, with no overhead.  The
+ *	cycle counter is always compiled, the scheduler times its updates with it.
+ */
+
+#ifndef CALENDAR_INC_CALLBACK_PROFILER_H_
+#define CALENDAR_INC_CALLBACK_PROFILER_H_
+
+
+#include <calendar_hal.h>
+#include <stdbool.h>
+#include <event_sll.h>
+
+/*
+ * Define to time the event callbacks.
+ */
+//#define CALENDAR_PROFILE_CALLBACKS
+
+/*
+ * CPU cycles a callback may take before it is counted as over budget.
+ */
+#ifndef CALENDAR_CALLBACK_BUDGET_CYCLES
+#define CALENDAR_CALLBACK_BUDGET_CYCLES 48000
+#endif
+
+/*
+ * Timing of the callbacks of one event.
+ */
+typedef struct {
+  uint32_t count;			// number of callbacks timed
+  uint32_t minCycles;		// fewest cycles of a callback
+  uint32_t maxCycles;		// most cycles of a callback
+  uint32_t meanCycles;		// mean cycles of the callbacks
+  uint32_t overBudget;		// number of callbacks over CALENDAR_CALLBACK_BUDGET_CYCLES
+} CallbackProfile;
+
+
+/* callbackProfiler_initCycles
+ *
+ * Function:
+ *	Starts the cycle counter.
+ *
+ * Note:
+ *	On the Cortex-M0+ the cycle count is read from SysTick, which must be running
+ *	as the HAL's tick.
+ */
+void callbackProfiler_initCycles(void);
+
+/* callbackProfiler_readCycles
+ *
+ * Function:
+ *	Reads the cycle counter.
+ *
+ * Return:
+ *	uint32_t - CPU cycles counted, subtract two reads for the cycles between them
+ */
+uint32_t callbackProfiler_readCycles(void);
+
+
+#ifdef CALENDAR_PROFILE_CALLBACKS
+
+/* callbackProfiler_init
+ *
+ * Function:
+ *	Clears the timing of all events.  Start the cycle counter with
+ *	callbackProfiler_initCycles() first.
+ */
+void callbackProfiler_init(void);
+
+/* callbackProfiler_run
+ *
+ * Function:
+ *	Calls a callback of an event and adds its time to the event's timing.
+ *
+ * Parameters:
+ *	id - ID of the event the callback belongs to
+ *	callback - the callback to call
+ */
+void callbackProfiler_run(const int id, void (*callback)(void));
+
+/* callbackProfiler_get
+ *
+ * Function:
+ *	Gets the timing of an event's callbacks.
+ *
+ * Parameters:
+ *	id - ID of the event
+ *	profile - pointer to store the timing in.  All zero if no callbacks were
+ *			timed.
+ */
+void callbackProfiler_get(const int id, CallbackProfile* const profile);
+
+/* callbackProfiler_clear
+ *
+ * Function:
+ *	Clears the timing of an event.
+ *
+ * Parameters:
+ *	id - ID of the event
+ */
+void callbackProfiler_clear(const int id);
+
+#endif /* CALENDAR_PROFILE_CALLBACKS */
+
+
+#endif /* CALENDAR_INC_CALLBACK_PROFILER_H_ */
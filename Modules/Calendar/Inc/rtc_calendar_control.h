@@ -5,7 +5,13 @@
  * Purpose:
  *		RTC Calendar Control provides functions to the calendar module for setting
  *	and getting RTC features.  This includes the RTC's date and time, and the RTC's
- *	alarms.
+ *	alarms.  Both RTC alarms (A and B) are controlled so that the calendar can keep
+ *	two alarms armed at once.
+ *		Two backends implement these functions.  The default backend runs the RTC
+ *	in BCD mode, where alarms can only match the day of the month and time.  The
+ *	binary backend (RTC_CALENDAR_CONTROL_BINARY) runs the RTC in binary mode, reads
+ *	the date and time from the 32-bit sub-second counter, and arms alarms on
+ *	absolute counts.
  */
 
 
@@ -13,8 +19,16 @@
 #define RTC_UTILS_H
 
 
-#include "stm32wlxx_hal.h"
+#include <calendar_hal.h>
 #include <stdbool.h>
+#include <date_time.h>
+
+/*
+ * Define to use the binary backend.  The RTC must be initialized with
+ * BinMode = RTC_BINARY_ONLY.  Leave undefined to use the BCD backend, with the
+ * RTC initialized with BinMode = RTC_BINARY_NONE.
+ */
+//#define RTC_CALENDAR_CONTROL_BINARY
 
 /*
  * Status returns for RTC.
@@ -26,6 +40,26 @@ typedef enum {
   RTC_CALENDAR_CONTROL_ERROR
 } RtcUtilsStatus;
 
+/*
+ * RTC registers captured at an instant, converted to a date and time later so
+ * that capturing is only three register reads.
+ */
+typedef struct {
+  uint32_t subSecondReg;	// RTC_SSR
+  uint32_t timeReg;			// RTC_TR
+  uint32_t dateReg;			// RTC_DR
+} RtcTimestamp;
+
+/*
+ * Register values of an RTC alarm, encoded ahead of time so that arming is only
+ * register writes.
+ */
+typedef struct {
+  uint32_t alarmReg;			// RTC_ALRMxR
+  uint32_t subSecondMaskReg;	// RTC_ALRMxSSR
+  uint32_t subSeconds;			// RTC_ALRxBINR
+} RtcAlarmRegisters;
+
 /* rtcCalendarControl_init
  *
  * Function:
@@ -82,6 +116,8 @@ RtcUtilsStatus rtcCalendarControl_setDateTime(const uint8_t year, const uint8_t
  *	hour - two digit hour in 24 hour format (0 - 23)
  *	minute - two digit minute 				(0 - 59)
  *	second - two digit second 				(0 - 59)
+ *	millisecond - millisecond of the second	(0 - 999), read from the RTC's
+ *			sub-second counter
  *
  * Return:
  *	RtcUtilsStatus
@@ -90,26 +126,170 @@ RtcUtilsStatus rtcCalendarControl_setDateTime(const uint8_t year, const uint8_t
  */
 RtcUtilsStatus rtcCalendarControl_getDateTime(uint8_t* const year, uint8_t* const month,
 		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
-		uint8_t* const second);
+		uint8_t* const second, uint16_t* const millisecond);
+
+/* rtcCalendarControl_getEpoch
+ *
+ * Function:
+ *	Get the date and time of the RTC as seconds since the start of the century
+ *	(00/01/01 00:00:00).  A fast path for comparing times, the RTC's registers
+ *	are read once and not decoded into a date and time.
+ *
+ * Parameters:
+ *	seconds - pointer to store the seconds since the start of the century
+ *	millisecond - pointer to store the millisecond of the second (0 - 999),
+ *			or NULL if not needed
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	The BCD backend reads the sub-second, time, and date registers in that
+ *	order, which keeps them consistent through the shadow registers.  The binary
+ *	backend reads the counter once.
+ */
+RtcUtilsStatus rtcCalendarControl_getEpoch(uint32_t* const seconds,
+		uint16_t* const millisecond);
+
+/* rtcCalendarControl_captureTimestamp
+ *
+ * Function:
+ *	Capture the RTC's registers at this instant, to be converted to a date and
+ *	time later.  For use in interrupts.
+ *
+ * Parameters:
+ *	timestamp - pointer to store the captured registers
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ */
+RtcUtilsStatus rtcCalendarControl_captureTimestamp(RtcTimestamp* const timestamp);
+
+/* rtcCalendarControl_timestampToEpoch
+ *
+ * Function:
+ *	Convert RTC registers captured at an instant to seconds since the start of
+ *	the century (00/01/01 00:00:00).
+ *
+ * Parameters:
+ *	timestamp - pointer to the captured registers
+ *	seconds - pointer to store the seconds since the start of the century
+ *	millisecond - pointer to store the millisecond of the second (0 - 999),
+ *			or NULL if not needed
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	The binary backend converts with its current base, so convert timestamps
+ *	soon after capturing them.
+ */
+RtcUtilsStatus rtcCalendarControl_timestampToEpoch(const RtcTimestamp* const timestamp,
+		uint32_t* const seconds, uint16_t* const millisecond);
+
+/* rtcCalendarControl_getResolution
+ *
+ * Function:
+ *	Get the resolution of the RTC's sub-second counter, which is the resolution
+ *	that date/times are read and alarms are fired at.
+ *
+ * Parameters:
+ *	resolution_us - pointer to store the resolution in microseconds
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	The BCD backend's resolution is set by the RTC's synchronous prescaler
+ *	(SynchPrediv).  A SynchPrediv of 255 gives a resolution of 3906 microseconds.
+ *	The binary backend's resolution is set by the asynchronous prescaler
+ *	(AsynchPrediv).  An AsynchPrediv of 127 with the LSE gives 3906 microseconds.
+ */
+RtcUtilsStatus rtcCalendarControl_getResolution(uint32_t* const resolution_us);
+
+/* rtcCalendarControl_isAlarmDirect
+ *
+ * Function:
+ *	Checks if an alarm armed now would first fire at the alarm's date and time.
+ *
+ * Parameters:
+ *	now - the current date and time
+ *	alarm - the date and time of the alarm
+ *
+ * Return:
+ *	bool - true if the alarm would first fire at its date and time, false if
+ *			it could fire earlier
+ *
+ * Note:
+ *	The BCD backend's alarms fire on the first match of the day of the month and
+ *	time, which is only the alarm's date within about one to two months,
+ *	depending on month lengths.  The binary
+ *	backend's alarms fire on an absolute count, which is only the alarm's date
+ *	within half the range of the 32-bit counter (about 97 days at 256 Hz).
+ */
+bool rtcCalendarControl_isAlarmDirect(const DateTime now, const DateTime alarm);
+
+/* rtcCalendarControl_planAlarm
+ *
+ * Function:
+ *	Plans the alarm to arm for a target date and time.  If an alarm can not
+ *	fire directly at the target, plans a hop alarm instead.  A hop is the latest
+ *	date and time before the target that an alarm armed now fires at directly,
+ *	so that re-planning from each hop reaches the target in the fewest wakeups.
+ *
+ * Parameters:
+ *	now - the current date and time
+ *	target - the date and time of the transition to reach
+ *	alarm - pointer to store the date and time of the alarm to arm
+ *
+ * Return:
+ *	bool - true if the alarm is the target, false if it is a hop
+ *
+ * Note:
+ *	The BCD backend takes hops at the target's time of day and accounts for
+ *	month lengths, a hop can skip a month without the hop's day of the month.
+ *	The binary backend hops to the end of the counter's reach.
+ */
+bool rtcCalendarControl_planAlarm(const DateTime now, const DateTime target,
+		DateTime* const alarm);
 
 /* rtcCalendarControl_setAlarm_A
  *
  * Function:
- *	Set the time and day of the month for Alarm A to fire.
+ *	Set the date and time for Alarm A to fire.
  *
  * Parameters:
+ *	year - two digit 21st century year 		(0 - 99)
+ *	month - two digit month 				(1 - 12)
  *	day - two digit day of month 			(1 - 28/29/30/31)
  *	hour - two digit hour in 24 hour format (0 - 23)
  *	minute - two digit minute 				(0 - 59)
  *	second - two digit second 				(0 - 59)
+ *	millisecond - millisecond of the second	(0 - 999), compared against
+ *			the RTC's sub-second counter
  *
  * Return:
  *	RtcUtilsStatus
  *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
  *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	The BCD backend matches the day of the month and time, the alarm fires on
+ *	their next match.  See rtcCalendarControl_isAlarmDirect().  It only uses the
+ *	year and month to carry a millisecond within the last sub-second tick into
+ *	the next second.
  */
-RtcUtilsStatus rtcCalendarControl_setAlarm_A(const uint8_t day, const uint8_t hour,
-		const uint8_t minute, const uint8_t second);
+RtcUtilsStatus rtcCalendarControl_setAlarm_A(const uint8_t year, const uint8_t month,
+		const uint8_t day, const uint8_t hour, const uint8_t minute,
+		const uint8_t second, const uint16_t millisecond);
 
 /* rtcCalendarControl_getAlarm_A
  *
@@ -122,6 +302,7 @@ RtcUtilsStatus rtcCalendarControl_setAlarm_A(const uint8_t day, const uint8_t ho
  *	hour - two digit hour in 24 hour format (0 - 23)
  *	minute - two digit minute 				(0 - 59)
  *	second - two digit second 				(0 - 59)
+ *	millisecond - millisecond of the second	(0 - 999)
  *
  * Return:
  *	RtcUtilsStatus
@@ -134,7 +315,7 @@ RtcUtilsStatus rtcCalendarControl_setAlarm_A(const uint8_t day, const uint8_t ho
  */
 RtcUtilsStatus rtcCalendarControl_getAlarm_A(uint8_t* const year, uint8_t* const month,
 		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
-		uint8_t* const second);
+		uint8_t* const second, uint16_t* const millisecond);
 
 /* rtcCalendarControl_diableAlarm_A
  *
@@ -148,5 +329,132 @@ RtcUtilsStatus rtcCalendarControl_getAlarm_A(uint8_t* const year, uint8_t* const
  */
 RtcUtilsStatus rtcCalendarControl_diableAlarm_A(void);
 
+/* rtcCalendarControl_armEncoded_A
+ *
+ * Function:
+ *	Arm Alarm A with register values from rtcCalendarControl_encodeAlarm().
+ *
+ * Parameters:
+ *	regs - pointer to the encoded register values
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_TIMEOUT - if the alarm did not read back as armed
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	Safe to call from the RTC alarm interrupt, does not use the HAL RTC lock.
+ */
+RtcUtilsStatus rtcCalendarControl_armEncoded_A(const RtcAlarmRegisters* const regs);
+
+/* rtcCalendarControl_setAlarm_B
+ *
+ * Function:
+ *	Set the date and time for Alarm B to fire.
+ *
+ * Parameters:
+ *	year - two digit 21st century year 		(0 - 99)
+ *	month - two digit month 				(1 - 12)
+ *	day - two digit day of month 			(1 - 28/29/30/31)
+ *	hour - two digit hour in 24 hour format (0 - 23)
+ *	minute - two digit minute 				(0 - 59)
+ *	second - two digit second 				(0 - 59)
+ *	millisecond - millisecond of the second	(0 - 999), compared against
+ *			the RTC's sub-second counter
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	The BCD backend matches the day of the month and time, the alarm fires on
+ *	their next match.  See rtcCalendarControl_isAlarmDirect().  It only uses the
+ *	year and month to carry a millisecond within the last sub-second tick into
+ *	the next second.
+ */
+RtcUtilsStatus rtcCalendarControl_setAlarm_B(const uint8_t year, const uint8_t month,
+		const uint8_t day, const uint8_t hour, const uint8_t minute,
+		const uint8_t second, const uint16_t millisecond);
+
+/* rtcCalendarControl_getAlarm_B
+ *
+ * Function:
+ *	Get the current alarm values from Alarm B.
+ *
+ * Parameters:
+ *	Pointers to store copy of date and time.  Will set values to:
+ *	day - two digit day of month 			(1 - 28/29/30/31)
+ *	hour - two digit hour in 24 hour format (0 - 23)
+ *	minute - two digit minute 				(0 - 59)
+ *	second - two digit second 				(0 - 59)
+ *	millisecond - millisecond of the second	(0 - 999)
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	Getting the alarm B date/time does not distinguish if the alarm is enabled
+ *	or disabled.
+ */
+RtcUtilsStatus rtcCalendarControl_getAlarm_B(uint8_t* const year, uint8_t* const month,
+		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
+		uint8_t* const second, uint16_t* const millisecond);
+
+/* rtcCalendarControl_diableAlarm_B
+ *
+ * Function:
+ *	Disables Alarm B.
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ */
+RtcUtilsStatus rtcCalendarControl_diableAlarm_B(void);
+
+/* rtcCalendarControl_armEncoded_B
+ *
+ * Function:
+ *	Arm Alarm B with register values from rtcCalendarControl_encodeAlarm().
+ *
+ * Parameters:
+ *	regs - pointer to the encoded register values
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_TIMEOUT - if the alarm did not read back as armed
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	Safe to call from the RTC alarm interrupt, does not use the HAL RTC lock.
+ */
+RtcUtilsStatus rtcCalendarControl_armEncoded_B(const RtcAlarmRegisters* const regs);
+
+/* rtcCalendarControl_encodeAlarm
+ *
+ * Function:
+ *	Encode the register values of an alarm at a date and time, for arming later
+ *	with rtcCalendarControl_armEncoded_A() or rtcCalendarControl_armEncoded_B().
+ *
+ * Parameters:
+ *	alarm - date and time for the alarm to fire
+ *	regs - pointer to store the encoded register values
+ *
+ * Return:
+ *	RtcUtilsStatus
+ *		RTC_CALENDAR_CONTROL_NOT_INIT - if module has not been initialized
+ *		RTC_CALENDAR_CONTROL_OKAY - otherwise
+ *
+ * Note:
+ *	Encoded values stay valid while the RTC's date and time is not set.
+ */
+RtcUtilsStatus rtcCalendarControl_encodeAlarm(const DateTime alarm,
+		RtcAlarmRegisters* const regs);
+
 
 #endif
@@ -0,0 +1,149 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ */
+
+
+#include <calendar_trace.h>
+#include <string.h>
+
+
+#ifdef CALENDAR_TRACE
+
+
+/*
+ * Private function prototypes.
+ */
+uint32_t _takeTraceSlot(void);
+
+
+/*
+ * Static operational variables for module operation across function calls.
+ */
+static volatile CalendarTrace _trace;	// the trace buffer
+
+
+/* calendarTrace_init
+ *
+ * Clears the trace buffer.
+ */
+void calendarTrace_init(void)
+{
+	memset((void*)&_trace, 0, sizeof(_trace));
+
+	_trace.size = CALENDAR_TRACE_SIZE;
+	_trace.recordSize = sizeof(CalendarTraceRecord);
+	_trace.magic = CALENDAR_TRACE_MAGIC;
+}
+
+
+/* calendarTrace_record
+ *
+ * Takes the next slot and writes a record to it.  The sequence is cleared while
+ * the record is written so that readers can tell a partial record.
+ */
+void calendarTrace_record(const CalendarTraceType type, const uint16_t arg,
+		const uint32_t seconds)
+{
+	uint32_t index = _takeTraceSlot();
+	volatile CalendarTraceRecord* record = &_trace.records[index & (CALENDAR_TRACE_SIZE - 1U)];
+
+	record->sequence = 0;
+	__DMB();
+	record->seconds = seconds;
+	record->tick = HAL_GetTick();
+	record->type = (uint16_t)type;
+	record->arg = arg;
+	__DMB();
+	record->sequence = index + 1U;
+}
+
+
+/* calendarTrace_read
+ *
+ * Copies the record at the cursor, checking its sequence before and after the
+ * copy.  Skips the cursor ahead past records that were overwritten.
+ */
+bool calendarTrace_read(uint32_t* const cursor, CalendarTraceRecord* const record)
+{
+	volatile CalendarTraceRecord* slot;
+	uint32_t head;
+	uint32_t sequence;
+
+	while (true)
+	{
+		head = _trace.head;
+
+		// no new records
+		if (*cursor == head)
+			return false;
+
+		// records behind the buffer were overwritten
+		if ((head - *cursor) > CALENDAR_TRACE_SIZE)
+			*cursor = head - CALENDAR_TRACE_SIZE;
+
+		slot = &_trace.records[*cursor & (CALENDAR_TRACE_SIZE - 1U)];
+		sequence = slot->sequence;
+		__DMB();
+		record->seconds = slot->seconds;
+		record->tick = slot->tick;
+		record->type = slot->type;
+		record->arg = slot->arg;
+		__DMB();
+
+		// the record was complete and not overwritten while copying
+		if (sequence == *cursor + 1U && slot->sequence == sequence)
+		{
+			record->sequence = sequence;
+			(*cursor)++;
+			return true;
+		}
+
+		// the record is still being written
+		if (sequence == 0U || sequence < *cursor + 1U)
+			return false;
+
+		// the record was overwritten, read again from the oldest
+	}
+}
+
+
+/* calendarTrace_getBuffer
+ *
+ * Gets the trace buffer.
+ */
+const volatile CalendarTrace* calendarTrace_getBuffer(void)
+{
+	return &_trace;
+}
+
+
+/* _takeTraceSlot
+ *
+ * Takes the index of the next record, incrementing the head in one step with
+ * interrupts.  Uses exclusive access on cores that have it (Cortex-M3 and up),
+ * and masks interrupts for the increment otherwise (Cortex-M0+).
+ */
+uint32_t _takeTraceSlot(void)
+{
+	uint32_t index;
+
+#if (__CORTEX_M >= 3U)
+	do
+	{
+		index = __LDREXW(&_trace.head);
+	} while (__STREXW(index + 1U, &_trace.head) != 0U);
+#else
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	index = _trace.head;
+	_trace.head = index + 1U;
+	__set_PRIMASK(primask);
+#endif
+
+	return index;
+}
+
+
+#endif /* CALENDAR_TRACE */
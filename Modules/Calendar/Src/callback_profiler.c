@@ -0,0 +1,133 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ */
+
+
+#include <callback_profiler.h>
+#include <string.h>
+
+
+/* callbackProfiler_initCycles
+ *
+ * Starts the cycle counter.  SysTick is already running on the Cortex-M0+.
+ */
+void callbackProfiler_initCycles(void)
+{
+#if (__CORTEX_M >= 3U)
+	// enable the DWT and its cycle counter
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+
+/* callbackProfiler_readCycles
+ *
+ * Reads the cycle count.  On the Cortex-M0+ the count is built from the HAL's
+ * tick and SysTick's down counter, reading the tick again to catch a reload
+ * between the two reads.
+ */
+uint32_t callbackProfiler_readCycles(void)
+{
+#if (__CORTEX_M >= 3U)
+	return DWT->CYCCNT;
+#else
+	uint32_t tick;
+	uint32_t value;
+
+	do
+	{
+		tick = HAL_GetTick();
+		value = SysTick->VAL;
+	} while (tick != HAL_GetTick());
+
+	return ((tick / HAL_GetTickFreq()) * (SysTick->LOAD + 1U)) + (SysTick->LOAD - value);
+#endif
+}
+
+
+#ifdef CALENDAR_PROFILE_CALLBACKS
+
+
+/*
+ * Running timing of the callbacks of one event.
+ */
+typedef struct {
+	uint32_t count;
+	uint32_t minCycles;
+	uint32_t maxCycles;
+	uint64_t totalCycles;
+	uint32_t overBudget;
+} ProfileStats;
+
+
+/*
+ * Static operational variables for module operation across function calls.
+ */
+static ProfileStats _stats[MAX_NUM_EVENTS];	// timing of each event's callbacks
+
+
+/* callbackProfiler_init
+ *
+ * Clears the timing of all events.
+ */
+void callbackProfiler_init(void)
+{
+	memset(_stats, 0, sizeof(_stats));
+}
+
+
+/* callbackProfiler_run
+ *
+ * Calls a callback and adds the cycles it took to the event's timing.
+ */
+void callbackProfiler_run(const int id, void (*callback)(void))
+{
+	uint32_t start;
+	uint32_t cycles;
+	ProfileStats* stats = &_stats[id];
+
+	start = callbackProfiler_readCycles();
+	(*callback)();
+	cycles = callbackProfiler_readCycles() - start;
+
+	if (stats->count == 0 || cycles < stats->minCycles)
+		stats->minCycles = cycles;
+	if (cycles > stats->maxCycles)
+		stats->maxCycles = cycles;
+	if (cycles > CALENDAR_CALLBACK_BUDGET_CYCLES)
+		stats->overBudget++;
+	stats->totalCycles += cycles;
+	stats->count++;
+}
+
+
+/* callbackProfiler_get
+ *
+ * Gets the timing of an event's callbacks, with the mean of the cycles.
+ */
+void callbackProfiler_get(const int id, CallbackProfile* const profile)
+{
+	const ProfileStats* stats = &_stats[id];
+
+	profile->count = stats->count;
+	profile->minCycles = stats->minCycles;
+	profile->maxCycles = stats->maxCycles;
+	profile->meanCycles = (stats->count == 0) ? 0 : (uint32_t)(stats->totalCycles / stats->count);
+	profile->overBudget = stats->overBudget;
+}
+
+
+/* callbackProfiler_clear
+ *
+ * Clears the timing of an event.
+ */
+void callbackProfiler_clear(const int id)
+{
+	memset(&_stats[id], 0, sizeof(ProfileStats));
+}
+
+
+#endif /* CALENDAR_PROFILE_CALLBACKS */
@@ -14,7 +14,16 @@
 void _copyEvent(struct CalendarEvent* const to, const struct CalendarEvent* const from);
 void _copyDateTime(DateTime* const to, DateTime* const from);
 int32_t _compareDateTime(DateTime dateTime_1, DateTime dateTime_2);
-uint32_t _dateTimeToSeconds(DateTime dateTime);
+bool _findNextAlarm(Event_SLL* const sll, const DateTime dateTime, DateTime* const alarm,
+		int* const inProgress);
+bool _isTrigger(const struct CalendarEvent* const event);
+void _takeEarlier(DateTime* const alarm, bool* const hasAlarm, DateTime* const candidate);
+bool _getPrepare(const struct CalendarEvent* const event, DateTime* const prepare);
+
+
+#ifdef EVENT_SLL_COUNT_VISITS
+uint32_t eventSLL_visits = 0;	// nodes stepped through
+#endif
 
 
 /* eventSLL_reset
@@ -81,11 +90,10 @@ bool eventSLL_insert(Event_SLL* const sll, const struct CalendarEvent event)
 			if (_compareDateTime(event.start, sll->events[sll->usedHead].event.start) < 0)
 			{
 				// take from head of free nodes and move to start of used nodes
-				tempIdx = sll->usedHead;							// store head of used in temp
-				sll->events[sll->usedHead].next = sll->freeHead;	// point head of used to head of free
-				sll->freeHead = sll->events[sll->freeHead].next;	// point head of free to next of free
-				toInsertIdx = sll->usedHead;
-				sll->events[toInsertIdx].next = tempIdx;			// point head of used to stored in temp
+				toInsertIdx = sll->freeHead;						// take head of free
+				sll->freeHead = sll->events[toInsertIdx].next;		// point head of free to next of free
+				sll->events[toInsertIdx].next = sll->usedHead;		// point new node to head of used
+				sll->usedHead = toInsertIdx;						// point head of used to new node
 			}
 
 			// if inserting not at the start
@@ -93,13 +101,17 @@ bool eventSLL_insert(Event_SLL* const sll, const struct CalendarEvent event)
 			{
 				// find node previous to where to insert
 				prevToInsertIdx = sll->usedHead;
-				// while insert event's start time is less than each event's start time
-				// already in the list, iterate list
+				// while insert event's start time is not less than the next event's
+				// start time already in the list, iterate list
 				// if the start times are equal, then inserting after the current iteration
 				// does not care about end times of events
-				while (_compareDateTime(event.start, sll->events[prevToInsertIdx].event.start) >= 0
-						&& sll->events[prevToInsertIdx].next != EVENTS_SLL_NO_EVENT)
+				while (sll->events[prevToInsertIdx].next != EVENTS_SLL_NO_EVENT
+						&& _compareDateTime(event.start,
+								sll->events[sll->events[prevToInsertIdx].next].event.start) >= 0)
+				{
+					EVENT_SLL_VISIT();
 					prevToInsertIdx = sll->events[prevToInsertIdx].next;
+				}
 
 				// perform insert
 				tempIdx = sll->events[prevToInsertIdx].next;		// store previous to insert in temp
@@ -144,12 +156,13 @@ bool eventSLL_remove(Event_SLL* const sll, const unsigned int id)
 	if (sll->events[id].id != EVENTS_SLL_NO_EVENT)
 	{
 		// if list is not empty
-		if (sll->count < MAX_NUM_EVENTS)
+		if (sll->count > 0)
 		{
 			// if removing from beginning
-			if (id == sll->usedHead)
+			if ((int)id == sll->usedHead)
 			{
 				// move from front of used to front of free
+				toRemoveIdx = sll->usedHead;
 				tempIdx = sll->events[sll->usedHead].next;			// store next to first used in temp
 				sll->events[sll->usedHead].next = sll->freeHead;	// point fist used to first of free
 				sll->freeHead = sll->usedHead;						// point head of free to first used
@@ -163,8 +176,9 @@ bool eventSLL_remove(Event_SLL* const sll, const unsigned int id)
 				prevToRemoveIdx = sll->usedHead;
 				toRemoveIdx = sll->events[prevToRemoveIdx].next;
 				// iterate until found
-				while (sll->events[toRemoveIdx].id != id)
+				while (sll->events[toRemoveIdx].id != (int)id)
 				{
+					EVENT_SLL_VISIT();
 					prevToRemoveIdx = toRemoveIdx;
 					toRemoveIdx = sll->events[prevToRemoveIdx].next;
 				}
@@ -172,7 +186,7 @@ bool eventSLL_remove(Event_SLL* const sll, const unsigned int id)
 				// perform removal
 				tempIdx = sll->freeHead;									// store first free in temp
 				sll->freeHead = toRemoveIdx;								// point free head to remove
-				sll->events[prevToRemoveIdx].next = EVENTS_SLL_NO_EVENT;	// point previous to remove to none
+				sll->events[prevToRemoveIdx].next = sll->events[toRemoveIdx].next;	// point previous to remove to its next
 				sll->events[toRemoveIdx].next = tempIdx;					// point remove next to temp
 
 			}
@@ -228,46 +242,286 @@ bool eventSLL_peekIdx(Event_SLL* const sll, const unsigned int id, struct Calend
  * or end alarm for an event.
  */
 bool eventSLL_getNextAlarm(Event_SLL* const sll, const DateTime dateTime, DateTime* const alarm)
+{
+	return _findNextAlarm(sll, dateTime, alarm, &(sll->inProgress));
+}
+
+
+/* eventSLL_peekNextAlarm
+ *
+ * Finds the next alarm to a given DateTime without changing the event in
+ * progress.
+ */
+bool eventSLL_peekNextAlarm(Event_SLL* const sll, const DateTime dateTime, DateTime* const alarm)
+{
+	int inProgress;
+
+	return _findNextAlarm(sll, dateTime, alarm, &inProgress);
+}
+
+
+/* eventSLL_peekInProgress
+ *
+ * Finds the event in progress at a given DateTime without changing the event in
+ * progress.
+ */
+int eventSLL_peekInProgress(Event_SLL* const sll, const DateTime dateTime)
+{
+	DateTime alarm;
+	int inProgress;
+
+	_findNextAlarm(sll, dateTime, &alarm, &inProgress);
+
+	return inProgress;
+}
+
+
+/* eventSLL_nextTrigger
+ *
+ * Finds the next trigger at a given DateTime after the trigger at idx, in list
+ * order.
+ */
+bool eventSLL_nextTrigger(Event_SLL* const sll, const DateTime dateTime, int* const idx)
+{
+	int nodeIdx;
+
+	nodeIdx = (*idx == EVENTS_SLL_NO_EVENT) ? sll->usedHead : sll->events[*idx].next;
+	while (nodeIdx != EVENTS_SLL_NO_EVENT)
+	{
+		EVENT_SLL_VISIT();
+		// events are ordered by start, no triggers at the DateTime follow
+		if (_compareDateTime(sll->events[nodeIdx].event.start, dateTime) > 0)
+			break;
+
+		if (_isTrigger(&(sll->events[nodeIdx].event))
+				&& _compareDateTime(sll->events[nodeIdx].event.start, dateTime) == 0)
+		{
+			*idx = nodeIdx;
+			return true;
+		}
+
+		nodeIdx = sll->events[nodeIdx].next;
+	}
+
+	return false;
+}
+
+
+/* eventSLL_nextPrepare
+ *
+ * Finds the next event prepared at a given DateTime after the event at idx, in
+ * list order.
+ */
+bool eventSLL_nextPrepare(Event_SLL* const sll, const DateTime dateTime, int* const idx)
+{
+	int nodeIdx;
+	DateTime prepare;
+
+	nodeIdx = (*idx == EVENTS_SLL_NO_EVENT) ? sll->usedHead : sll->events[*idx].next;
+	while (nodeIdx != EVENTS_SLL_NO_EVENT)
+	{
+		EVENT_SLL_VISIT();
+		if (_getPrepare(&(sll->events[nodeIdx].event), &prepare)
+				&& _compareDateTime(prepare, dateTime) == 0)
+		{
+			*idx = nodeIdx;
+			return true;
+		}
+
+		nodeIdx = sll->events[nodeIdx].next;
+	}
+
+	return false;
+}
+
+
+/* eventSLL_getSlack
+ *
+ * Finds the least slack of the events that start or end at an alarm.  No slack if
+ * an event is prepared at the alarm.
+ */
+uint16_t eventSLL_getSlack(Event_SLL* const sll, const DateTime alarm)
 {
 	int idx;
+	uint16_t slack = 0;
+	bool hasSlack = false;
+	DateTime prepare;
 
 	idx = sll->usedHead;
 	while (idx != EVENTS_SLL_NO_EVENT)
 	{
-		// if the current iteration's end time has past
-		// mark as past
-		if (_compareDateTime(dateTime, sll->events[idx].event.end) >= 0)
+		EVENT_SLL_VISIT();
+		// a prepare is never run late
+		if (_getPrepare(&(sll->events[idx].event), &prepare)
+				&& _compareDateTime(prepare, alarm) == 0)
 		{
-			// go to next event
-			idx = sll->events[idx].next;
+			return 0;
 		}
 
-		// now is within event
-		// return alarm for end of event
-		else if (_compareDateTime(dateTime, sll->events[idx].event.start) >= 0)
+		if ((_compareDateTime(sll->events[idx].event.start, alarm) == 0
+				|| _compareDateTime(sll->events[idx].event.end, alarm) == 0)
+				&& (!hasSlack || sll->events[idx].event.slack < slack))
 		{
-			// set sll inProgress pointer to this event and exit
-			sll->inProgress = idx;
-			_copyDateTime(alarm, &(sll->events[idx].event.end));
-			return true;
+			slack = sll->events[idx].event.slack;
+			hasSlack = true;
 		}
 
-		// event is in the future (next)
-		// return alarm for start of event
-		else
+		idx = sll->events[idx].next;
+	}
+
+	return slack;
+}
+
+
+/* eventSLL_getLatencyClass
+ *
+ * Finds the latency class of the first event that starts, ends, or is prepared at
+ * an alarm.
+ */
+bool eventSLL_getLatencyClass(Event_SLL* const sll, const DateTime alarm,
+		uint8_t* const latencyClass)
+{
+	int idx;
+	DateTime prepare;
+
+	idx = sll->usedHead;
+	while (idx != EVENTS_SLL_NO_EVENT)
+	{
+		EVENT_SLL_VISIT();
+		if (_compareDateTime(sll->events[idx].event.start, alarm) == 0
+				|| _compareDateTime(sll->events[idx].event.end, alarm) == 0
+				|| (_getPrepare(&(sll->events[idx].event), &prepare)
+						&& _compareDateTime(prepare, alarm) == 0))
 		{
-			sll->inProgress = EVENTS_SLL_NO_EVENT;
-			_copyDateTime(alarm, &(sll->events[idx].event.start));
+			*latencyClass = sll->events[idx].event.latency_class;
 			return true;
 		}
+
+		idx = sll->events[idx].next;
 	}
 
-	// no alarms to set
-	sll->inProgress = EVENTS_SLL_NO_EVENT;
 	return false;
 }
 
 
+/* _findNextAlarm
+ *
+ * Finds the next alarm to set to a given DateTime and the event that is in
+ * progress at that DateTime.  This will be either the start or end alarm for
+ * an event, or a trigger or prepare if one comes first.  Triggers are never in
+ * progress.
+ */
+bool _findNextAlarm(Event_SLL* const sll, const DateTime dateTime, DateTime* const alarm,
+		int* const inProgress)
+{
+	int idx;
+	bool hasAlarm = false;
+	bool hasEvent = false;
+	DateTime prepare;
+
+	*inProgress = EVENTS_SLL_NO_EVENT;
+
+	// prepares in the future, these are not ordered
+	idx = sll->usedHead;
+	while (idx != EVENTS_SLL_NO_EVENT)
+	{
+		EVENT_SLL_VISIT();
+		if (_getPrepare(&(sll->events[idx].event), &prepare)
+				&& _compareDateTime(dateTime, prepare) < 0)
+			_takeEarlier(alarm, &hasAlarm, &prepare);
+
+		idx = sll->events[idx].next;
+	}
+
+	idx = sll->usedHead;
+	while (idx != EVENTS_SLL_NO_EVENT)
+	{
+		EVENT_SLL_VISIT();
+		// events are ordered by start, none that follow can be earlier
+		if (hasAlarm && _compareDateTime(sll->events[idx].event.start, *alarm) >= 0)
+		{
+			break;
+		}
+
+		// trigger in the future
+		else if (_isTrigger(&(sll->events[idx].event)))
+		{
+			if (_compareDateTime(dateTime, sll->events[idx].event.start) < 0)
+				_takeEarlier(alarm, &hasAlarm, &(sll->events[idx].event.start));
+		}
+
+		// the first event that has not ended is in progress or next, the events
+		// after it are not
+		else if (!hasEvent && _compareDateTime(dateTime, sll->events[idx].event.end) < 0)
+		{
+			hasEvent = true;
+
+			// now is within event
+			// alarm for end of event
+			if (_compareDateTime(dateTime, sll->events[idx].event.start) >= 0)
+			{
+				*inProgress = idx;
+				_takeEarlier(alarm, &hasAlarm, &(sll->events[idx].event.end));
+			}
+
+			// event is in the future (next)
+			// alarm for start of event
+			else
+			{
+				_takeEarlier(alarm, &hasAlarm, &(sll->events[idx].event.start));
+			}
+		}
+
+		// go to next event
+		idx = sll->events[idx].next;
+	}
+
+	return hasAlarm;
+}
+
+
+/* _isTrigger
+ *
+ * Checks if an event is a trigger, with the same start and end.
+ */
+bool _isTrigger(const struct CalendarEvent* const event)
+{
+	return _compareDateTime(event->start, event->end) == 0;
+}
+
+
+/* _takeEarlier
+ *
+ * Copies a candidate alarm into the alarm if there is no alarm yet or the
+ * candidate is earlier.
+ */
+void _takeEarlier(DateTime* const alarm, bool* const hasAlarm, DateTime* const candidate)
+{
+	if (!*hasAlarm || _compareDateTime(*candidate, *alarm) < 0)
+	{
+		_copyDateTime(alarm, candidate);
+		*hasAlarm = true;
+	}
+}
+
+
+/* _getPrepare
+ *
+ * Gets the date and time to prepare an event at, its start less its lead time.
+ * Returns false if the event has no prepare callback or lead time.
+ */
+bool _getPrepare(const struct CalendarEvent* const event, DateTime* const prepare)
+{
+	if (event->prepare_callback == NULL || event->lead == 0)
+		return false;
+
+	*prepare = event->start;
+	dateTime_addMillis(prepare, -(int32_t)event->lead);
+
+	return true;
+}
+
+
 /* _copyEvent
  *
  * Copy the contents of one CalenderEvent into another.
@@ -280,6 +534,7 @@ void _copyEvent(struct CalendarEvent* const to, const struct CalendarEvent* cons
 	to->start.hour = from->start.hour;
 	to->start.minute = from->start.minute;
 	to->start.second = from->start.second;
+	to->start.millisecond = from->start.millisecond;
 	to->start_callback = from->start_callback;
 	to->end.year = from->end.year;
 	to->end.month = from->end.month;
@@ -287,7 +542,12 @@ void _copyEvent(struct CalendarEvent* const to, const struct CalendarEvent* cons
 	to->end.hour = from->end.hour;
 	to->end.minute = from->end.minute;
 	to->end.second = from->end.second;
+	to->end.millisecond = from->end.millisecond;
 	to->end_callback = from->end_callback;
+	to->slack = from->slack;
+	to->prepare_callback = from->prepare_callback;
+	to->lead = from->lead;
+	to->latency_class = from->latency_class;
 }
 
 
@@ -303,42 +563,35 @@ void _copyDateTime(DateTime* const to, DateTime* const from)
 	to->hour = from->hour;
 	to->minute = from->minute;
 	to->second = from->second;
+	to->millisecond = from->millisecond;
 }
 
 
 /* _compareDateTime
  *
- * Find the time difference in seconds of dateTime1 and dateTime2.
+ * Compare dateTime1 to dateTime2.  Negative if dateTime1 is earlier, positive if
+ * it is later, and 0 if they are equal.  Use only for the sign of the comparison.
  *
- * Note: Does not account for leap years.
+ * Note: compares seconds since the start of the century (dateTime_toSeconds()),
+ * which accounts for month lengths and leap years.
  */
 int32_t _compareDateTime(DateTime dateTime_1, DateTime dateTime_2)
 {
 	uint32_t dateTimeSeconds_1, dateTimeSeconds_2;
 
-	dateTimeSeconds_1 = _dateTimeToSeconds(dateTime_1);
-	dateTimeSeconds_2 = _dateTimeToSeconds(dateTime_2);
-
-	// return net comparison (date time 1 - date time 2)
-	return dateTimeSeconds_1 - dateTimeSeconds_2;
-}
+	dateTimeSeconds_1 = dateTime_toSeconds(dateTime_1);
+	dateTimeSeconds_2 = dateTime_toSeconds(dateTime_2);
 
+	// compare seconds, the difference can be outside the range of int32_t
+	if (dateTimeSeconds_1 < dateTimeSeconds_2)
+	{
+		return -1;
+	}
+	else if (dateTimeSeconds_1 > dateTimeSeconds_2)
+	{
+		return 1;
+	}
 
-/* _dateTimeToSeconds
- *
- * Converts a date and time to seconds since the start of the century.  Use only
- * for for comparing date/time in seconds, not for absolute date/time in seconds.
- *
- * Note: assumes 30 days in a month and no leap years, it is not needed for the
- * calculation because they are used for relative comparisons, not absolute values.
- */
-uint32_t _dateTimeToSeconds(DateTime dateTime)
-{
-	// Convert to seconds
-	return (dateTime.second
-			+ (dateTime.minute * 60)
-			+ (dateTime.hour * 3600)
-			+ ((dateTime.day - 1) * 86400)
-			+ ((dateTime.month - 1) * 2592000)
-			+ (dateTime.year * 31104000));
+	// within the same second, compare milliseconds
+	return (int32_t)dateTime_1.millisecond - (int32_t)dateTime_2.millisecond;
 }
@@ -1,11 +1,19 @@
 /*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
  *
+ * BCD backend for RTC Calendar Control.  The RTC runs in BCD mode and alarms
+ * match the day of the month and time.
  */
 
 #include <rtc_calendar_control.h>
+#include <rtc_alarm_driver.h>
 #include <stdbool.h>
 
 
+#ifndef RTC_CALENDAR_CONTROL_BINARY
+
+
 /*
  * Macro function to check if the RTC has been initialized in HAL
  * and within this module.
@@ -13,6 +21,24 @@
 #define IS_RTC_INIT(rtc_handle) (rtc_handle != NULL && rtc_handle->Instance != NULL)
 
 
+/*
+ * Private function prototypes.
+ */
+RtcUtilsStatus _setAlarm(const uint32_t whichAlarm, const DateTime alarm);
+RtcUtilsStatus _getAlarm(const uint32_t whichAlarm, uint8_t* const year,
+		uint8_t* const month, uint8_t* const day, uint8_t* const hour,
+		uint8_t* const minute, uint8_t* const second, uint16_t* const millisecond);
+RtcUtilsStatus _disableAlarm(const uint32_t whichAlarm);
+RtcUtilsStatus _armEncoded(const uint32_t whichAlarm, const RtcAlarmRegisters* const regs);
+uint16_t _subSecondsToMillis(const uint32_t subSeconds);
+uint32_t _millisToTicks(const uint16_t millisecond);
+void _firstMatch(const DateTime now, const uint8_t day, const DateTime timeOfDay,
+		DateTime* const match);
+bool _isBefore(const DateTime a, const DateTime b);
+void _registersToEpoch(const uint32_t subSecondReg, const uint32_t timeReg,
+		const uint32_t dateReg, uint32_t* const seconds, uint16_t* const millisecond);
+
+
 /*
  * Static operational variable to point to HAL RTC handle for module operation
  * across function calls.
@@ -20,6 +46,13 @@
 RTC_HandleTypeDef* _rtc_handle;
 
 
+/*
+ * Milliseconds in a second, over which the SynchPrediv + 1 sub-second ticks are
+ * spread evenly.
+ */
+#define MILLIS_PER_SECOND 1000U
+
+
 /* rtcCalendarControl_init
  *
  * Initializes the module and stores a pointer to the HAL RTC handle.
@@ -94,10 +127,14 @@ RtcUtilsStatus rtcCalendarControl_setDateTime(const uint8_t year, const uint8_t
 /* rtcCalendarControl_getDateTime
  *
  * Gets the date and time within the RTC.
+ *
+ * Note: reading the sub-seconds and time (HAL_RTC_GetTime()) locks the date in
+ * the shadow registers until it is read (HAL_RTC_GetDate()), so the values are
+ * consistent with each other.
  */
 RtcUtilsStatus rtcCalendarControl_getDateTime(uint8_t* const year, uint8_t* const month,
 		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
-		uint8_t* const second)
+		uint8_t* const second, uint16_t* const millisecond)
 {
 	RTC_TimeTypeDef time = {0};
 	RTC_DateTypeDef date = {0};
@@ -116,6 +153,7 @@ RtcUtilsStatus rtcCalendarControl_getDateTime(uint8_t* const year, uint8_t* cons
 		*hour = RTC_Bcd2ToByte(time.Hours);
 		*minute = RTC_Bcd2ToByte(time.Minutes);
 		*second = RTC_Bcd2ToByte(time.Seconds);
+		*millisecond = _subSecondsToMillis(time.SubSeconds);
 
 		return RTC_CALENDAR_CONTROL_OKAY;
 	}
@@ -128,46 +166,188 @@ RtcUtilsStatus rtcCalendarControl_getDateTime(uint8_t* const year, uint8_t* cons
 }
 
 
-/* rtcCalendarControl_setAlarm_A
+/* rtcCalendarControl_getEpoch
  *
- * Sets and enables RTC Alarm A with an interrupt enabled.
+ * Gets the date and time within the RTC as seconds since the start of the
+ * century, reading the registers directly.
  *
- * Note: does not validate that parameters are within valid range.
+ * Note: reading the sub-seconds locks the time and date in the shadow registers,
+ * and reading the time locks the date, until the date is read.  Reading them in
+ * that order keeps the values consistent with each other.
+ */
+RtcUtilsStatus rtcCalendarControl_getEpoch(uint32_t* const seconds,
+		uint16_t* const millisecond)
+{
+	uint32_t subSecondReg, timeReg, dateReg;
+
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// read the registers once, in shadow register locking order
+		subSecondReg = READ_REG(_rtc_handle->Instance->SSR);
+		timeReg = READ_REG(_rtc_handle->Instance->TR);
+		dateReg = READ_REG(_rtc_handle->Instance->DR);
+
+		_registersToEpoch(subSecondReg, timeReg, dateReg, seconds, millisecond);
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_captureTimestamp
+ *
+ * Captures the RTC's registers, in shadow register locking order.
  */
-RtcUtilsStatus rtcCalendarControl_setAlarm_A(const uint8_t day, const uint8_t hour,
-		const uint8_t minute, const uint8_t second)
+RtcUtilsStatus rtcCalendarControl_captureTimestamp(RtcTimestamp* const timestamp)
 {
-  RTC_AlarmTypeDef alarm = {0};
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		timestamp->subSecondReg = READ_REG(_rtc_handle->Instance->SSR);
+		timestamp->timeReg = READ_REG(_rtc_handle->Instance->TR);
+		timestamp->dateReg = READ_REG(_rtc_handle->Instance->DR);
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
 
-  // if the module has been initialized
-  if (IS_RTC_INIT(_rtc_handle))
-  {
-	  // settings for alarm
-	  // convert decimal to BCD
-	  alarm.AlarmDateWeekDay = RTC_ByteToBcd2(day);
-	  alarm.AlarmTime.Hours = RTC_ByteToBcd2(hour);
-	  alarm.AlarmTime.Minutes = RTC_ByteToBcd2(minute);
-	  alarm.AlarmTime.Seconds = RTC_ByteToBcd2(second);
-	  // other settings for setting alarm
-	  alarm.AlarmTime.SubSeconds = 0x0;
-	  alarm.AlarmTime.DayLightSaving = RTC_DAYLIGHTSAVING_NONE;
-	  alarm.AlarmTime.StoreOperation = RTC_STOREOPERATION_RESET;
-	  alarm.AlarmMask = RTC_ALARMMASK_NONE;
-	  alarm.AlarmSubSecondMask = RTC_ALARMSUBSECONDMASK_ALL;
-	  alarm.AlarmDateWeekDaySel = RTC_ALARMDATEWEEKDAYSEL_DATE;
-	  alarm.Alarm = RTC_ALARM_A;
 
-	  // set the alarm and enable an interrupt to fire
-	  HAL_RTC_SetAlarm_IT(_rtc_handle, &alarm, RTC_FORMAT_BCD);
+/* rtcCalendarControl_timestampToEpoch
+ *
+ * Converts captured RTC registers to seconds since the start of the century.
+ */
+RtcUtilsStatus rtcCalendarControl_timestampToEpoch(const RtcTimestamp* const timestamp,
+		uint32_t* const seconds, uint16_t* const millisecond)
+{
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		_registersToEpoch(timestamp->subSecondReg, timestamp->timeReg,
+				timestamp->dateReg, seconds, millisecond);
 
-	  return RTC_CALENDAR_CONTROL_OKAY;
-  }
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
 
-  // the module has not been initialized
-  else
-  {
-	  return RTC_CALENDAR_CONTROL_NOT_INIT;
-  }
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_getResolution
+ *
+ * Gets the length of one tick of the RTC's sub-second counter in microseconds.
+ */
+RtcUtilsStatus rtcCalendarControl_getResolution(uint32_t* const resolution_us)
+{
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// one second is divided into SynchPrediv + 1 ticks
+		*resolution_us = 1000000 / (_rtc_handle->Init.SynchPrediv + 1);
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* rtcCalendarControl_isAlarmDirect
+ *
+ * Checks if an alarm armed now would first fire at its date and time, rather
+ * than at an earlier match of its day of month and time.  Month lengths are
+ * accounted for, a day of month missing from a month is not matched in it.
+ */
+bool rtcCalendarControl_isAlarmDirect(const DateTime now, const DateTime alarm)
+{
+	DateTime firstMatch;
+
+	_firstMatch(now, alarm.day, alarm, &firstMatch);
+
+	return !_isBefore(firstMatch, alarm) && !_isBefore(alarm, firstMatch);
+}
+
+
+/* rtcCalendarControl_planAlarm
+ *
+ * Plans the alarm to arm for a target date and time.  If the target can not be
+ * armed directly, finds the latest hop before the target that an alarm can reach
+ * from now.  Hops are taken at the target's time of day so that the last hop
+ * lands within reach of the target.
+ *
+ * Each day of the month is tried, the first match of each after now is where an
+ * alarm on it would fire.  Taking the latest of these before the target each time
+ * gives the fewest hops, as anything reachable from an earlier hop is also
+ * reachable from a later one.
+ */
+bool rtcCalendarControl_planAlarm(const DateTime now, const DateTime target,
+		DateTime* const alarm)
+{
+	DateTime candidate;
+	bool hasHop = false;
+	uint8_t day;
+
+	// target can be armed directly
+	if (rtcCalendarControl_isAlarmDirect(now, target))
+	{
+		*alarm = target;
+		return true;
+	}
+
+	// find the latest first match before the target
+	for (day = 1; day <= 31; day++)
+	{
+		_firstMatch(now, day, target, &candidate);
+
+		if (_isBefore(candidate, target) && (!hasHop || _isBefore(*alarm, candidate)))
+		{
+			*alarm = candidate;
+			hasHop = true;
+		}
+	}
+
+	// always found for a target beyond direct reach, fall back to the target
+	if (!hasHop)
+		*alarm = target;
+
+	return false;
+}
+
+
+/* rtcCalendarControl_setAlarm_A
+ *
+ * Sets and enables RTC Alarm A with an interrupt enabled.  The alarm matches the
+ * day of the month, the year and month only carry the last tick of a second.
+ *
+ * Note: does not validate that parameters are within valid range.
+ */
+RtcUtilsStatus rtcCalendarControl_setAlarm_A(const uint8_t year, const uint8_t month,
+		const uint8_t day, const uint8_t hour, const uint8_t minute,
+		const uint8_t second, const uint16_t millisecond)
+{
+	DateTime alarm = {year, month, day, hour, minute, second, millisecond};
+
+	return _setAlarm(RTC_ALARM_A, alarm);
 }
 
 
@@ -179,7 +359,166 @@ RtcUtilsStatus rtcCalendarControl_setAlarm_A(const uint8_t day, const uint8_t ho
  */
 RtcUtilsStatus rtcCalendarControl_getAlarm_A(uint8_t* const year, uint8_t* const month,
 		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
-		uint8_t* const second)
+		uint8_t* const second, uint16_t* const millisecond)
+{
+	return _getAlarm(RTC_ALARM_A, year, month, day, hour, minute, second, millisecond);
+}
+
+
+/* rtcCalendarControl_diableAlarm_A
+ *
+ * Disables alarm A from firing.
+ */
+RtcUtilsStatus rtcCalendarControl_diableAlarm_A(void)
+{
+	return _disableAlarm(RTC_ALARM_A);
+}
+
+
+/* rtcCalendarControl_armEncoded_A
+ *
+ * Arms alarm A with encoded register values.
+ */
+RtcUtilsStatus rtcCalendarControl_armEncoded_A(const RtcAlarmRegisters* const regs)
+{
+	return _armEncoded(RTC_ALARM_A, regs);
+}
+
+
+/* rtcCalendarControl_setAlarm_B
+ *
+ * Sets and enables RTC Alarm B with an interrupt enabled.  The alarm matches the
+ * day of the month, the year and month only carry the last tick of a second.
+ *
+ * Note: does not validate that parameters are within valid range.
+ */
+RtcUtilsStatus rtcCalendarControl_setAlarm_B(const uint8_t year, const uint8_t month,
+		const uint8_t day, const uint8_t hour, const uint8_t minute,
+		const uint8_t second, const uint16_t millisecond)
+{
+	DateTime alarm = {year, month, day, hour, minute, second, millisecond};
+
+	return _setAlarm(RTC_ALARM_B, alarm);
+}
+
+
+/* rtcCalendarControl_getAlarm_B
+ *
+ * Gets the day and time that RTC Alarm B is set to trigger.
+ *
+ * Note: Does not distinguish if the alarm is enabled or not.
+ */
+RtcUtilsStatus rtcCalendarControl_getAlarm_B(uint8_t* const year, uint8_t* const month,
+		uint8_t* const day, uint8_t* const hour, uint8_t* const minute,
+		uint8_t* const second, uint16_t* const millisecond)
+{
+	return _getAlarm(RTC_ALARM_B, year, month, day, hour, minute, second, millisecond);
+}
+
+
+/* rtcCalendarControl_diableAlarm_B
+ *
+ * Disables alarm B from firing.
+ */
+RtcUtilsStatus rtcCalendarControl_diableAlarm_B(void)
+{
+	return _disableAlarm(RTC_ALARM_B);
+}
+
+
+/* rtcCalendarControl_armEncoded_B
+ *
+ * Arms alarm B with encoded register values.
+ */
+RtcUtilsStatus rtcCalendarControl_armEncoded_B(const RtcAlarmRegisters* const regs)
+{
+	return _armEncoded(RTC_ALARM_B, regs);
+}
+
+
+/* _setAlarm
+ *
+ * Sets and enables an RTC alarm (RTC_ALARM_A or RTC_ALARM_B) with an interrupt
+ * enabled.  Skips the RTC if the alarm is already set to the day and time.
+ */
+RtcUtilsStatus _setAlarm(const uint32_t whichAlarm, const DateTime alarm)
+{
+	RtcAlarmRegisters regs;
+	RtcUtilsStatus status;
+
+	status = rtcCalendarControl_encodeAlarm(alarm, &regs);
+	if (status != RTC_CALENDAR_CONTROL_OKAY)
+		return status;
+
+	return _armEncoded(whichAlarm, &regs);
+}
+
+
+/* rtcCalendarControl_encodeAlarm
+ *
+ * Encodes the alarm register values for the day of the month and time of an
+ * alarm.  The year and month are not used.
+ */
+RtcUtilsStatus rtcCalendarControl_encodeAlarm(const DateTime alarm,
+		RtcAlarmRegisters* const regs)
+{
+	DateTime match = alarm;
+	uint32_t ticks;
+
+	// if the module has been initialized
+	if (IS_RTC_INIT(_rtc_handle))
+	{
+		// a millisecond within the last tick of the second is matched at the start
+		// of the next second
+		ticks = _millisToTicks(alarm.millisecond);
+		if (ticks > _rtc_handle->Init.SynchPrediv)
+		{
+			dateTime_addMillis(&match, (int32_t)(MILLIS_PER_SECOND - alarm.millisecond));
+			ticks = 0;
+		}
+
+		// match the date, hours, minutes and seconds in BCD
+		regs->alarmReg = ((uint32_t)RTC_ByteToBcd2(match.day) << RTC_ALRMAR_DU_Pos)
+				| ((uint32_t)RTC_ByteToBcd2(match.hour) << RTC_ALRMAR_HU_Pos)
+				| ((uint32_t)RTC_ByteToBcd2(match.minute) << RTC_ALRMAR_MNU_Pos)
+				| ((uint32_t)RTC_ByteToBcd2(match.second) << RTC_ALRMAR_SU_Pos)
+				| RTC_ALARMDATEWEEKDAYSEL_DATE
+				| RTC_ALARMMASK_NONE;
+
+		// compare all sub-second bits for millisecond resolution
+		regs->subSecondMaskReg = RTC_ALARMSUBSECONDMASK_NONE;
+		regs->subSeconds = _rtc_handle->Init.SynchPrediv - ticks;
+
+		return RTC_CALENDAR_CONTROL_OKAY;
+	}
+
+	// the module has not been initialized
+	else
+	{
+		return RTC_CALENDAR_CONTROL_NOT_INIT;
+	}
+}
+
+
+/* _armEncoded
+ *
+ * Arms an RTC alarm (RTC_ALARM_A or RTC_ALARM_B) with encoded register values.
+ */
+RtcUtilsStatus _armEncoded(const uint32_t whichAlarm, const RtcAlarmRegisters* const regs)
+{
+	return rtcAlarmDriver_arm(_rtc_handle, whichAlarm, regs->alarmReg,
+			regs->subSecondMaskReg, regs->subSeconds);
+}
+
+
+/* _getAlarm
+ *
+ * Gets the day and time that an RTC alarm (RTC_ALARM_A or RTC_ALARM_B) is set
+ * to trigger.
+ */
+RtcUtilsStatus _getAlarm(const uint32_t whichAlarm, uint8_t* const year,
+		uint8_t* const month, uint8_t* const day, uint8_t* const hour,
+		uint8_t* const minute, uint8_t* const second, uint16_t* const millisecond)
 {
 	RTC_AlarmTypeDef alarm = {0};
 
@@ -187,7 +526,7 @@ RtcUtilsStatus rtcCalendarControl_getAlarm_A(uint8_t* const year, uint8_t* const
 	if (IS_RTC_INIT(_rtc_handle))
 	{
 		// Get the alarm information.
-		HAL_RTC_GetAlarm(_rtc_handle, &alarm, RTC_ALARM_A, RTC_FORMAT_BCD);
+		HAL_RTC_GetAlarm(_rtc_handle, &alarm, whichAlarm, RTC_FORMAT_BCD);
 
 		// Return through parameters
 		*year = 0;
@@ -196,6 +535,7 @@ RtcUtilsStatus rtcCalendarControl_getAlarm_A(uint8_t* const year, uint8_t* const
 		*hour = RTC_Bcd2ToByte(alarm.AlarmTime.Hours);
 		*minute = RTC_Bcd2ToByte(alarm.AlarmTime.Minutes);
 		*second = RTC_Bcd2ToByte(alarm.AlarmTime.Seconds);
+		*millisecond = _subSecondsToMillis(alarm.AlarmTime.SubSeconds);
 
 		return RTC_CALENDAR_CONTROL_OKAY;
 	}
@@ -208,23 +548,128 @@ RtcUtilsStatus rtcCalendarControl_getAlarm_A(uint8_t* const year, uint8_t* const
 }
 
 
-/* rtcCalendarControl_diableAlarm_A
+/* _disableAlarm
  *
- * Disables alarm A from firing.
+ * Disables an RTC alarm (RTC_ALARM_A or RTC_ALARM_B) from firing.
  */
-RtcUtilsStatus rtcCalendarControl_diableAlarm_A(void)
+RtcUtilsStatus _disableAlarm(const uint32_t whichAlarm)
 {
-	// if the module has been initlaized
-	if (IS_RTC_INIT(_rtc_handle))
-	{
-		HAL_RTC_DeactivateAlarm(_rtc_handle, RTC_ALARM_A);
+	return rtcAlarmDriver_disarm(_rtc_handle, whichAlarm);
+}
 
-		return RTC_CALENDAR_CONTROL_OKAY;
-	}
 
-	// the module has not been initialized
-	else
+/* _subSecondsToMillis
+ *
+ * Converts the RTC's sub-second counter to milliseconds, rounded down.  The
+ * counter counts down from SynchPrediv to 0 over one second, each of its
+ * SynchPrediv + 1 ticks lasting the same time.
+ */
+uint16_t _subSecondsToMillis(const uint32_t subSeconds)
+{
+	uint32_t prediv = _rtc_handle->Init.SynchPrediv;
+
+	// guard against the counter being above the prescaler after a shift operation
+	if (subSeconds > prediv)
+		return 0;
+
+	return (uint16_t)(((prediv - subSeconds) * MILLIS_PER_SECOND) / (prediv + 1U));
+}
+
+
+/* _millisToTicks
+ *
+ * Converts milliseconds to the tick of the second they fall in, rounded up to the
+ * next tick so that the RTC never reads before the alarm's millisecond when the
+ * alarm fires.  Is SynchPrediv + 1, the start of the next second, for a
+ * millisecond after the last tick starts.
+ */
+uint32_t _millisToTicks(const uint16_t millisecond)
+{
+	uint32_t ticksPerSecond = _rtc_handle->Init.SynchPrediv + 1U;
+
+	return ((millisecond * ticksPerSecond) + (MILLIS_PER_SECOND - 1U)) / MILLIS_PER_SECOND;
+}
+
+
+
+/* _firstMatch
+ *
+ * Finds the first date and time after now that matches a day of the month and
+ * the time of day of timeOfDay.  This is where an alarm armed now with them
+ * fires.  Months without the day of the month are skipped.
+ */
+void _firstMatch(const DateTime now, const uint8_t day, const DateTime timeOfDay,
+		DateTime* const match)
+{
+	int i;
+
+	*match = timeOfDay;
+	match->year = now.year;
+	match->month = now.month;
+	match->day = day;
+
+	// a day of the month is missing from at most one month in a row, so the
+	// match is within the current month and the three following it
+	for (i = 0; i < 4; i++)
 	{
-		return RTC_CALENDAR_CONTROL_NOT_INIT;
+		if (day <= dateTime_daysInMonth(match->year, match->month)
+				&& _isBefore(now, *match))
+		{
+			return;
+		}
+
+		// move to the next month
+		if (match->month == 12)
+		{
+			match->month = 1;
+			match->year++;
+		}
+		else
+		{
+			match->month++;
+		}
 	}
 }
+
+
+/* _isBefore
+ *
+ * Checks if date and time a is before date and time b, to the millisecond.
+ */
+bool _isBefore(const DateTime a, const DateTime b)
+{
+	uint32_t aSeconds = dateTime_toSeconds(a);
+	uint32_t bSeconds = dateTime_toSeconds(b);
+
+	return aSeconds < bSeconds
+			|| (aSeconds == bSeconds && a.millisecond < b.millisecond);
+}
+
+
+
+/* _registersToEpoch
+ *
+ * Converts the RTC's sub-second, time, and date registers to seconds since the
+ * start of the century and milliseconds.  Decodes the BCD fields directly.
+ */
+void _registersToEpoch(const uint32_t subSecondReg, const uint32_t timeReg,
+		const uint32_t dateReg, uint32_t* const seconds, uint16_t* const millisecond)
+{
+	DateTime dateTime;
+
+	// convert BCD fields
+	dateTime.year = RTC_Bcd2ToByte((uint8_t)((dateReg & (RTC_DR_YT | RTC_DR_YU)) >> RTC_DR_YU_Pos));
+	dateTime.month = RTC_Bcd2ToByte((uint8_t)((dateReg & (RTC_DR_MT | RTC_DR_MU)) >> RTC_DR_MU_Pos));
+	dateTime.day = RTC_Bcd2ToByte((uint8_t)((dateReg & (RTC_DR_DT | RTC_DR_DU)) >> RTC_DR_DU_Pos));
+	dateTime.hour = RTC_Bcd2ToByte((uint8_t)((timeReg & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos));
+	dateTime.minute = RTC_Bcd2ToByte((uint8_t)((timeReg & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos));
+	dateTime.second = RTC_Bcd2ToByte((uint8_t)((timeReg & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos));
+
+	// Return through parameters
+	*seconds = dateTime_toSeconds(dateTime);
+	if (millisecond != NULL)
+		*millisecond = _subSecondsToMillis(subSecondReg);
+}
+
+
+#endif /* RTC_CALENDAR_CONTROL_BINARY */
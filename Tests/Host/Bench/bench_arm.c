@@ -0,0 +1,107 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Alarm arming: counts the RTC register accesses of arming an alarm from encoded
+ * register values, when the alarm is already armed with them and the write is
+ * skipped, and when it is written and confirmed.  Disarming is counted the same
+ * way.  Cycles are not counted, the host has no cycle counter.
+ */
+
+
+#include <host_test.h>
+#include <rtc_calendar_control.h>
+#include <stdio.h>
+
+
+/*
+ * Start of the calendar.
+ */
+static const DateTime START = {24, 5, 20, 6, 0, 0, 0};
+
+/*
+ * Number of arms of each path.
+ */
+#define NUM_ARMS 100
+
+
+/*
+ * Accesses of the arms of one path.
+ */
+typedef struct {
+	uint32_t arms;
+	uint32_t reads;
+	uint32_t writes;
+} ArmCost;
+
+
+/* _count
+ *
+ * Adds the accesses since the counters were reset to a path's cost.
+ */
+static void _count(ArmCost* const cost)
+{
+	VirtualRtcCounters rtc;
+
+	virtualRtc_getCounters(&rtc);
+	cost->arms++;
+	cost->reads += rtc.reads;
+	cost->writes += rtc.writes;
+}
+
+
+/* _print
+ *
+ * Reports the accesses per arm of a path.
+ */
+static void _print(const char* const path, const ArmCost* const cost)
+{
+	uint32_t arms = (cost->arms == 0U) ? 1U : cost->arms;
+
+	printf("%-14s %-6s %-4s %5u %9.1f %10.1f\n", path, HOST_TEST_BACKEND_NAME,
+			HOST_TEST_CORE_NAME, cost->arms, (double)cost->reads / arms,
+			(double)cost->writes / arms);
+}
+
+
+int main(void)
+{
+	RtcAlarmRegisters regs;
+	ArmCost written = {0};
+	ArmCost skipped = {0};
+	ArmCost disarmed = {0};
+	ArmCost disarmSkipped = {0};
+	int i;
+
+	hostTest_initCalendar(START);
+
+	// each alarm a second later than the last, armed twice, then disarmed twice
+	for (i = 0; i < NUM_ARMS; i++)
+	{
+		rtcCalendarControl_encodeAlarm(hostTest_dateTime(START, (uint64_t)(i + 1) * 1000U), &regs);
+
+		virtualRtc_resetCounters();
+		rtcCalendarControl_armEncoded_A(&regs);
+		_count(&written);
+
+		virtualRtc_resetCounters();
+		rtcCalendarControl_armEncoded_A(&regs);
+		_count(&skipped);
+
+		virtualRtc_resetCounters();
+		rtcCalendarControl_diableAlarm_A();
+		_count(&disarmed);
+
+		virtualRtc_resetCounters();
+		rtcCalendarControl_diableAlarm_A();
+		_count(&disarmSkipped);
+	}
+
+	printf("# path         backend core   arms reads/arm writes/arm\n");
+	_print("arm written", &written);
+	_print("arm skipped", &skipped);
+	_print("disarm written", &disarmed);
+	_print("disarm skipped", &disarmSkipped);
+
+	return 0;
+}
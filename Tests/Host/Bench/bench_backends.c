@@ -0,0 +1,125 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Backend comparison: runs the same schedule on the backend the module is built
+ * with, and reports the RTC register accesses and the wakeups it took.  Run
+ * from the bcd and binary builds (make bench) to compare the BCD and binary
+ * backends.
+ */
+
+
+#include <host_test.h>
+#include <stdio.h>
+
+
+/*
+ * Start of the schedule, a month before the end of a leap February.
+ */
+static const DateTime START = {24, 1, 30, 8, 0, 0, 0};
+
+/*
+ * Number of events, within MAX_NUM_EVENTS, and the days they are spread over.
+ */
+#define NUM_EVENTS 24
+#define SPREAD_DAYS 400U
+
+/*
+ * Number of time reads measured.
+ */
+#define NUM_READS 1000
+
+
+static uint32_t _callbacks;
+
+
+static void _onTransition(void)
+{
+	_callbacks++;
+}
+
+
+/* _random
+ *
+ * Gets the next number of a fixed pseudo-random sequence, so that every build
+ * runs the same schedule.
+ */
+static uint32_t _random(void)
+{
+	static uint64_t state = 12345U;
+
+	state = (state * 6364136223846793005ULL) + 1442695040888963407ULL;
+
+	return (uint32_t)(state >> 32);
+}
+
+
+/* _addSchedule
+ *
+ * Adds events at pseudo-random times over the spread, each between a second and
+ * two hours long, with a few clustered a second apart.
+ */
+static void _addSchedule(void)
+{
+	uint64_t startMillis;
+	uint64_t lengthMillis;
+	int i;
+
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		if (i % 8 == 7)
+			startMillis = ((uint64_t)(i / 8) * 86400000U) + 3600000U + ((i % 8) * 1000U);
+		else
+			startMillis = (uint64_t)(_random() % (SPREAD_DAYS * 86400U)) * 1000U
+					+ (_random() % 1000U);
+		lengthMillis = 1000U + (_random() % 7200000U);
+
+		CalendarEvent event = {
+			.start = hostTest_dateTime(START, startMillis),
+			.end = hostTest_dateTime(START, startMillis + lengthMillis),
+			.start_callback = _onTransition,
+			.end_callback = _onTransition,
+		};
+
+		calendar_addEvent(event);
+	}
+}
+
+
+int main(void)
+{
+	VirtualRtcCounters run;
+	VirtualRtcCounters read;
+	CalendarStats stats;
+	uint32_t hops = 0;
+	uint32_t seconds;
+	uint16_t millisecond;
+	uint32_t transitions;
+	int i;
+
+	hostTest_initCalendar(START);
+	_addSchedule();
+	virtualRtc_resetCounters();
+	calendar_startScheduler();
+	hostTest_runFor((SPREAD_DAYS + 2U) * 86400ULL * 1000000U);
+
+	virtualRtc_getCounters(&run);
+	calendar_getStats(&stats);
+	calendar_getHopWakeups(&hops);
+	transitions = (stats.transitions > 0U) ? stats.transitions : 1U;
+
+	// register accesses of the time reads
+	virtualRtc_resetCounters();
+	for (i = 0; i < NUM_READS; i++)
+		calendar_getEpoch(&seconds, &millisecond);
+	virtualRtc_getCounters(&read);
+
+	printf("# backend core transitions wakeups  hops spurious callbacks reads/tr writes/tr reads/time\n");
+	printf("%-9s %-4s %11u %7u %5u %8u %9u %8.1f %9.1f %10.1f\n",
+			HOST_TEST_BACKEND_NAME, HOST_TEST_CORE_NAME,
+			stats.transitions, stats.alarmsFired, hops, stats.spuriousAlarms,
+			_callbacks, (double)run.reads / transitions, (double)run.writes / transitions,
+			(double)read.reads / NUM_READS);
+
+	return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Event store microbenchmarks: fills the event list to its capacity in each
+ * insertion pattern and times eventSLL_insert(), eventSLL_peekIdx(),
+ * eventSLL_getNextAlarm() and eventSLL_remove() in nanoseconds per operation on
+ * the host.  Run from the builds of each capacity (the sll variants).  The
+ * patterns are fixed pseudo-random sequences and each time is the fastest of a
+ * few repeats, so runs can be compared across changes to the store.
+ */
+
+
+#include <host_test.h>
+#include <stdio.h>
+#include <time.h>
+
+
+/*
+ * Date and time the events are placed from.
+ */
+static const DateTime BASE = {24, 1, 1, 0, 0, 0, 0};
+
+/*
+ * Seconds between events in order, and each event's length.
+ */
+#define SPACING_S 60U
+#define LENGTH_S 30U
+
+/*
+ * Events that start within seconds of each other in the clustered pattern.
+ */
+#define CLUSTER_SIZE 16U
+
+/*
+ * Times each pattern is run, keeping the fastest, once at large capacities where
+ * filling the list takes seconds.  Next alarm lookups and removes timed in each
+ * run, the removes taken from the full list.
+ */
+#define REPEATS ((MAX_NUM_EVENTS > 4096) ? 1 : 3)
+#define NUM_LOOKUPS 100U
+#define NUM_REMOVES ((MAX_NUM_EVENTS < 256) ? MAX_NUM_EVENTS : 256U)
+
+
+/*
+ * Insertion patterns.
+ */
+typedef enum {
+	PATTERN_SORTED,
+	PATTERN_REVERSE,
+	PATTERN_RANDOM,
+	PATTERN_CLUSTERED,
+	NUM_PATTERNS
+} Pattern;
+
+static const char* const PATTERN_NAMES[NUM_PATTERNS] = {
+	"sorted", "reverse", "random", "clustered"
+};
+
+
+/*
+ * Nanoseconds per operation.
+ */
+typedef struct {
+	double insert;
+	double peek;
+	double nextAlarm;
+	double remove;
+} OpTimes;
+
+
+/*
+ * The list, and the IDs and start times of its events.
+ */
+static Event_SLL _sll;
+static unsigned int _ids[MAX_NUM_EVENTS];
+static uint32_t _starts[MAX_NUM_EVENTS];
+static uint64_t _state;
+
+
+/* _random
+ *
+ * Gets the next number of a fixed pseudo-random sequence.
+ */
+static uint32_t _random(void)
+{
+	_state = (_state * 6364136223846793005ULL) + 1442695040888963407ULL;
+
+	return (uint32_t)(_state >> 32);
+}
+
+
+/* _nanos
+ *
+ * Gets the host's monotonic clock in nanoseconds.
+ */
+static uint64_t _nanos(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return ((uint64_t)now.tv_sec * 1000000000U) + (uint64_t)now.tv_nsec;
+}
+
+
+/* _dateTime
+ *
+ * Gets the date and time some seconds from the base.
+ */
+static DateTime _dateTime(const uint32_t seconds)
+{
+	DateTime dateTime;
+
+	dateTime_fromSeconds(dateTime_toSeconds(BASE) + seconds, &dateTime);
+
+	return dateTime;
+}
+
+
+/* _placeEvents
+ *
+ * Sets the start times of the events in the order they are inserted.
+ */
+static void _placeEvents(const Pattern pattern)
+{
+	uint32_t i;
+
+	_state = 12345U;
+	for (i = 0; i < MAX_NUM_EVENTS; i++)
+	{
+		switch (pattern)
+		{
+		case PATTERN_SORTED:
+			_starts[i] = i * SPACING_S;
+			break;
+		case PATTERN_REVERSE:
+			_starts[i] = (MAX_NUM_EVENTS - 1U - i) * SPACING_S;
+			break;
+		case PATTERN_RANDOM:
+			_starts[i] = _random() % (MAX_NUM_EVENTS * SPACING_S);
+			break;
+		default:
+			_starts[i] = ((_random() % ((MAX_NUM_EVENTS / CLUSTER_SIZE) + 1U)) * CLUSTER_SIZE
+					* SPACING_S) + (_random() % 10U);
+			break;
+		}
+	}
+}
+
+
+/* _shuffleIds
+ *
+ * Shuffles the IDs, so that events are removed in no particular order.
+ */
+static void _shuffleIds(void)
+{
+	uint32_t i, j;
+	unsigned int id;
+
+	for (i = MAX_NUM_EVENTS - 1U; i > 0U; i--)
+	{
+		j = _random() % (i + 1U);
+		id = _ids[i];
+		_ids[i] = _ids[j];
+		_ids[j] = id;
+	}
+}
+
+
+/* _run
+ *
+ * Fills the list in a pattern, then times lookups and removes of random events.
+ */
+static void _run(const Pattern pattern, OpTimes* const times)
+{
+	CalendarEvent event = {0};
+	DateTime alarm;
+	DateTime at;
+	uint64_t start;
+	uint32_t i;
+	uint32_t span = MAX_NUM_EVENTS * SPACING_S;
+
+	_placeEvents(pattern);
+	eventSLL_reset(&_sll);
+
+	start = _nanos();
+	for (i = 0; i < MAX_NUM_EVENTS; i++)
+	{
+		event.start = _dateTime(_starts[i]);
+		event.end = _dateTime(_starts[i] + LENGTH_S);
+		_ids[i] = (unsigned int)_sll.freeHead;
+		eventSLL_insert(&_sll, event);
+	}
+	times->insert = (double)(_nanos() - start) / MAX_NUM_EVENTS;
+
+	start = _nanos();
+	for (i = 0; i < MAX_NUM_EVENTS; i++)
+		eventSLL_peekIdx(&_sll, _ids[i], &event);
+	times->peek = (double)(_nanos() - start) / MAX_NUM_EVENTS;
+
+	// lookups at times spread over the events, in no particular order
+	start = _nanos();
+	for (i = 0; i < NUM_LOOKUPS; i++)
+	{
+		at = _dateTime(_random() % span);
+		eventSLL_getNextAlarm(&_sll, at, &alarm);
+	}
+	times->nextAlarm = (double)(_nanos() - start) / NUM_LOOKUPS;
+
+	_shuffleIds();
+	start = _nanos();
+	for (i = 0; i < NUM_REMOVES; i++)
+		eventSLL_remove(&_sll, _ids[i]);
+	times->remove = (double)(_nanos() - start) / NUM_REMOVES;
+}
+
+
+/* _min
+ *
+ * Gets the lesser of two times.
+ */
+static double _min(const double a, const double b)
+{
+	return (a < b) ? a : b;
+}
+
+
+int main(void)
+{
+	OpTimes best;
+	OpTimes times;
+	int pattern;
+	int i;
+
+	printf("# capacity pattern   insert ns/op  peek ns/op  next alarm ns/op  remove ns/op\n");
+	for (pattern = 0; pattern < NUM_PATTERNS; pattern++)
+	{
+		_run((Pattern)pattern, &best);
+		for (i = 1; i < REPEATS; i++)
+		{
+			_run((Pattern)pattern, &times);
+			best.insert = _min(best.insert, times.insert);
+			best.peek = _min(best.peek, times.peek);
+			best.nextAlarm = _min(best.nextAlarm, times.nextAlarm);
+			best.remove = _min(best.remove, times.remove);
+		}
+
+		printf("%10d %-9s %12.1f %11.1f %17.1f %13.1f\n",
+				MAX_NUM_EVENTS, PATTERN_NAMES[pattern],
+				best.insert, best.peek, best.nextAlarm, best.remove);
+	}
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * RTC interrupt paths: counts the RTC register accesses of each alarm interrupt,
+ * in all and before the scheduler is signalled, through calendar_RTC_IRQHandler()
+ * and through HAL_RTC_AlarmIRQHandler() and the HAL alarm callbacks.
+ */
+
+
+#include <host_test.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+
+/*
+ * Start of the schedule.
+ */
+static const DateTime START = {24, 5, 20, 6, 0, 0, 0};
+
+/*
+ * Number of back-to-back one-second events, each alarm re-armed from the
+ * interrupt.
+ */
+#define NUM_EVENTS 20
+
+
+
+/*
+ * Accesses of the interrupt being measured.
+ */
+static uint32_t _accesses;			// accesses so far
+static uint32_t _accessesToSignal;	// accesses before the scheduler was signalled
+static uint32_t _firesBefore;		// alarm interrupts before the interrupt
+static bool _isSignalled;
+
+
+/* _alarmsFired
+ *
+ * Gets the number of alarm interrupts the scheduler has been signalled for.
+ */
+static uint32_t _alarmsFired(void)
+{
+	CalendarStats stats;
+
+	calendar_getStats(&stats);
+
+	return stats.alarmsFired;
+}
+
+
+/* _countAccess
+ *
+ * Counts an access, noting the accesses made before the scheduler was signalled.
+ */
+static void _countAccess(void)
+{
+	if (!_isSignalled && _alarmsFired() != _firesBefore)
+	{
+		_isSignalled = true;
+		_accessesToSignal = _accesses;
+	}
+	_accesses++;
+}
+
+
+/* _measure
+ *
+ * Runs the schedule through one interrupt path and reports its accesses per
+ * alarm interrupt.
+ */
+static void _measure(const bool useHal)
+{
+	VirtualRtcCounters rtc;
+	uint32_t reads = 0;
+	uint32_t writes = 0;
+	uint32_t toSignal = 0;
+	uint32_t irqs = 0;
+	int i;
+
+	hostTest_initCalendar(START);
+	hostTest_useHalIrq(useHal);
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		CalendarEvent event = {
+			.start = hostTest_dateTime(START, (uint64_t)(i + 1) * 1000U),
+			.end = hostTest_dateTime(START, (uint64_t)(i + 2) * 1000U),
+		};
+
+		calendar_addEvent(event);
+	}
+	calendar_startScheduler();
+	calendar_updateScheduler();
+
+	// measure each alarm interrupt alone, the update runs after it
+	virtualRtc_setAccessHook(_countAccess);
+	for (i = 0; i < NUM_EVENTS + 1; i++)
+	{
+		virtualRtc_resetCounters();
+		_accesses = 0;
+		_isSignalled = false;
+		_firesBefore = _alarmsFired();
+
+		if (!virtualRtc_advanceToAlarm(2000000U))
+			break;
+
+		virtualRtc_getCounters(&rtc);
+		reads += rtc.reads;
+		writes += rtc.writes;
+		toSignal += _isSignalled ? _accessesToSignal : _accesses;
+		irqs++;
+
+		calendar_updateScheduler();
+	}
+	virtualRtc_setAccessHook(NULL);
+
+	if (irqs == 0U)
+		irqs = 1U;
+	printf("%-23s %-6s %-4s %6u %9.1f %9.1f %10.1f\n",
+			useHal ? "HAL_RTC_AlarmIRQHandler" : "calendar_RTC_IRQHandler",
+			HOST_TEST_BACKEND_NAME, HOST_TEST_CORE_NAME,
+			irqs, (double)reads / irqs, (double)writes / irqs, (double)toSignal / irqs);
+}
+
+
+/* _measureAlone
+ *
+ * Measures an interrupt path in its own process, so that the calendar starts
+ * fresh.
+ */
+static void _measureAlone(const bool useHal)
+{
+	pid_t pid;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0)
+	{
+		_measure(useHal);
+		fflush(stdout);
+		_exit(0);
+	}
+	waitpid(pid, NULL, 0);
+}
+
+
+int main(void)
+{
+	printf("# path                  backend core   irqs reads/irq writes/irq to signal\n");
+	_measureAlone(false);
+	_measureAlone(true);
+
+	return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Timer slack simulation: runs a day of a 200-event schedule of periodic sensor
+ * tasks and a few exact events, with the periodic tasks given no slack and then
+ * some, and reports the wakeups per day and an estimate of the energy they take.
+ * Needs a build with room for the events (the large variant).
+ */
+
+
+#include <host_test.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+
+/*
+ * Start of the schedule.
+ */
+static const DateTime START = {24, 7, 1, 0, 0, 0, 0};
+
+/*
+ * Seconds in the day simulated.
+ */
+#define DAY_SECONDS 86400U
+
+/*
+ * Periodic tasks: their period, offset into the period, and length in seconds.
+ * 96 + 48 + 24 = 168 events a day.
+ */
+typedef struct {
+	uint32_t period;
+	uint32_t offset;
+	uint32_t length;
+} Task;
+
+static const Task TASKS[] = {
+	{900U, 7U, 20U},		// sample a sensor every 15 minutes
+	{1800U, 22U, 10U},		// log to flash every 30 minutes
+	{3600U, 41U, 60U},		// report by radio every hour
+};
+
+/*
+ * Exact events at pseudo-random times, taking the schedule to 200 events.
+ */
+#define NUM_EXACT 32
+
+/*
+ * Slack of the periodic tasks in the run with slack, in seconds.
+ */
+#define TASK_SLACK 30U
+
+/*
+ * Energy model, an estimate rather than a measurement: the core leaves Stop2 for
+ * each wakeup for about WAKEUP_MS at RUN_MA, restoring its clocks and running the
+ * update, and draws STOP2_UA in Stop2 with the RTC running otherwise.  The
+ * callbacks' own work is the same with and without slack and is not included.
+ */
+#define SUPPLY_V 3.3
+#define RUN_MA 4.0
+#define WAKEUP_MS 2.0
+#define STOP2_UA 1.0
+
+
+/* _random
+ *
+ * Gets the next number of a fixed pseudo-random sequence, so that every run has
+ * the same schedule.
+ */
+static uint32_t _random(void)
+{
+	static uint64_t state = 2024U;
+
+	state = (state * 6364136223846793005ULL) + 1442695040888963407ULL;
+
+	return (uint32_t)(state >> 32);
+}
+
+
+/* _addEvent
+ *
+ * Adds an event some seconds from the start.
+ */
+static void _addEvent(const uint32_t startSeconds, const uint32_t length, const uint16_t slack)
+{
+	CalendarEvent event = {
+		.start = hostTest_dateTime(START, (uint64_t)startSeconds * 1000U),
+		.end = hostTest_dateTime(START, (uint64_t)(startSeconds + length) * 1000U),
+		.slack = slack,
+	};
+
+	calendar_addEvent(event);
+}
+
+
+/* _addSchedule
+ *
+ * Adds the periodic tasks with a slack, and the exact events.
+ */
+static int _addSchedule(const uint16_t slack)
+{
+	uint32_t t;
+	unsigned int i;
+	int events = 0;
+
+	for (i = 0; i < sizeof(TASKS) / sizeof(TASKS[0]); i++)
+	{
+		for (t = TASKS[i].offset; t < DAY_SECONDS; t += TASKS[i].period)
+		{
+			_addEvent(t, TASKS[i].length, slack);
+			events++;
+		}
+	}
+
+	for (i = 0; i < NUM_EXACT; i++)
+	{
+		_addEvent(_random() % (DAY_SECONDS - 3600U), 30U + (_random() % 600U), 0U);
+		events++;
+	}
+
+	return events;
+}
+
+
+/* _simulate
+ *
+ * Runs a day of the schedule and reports its wakeups and energy.
+ */
+static void _simulate(const uint16_t slack)
+{
+	CalendarStats stats;
+	uint32_t hops = 0;
+	uint32_t wakeups;
+	int events;
+	double wakeupMillijoules;
+	double stopMillijoules;
+
+	hostTest_initCalendar(START);
+	events = _addSchedule(slack);
+	calendar_startScheduler();
+	hostTest_runFor((uint64_t)DAY_SECONDS * 1000000U);
+
+	calendar_getStats(&stats);
+	calendar_getHopWakeups(&hops);
+	wakeups = stats.alarmsFired + hops;
+
+	wakeupMillijoules = wakeups * SUPPLY_V * RUN_MA * WAKEUP_MS / 1000.0;
+	stopMillijoules = SUPPLY_V * STOP2_UA * DAY_SECONDS / 1000.0;
+	printf("%6u %6d %11u %11u %12.1f %10.1f\n",
+			slack, events, stats.transitions, wakeups, wakeupMillijoules,
+			wakeupMillijoules + stopMillijoules);
+}
+
+
+/* _simulateAlone
+ *
+ * Simulates in its own process, so that the calendar starts fresh.
+ */
+static void _simulateAlone(const uint16_t slack)
+{
+	pid_t pid;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0)
+	{
+		_simulate(slack);
+		fflush(stdout);
+		_exit(0);
+	}
+	waitpid(pid, NULL, 0);
+}
+
+
+int main(void)
+{
+	printf("# slack events transitions wakeups/day wakeup mJ/day total mJ/day\n");
+	_simulateAlone(0U);
+	_simulateAlone(TASK_SLACK);
+
+	return 0;
+}
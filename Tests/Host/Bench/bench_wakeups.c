@@ -0,0 +1,73 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Wakeup count of back-to-back events: runs a schedule of events that each start
+ * as the one before ends, and reports the wakeups and updates it took.  Without
+ * coalescing, every transition took its own alarm and update; with it, an end and
+ * the start at the same instant share one.  Needs a build with room for the
+ * events (the large variant).
+ */
+
+
+#include <host_test.h>
+#include <stdio.h>
+
+
+/*
+ * Start of the schedule.
+ */
+static const DateTime START = {24, 10, 1, 0, 0, 0, 0};
+
+/*
+ * Number of events and their length.
+ */
+#define NUM_EVENTS 1000
+#define EVENT_MS 1000U
+
+
+static uint32_t _callbacks;
+
+
+static void _onTransition(void)
+{
+	_callbacks++;
+}
+
+
+int main(void)
+{
+	CalendarStats stats;
+	uint32_t hops = 0;
+	int i;
+
+	hostTest_initCalendar(START);
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		CalendarEvent event = {
+			.start = hostTest_dateTime(START, (uint64_t)(i + 1) * EVENT_MS),
+			.end = hostTest_dateTime(START, (uint64_t)(i + 2) * EVENT_MS),
+			.start_callback = _onTransition,
+			.end_callback = _onTransition,
+		};
+
+		if (calendar_addEvent(event) != CALENDAR_OKAY)
+		{
+			printf("no room for %d events, MAX_NUM_EVENTS is %d\n", NUM_EVENTS, MAX_NUM_EVENTS);
+			return 1;
+		}
+	}
+	calendar_startScheduler();
+	hostTest_runFor((NUM_EVENTS + 2ULL) * EVENT_MS * 1000U);
+
+	calendar_getStats(&stats);
+	calendar_getHopWakeups(&hops);
+
+	// uncoalesced, each start and end took its own wakeup and update
+	printf("# events boundaries transitions callbacks uncoalesced wakeups updates\n");
+	printf("%8d %10d %11u %9u %11d %7u %7u\n",
+			NUM_EVENTS, 2 * NUM_EVENTS, stats.transitions, _callbacks, 2 * NUM_EVENTS,
+			stats.alarmsFired + hops, stats.updates);
+
+	return 0;
+}
@@ -0,0 +1,524 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		Host HAL stands in for the STM32 HAL and CMSIS so that the Calendar
+ *	module builds and runs on a host, selected through calendar_hal.h with
+ *	-DCALENDAR_HAL_HEADER='"host_hal.h"'.  It provides what calendar_hal.h lists
+ *	a stand-in must provide, for a STM32WL55 Cortex-M0+ core (CORE_CM0PLUS) or
+ *	Cortex-M4 core (CORE_CM4).
+ *		The RTC's registers belong to the Virtual RTC (virtual_rtc.h), which
+ *	runs a clock that tests move forward.  Register accesses go through
+ *	READ_REG/WRITE_REG so that the Virtual RTC can count them and compute the
+ *	time registers when they are read.  Plain struct accesses of the RTC, such
+ *	as RTC->CR, bypass it and are not used by the module.
+ *		Interrupts are emulated on the calling thread.  An interrupt's handler
+ *	runs as soon as it is pending, its line enabled, PRIMASK clear, and no
+ *	handler is running; otherwise it waits until that is the case.  A line whose
+ *	source is still asserted when its handler returns is pending again.  The
+ *	exclusive monitor of __LDREXW/__STREXW is cleared when an interrupt is
+ *	entered, as on the core.  Interrupts can also be entered from another thread
+ *	with hostHal_enterIrq()/hostHal_exitIrq(), which is serialized with PRIMASK
+ *	and the exclusive accesses of other threads.
+ */
+
+#ifndef HOST_INC_HOST_HAL_H_
+#define HOST_INC_HOST_HAL_H_
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+
+/*
+ * Core.
+ */
+#if defined(CORE_CM4)
+#define __CORTEX_M 4U
+#else
+#define __CORTEX_M 0U
+#endif
+
+#define __IO volatile
+#define __weak __attribute__((weak))
+#define UNUSED(X) (void)(X)
+
+typedef enum {
+  HAL_OK = 0x00U,
+  HAL_ERROR = 0x01U,
+  HAL_BUSY = 0x02U,
+  HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum {
+  HAL_UNLOCKED = 0x00U,
+  HAL_LOCKED = 0x01U
+} HAL_LockTypeDef;
+
+typedef enum {
+  HAL_TICK_FREQ_10HZ = 100U,
+  HAL_TICK_FREQ_100HZ = 10U,
+  HAL_TICK_FREQ_1KHZ = 1U,
+  HAL_TICK_FREQ_DEFAULT = HAL_TICK_FREQ_1KHZ
+} HAL_TickFreqTypeDef;
+
+
+/*
+ * Interrupt lines, each named only on its core as in the device header.  The
+ * RTC shares RTC_LSECSS_IRQn on the Cortex-M0+ core, and its alarms have
+ * RTC_Alarm_IRQn on the Cortex-M4 core.
+ */
+typedef enum {
+#ifdef CORE_CM4
+  RTC_Alarm_IRQn = 42,
+#else
+  RTC_LSECSS_IRQn = 2,
+#endif
+  HOST_HAL_NUM_IRQS = 64
+} IRQn_Type;
+
+
+/*
+ * Registers.
+ */
+typedef struct {
+  __IO uint32_t TR;
+  __IO uint32_t DR;
+  __IO uint32_t SSR;
+  __IO uint32_t ICSR;
+  __IO uint32_t PRER;
+  __IO uint32_t WUTR;
+  __IO uint32_t CR;
+  uint32_t RESERVED0;
+  uint32_t RESERVED1;
+  __IO uint32_t WPR;
+  __IO uint32_t CALR;
+  __IO uint32_t SHIFTR;
+  __IO uint32_t TSTR;
+  __IO uint32_t TSDR;
+  __IO uint32_t TSSSR;
+  uint32_t RESERVED2;
+  __IO uint32_t ALRMAR;
+  __IO uint32_t ALRMASSR;
+  __IO uint32_t ALRMBR;
+  __IO uint32_t ALRMBSSR;
+  __IO uint32_t SR;
+  __IO uint32_t MISR;
+  uint32_t RESERVED3;
+  __IO uint32_t SCR;
+  uint32_t RESERVED4[4];
+  __IO uint32_t ALRABINR;
+  __IO uint32_t ALRBBINR;
+} RTC_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR1;
+  __IO uint32_t CR2;
+  __IO uint32_t CR3;
+  __IO uint32_t FLTCR;
+  uint32_t RESERVED0[7];
+  __IO uint32_t IER;
+  __IO uint32_t SR;
+  __IO uint32_t MISR;
+  uint32_t RESERVED1;
+  __IO uint32_t SCR;
+  __IO uint32_t COUNTR;
+  uint32_t RESERVED2[47];
+  __IO uint32_t BKPR[20];
+} TAMP_TypeDef;
+
+typedef struct {
+  __IO uint32_t CTRL;
+  __IO uint32_t LOAD;
+  __IO uint32_t VAL;
+  __IO uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct {
+  __IO uint32_t CTRL;
+  __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern RTC_TypeDef virtualRtc_rtc;
+extern TAMP_TypeDef virtualRtc_tamp;
+extern SysTick_Type hostHal_sysTick;
+extern DWT_Type hostHal_dwt;
+extern CoreDebug_Type hostHal_coreDebug;
+
+#define RTC (&virtualRtc_rtc)
+#define TAMP (&virtualRtc_tamp)
+#define SysTick (&hostHal_sysTick)
+#define DWT (&hostHal_dwt)
+#define CoreDebug (&hostHal_coreDebug)
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+
+/*
+ * Register access, through the Virtual RTC for its registers.
+ */
+uint32_t hostHal_readReg(__IO uint32_t* const reg);
+void hostHal_writeReg(__IO uint32_t* const reg, const uint32_t value);
+
+#define READ_REG(REG) hostHal_readReg(&(REG))
+#define WRITE_REG(REG, VAL) hostHal_writeReg(&(REG), (VAL))
+#define SET_BIT(REG, BIT) WRITE_REG((REG), READ_REG(REG) | (BIT))
+#define CLEAR_BIT(REG, BIT) WRITE_REG((REG), READ_REG(REG) & ~(BIT))
+#define READ_BIT(REG, BIT) (READ_REG(REG) & (BIT))
+#define CLEAR_REG(REG) WRITE_REG((REG), 0U)
+
+
+/*
+ * RTC register bits.
+ */
+#define RTC_TR_SU_Pos 0U
+#define RTC_TR_SU (0xFUL << RTC_TR_SU_Pos)
+#define RTC_TR_ST_Pos 4U
+#define RTC_TR_ST (0x7UL << RTC_TR_ST_Pos)
+#define RTC_TR_MNU_Pos 8U
+#define RTC_TR_MNU (0xFUL << RTC_TR_MNU_Pos)
+#define RTC_TR_MNT_Pos 12U
+#define RTC_TR_MNT (0x7UL << RTC_TR_MNT_Pos)
+#define RTC_TR_HU_Pos 16U
+#define RTC_TR_HU (0xFUL << RTC_TR_HU_Pos)
+#define RTC_TR_HT_Pos 20U
+#define RTC_TR_HT (0x3UL << RTC_TR_HT_Pos)
+#define RTC_TR_PM_Pos 22U
+#define RTC_TR_PM (0x1UL << RTC_TR_PM_Pos)
+
+#define RTC_DR_DU_Pos 0U
+#define RTC_DR_DU (0xFUL << RTC_DR_DU_Pos)
+#define RTC_DR_DT_Pos 4U
+#define RTC_DR_DT (0x3UL << RTC_DR_DT_Pos)
+#define RTC_DR_MU_Pos 8U
+#define RTC_DR_MU (0xFUL << RTC_DR_MU_Pos)
+#define RTC_DR_MT_Pos 12U
+#define RTC_DR_MT (0x1UL << RTC_DR_MT_Pos)
+#define RTC_DR_WDU_Pos 13U
+#define RTC_DR_WDU (0x7UL << RTC_DR_WDU_Pos)
+#define RTC_DR_YU_Pos 16U
+#define RTC_DR_YU (0xFUL << RTC_DR_YU_Pos)
+#define RTC_DR_YT_Pos 20U
+#define RTC_DR_YT (0xFUL << RTC_DR_YT_Pos)
+
+#define RTC_ICSR_RSF (1UL << 5)
+#define RTC_ICSR_INITF (1UL << 6)
+#define RTC_ICSR_INIT (1UL << 7)
+#define RTC_ICSR_BIN_Pos 8U
+#define RTC_ICSR_BIN (0x3UL << RTC_ICSR_BIN_Pos)
+
+#define RTC_PRER_PREDIV_S_Pos 0U
+#define RTC_PRER_PREDIV_S (0x7FFFUL << RTC_PRER_PREDIV_S_Pos)
+#define RTC_PRER_PREDIV_A_Pos 16U
+#define RTC_PRER_PREDIV_A (0x7FUL << RTC_PRER_PREDIV_A_Pos)
+
+#define RTC_CR_SSRUIE (1UL << 7)
+#define RTC_CR_ALRAE (1UL << 8)
+#define RTC_CR_ALRBE (1UL << 9)
+#define RTC_CR_WUTE (1UL << 10)
+#define RTC_CR_TSE (1UL << 11)
+#define RTC_CR_ALRAIE (1UL << 12)
+#define RTC_CR_ALRBIE (1UL << 13)
+#define RTC_CR_WUTIE (1UL << 14)
+#define RTC_CR_TSIE (1UL << 15)
+
+#define RTC_ALRMAR_SU_Pos 0U
+#define RTC_ALRMAR_SU (0xFUL << RTC_ALRMAR_SU_Pos)
+#define RTC_ALRMAR_ST_Pos 4U
+#define RTC_ALRMAR_ST (0x7UL << RTC_ALRMAR_ST_Pos)
+#define RTC_ALRMAR_MSK1 (1UL << 7)
+#define RTC_ALRMAR_MNU_Pos 8U
+#define RTC_ALRMAR_MNU (0xFUL << RTC_ALRMAR_MNU_Pos)
+#define RTC_ALRMAR_MNT_Pos 12U
+#define RTC_ALRMAR_MNT (0x7UL << RTC_ALRMAR_MNT_Pos)
+#define RTC_ALRMAR_MSK2 (1UL << 15)
+#define RTC_ALRMAR_HU_Pos 16U
+#define RTC_ALRMAR_HU (0xFUL << RTC_ALRMAR_HU_Pos)
+#define RTC_ALRMAR_HT_Pos 20U
+#define RTC_ALRMAR_HT (0x3UL << RTC_ALRMAR_HT_Pos)
+#define RTC_ALRMAR_PM_Pos 22U
+#define RTC_ALRMAR_PM (1UL << RTC_ALRMAR_PM_Pos)
+#define RTC_ALRMAR_MSK3 (1UL << 23)
+#define RTC_ALRMAR_DU_Pos 24U
+#define RTC_ALRMAR_DU (0xFUL << RTC_ALRMAR_DU_Pos)
+#define RTC_ALRMAR_DT_Pos 28U
+#define RTC_ALRMAR_DT (0x3UL << RTC_ALRMAR_DT_Pos)
+#define RTC_ALRMAR_WDSEL (1UL << 30)
+#define RTC_ALRMAR_MSK4 (1UL << 31)
+
+#define RTC_ALRMASSR_SS_Pos 0U
+#define RTC_ALRMASSR_SS (0x7FFFUL << RTC_ALRMASSR_SS_Pos)
+#define RTC_ALRMASSR_MASKSS_Pos 24U
+#define RTC_ALRMASSR_MASKSS (0x3FUL << RTC_ALRMASSR_MASKSS_Pos)
+#define RTC_ALRMASSR_SSCLR (1UL << 31)
+#define RTC_ALRMBSSR_SS RTC_ALRMASSR_SS
+#define RTC_ALRMBSSR_MASKSS RTC_ALRMASSR_MASKSS
+#define RTC_ALRMBSSR_SSCLR RTC_ALRMASSR_SSCLR
+
+#define RTC_SR_ALRAF (1UL << 0)
+#define RTC_SR_ALRBF (1UL << 1)
+#define RTC_SR_WUTF (1UL << 2)
+#define RTC_SR_TSF (1UL << 3)
+#define RTC_SR_TSOVF (1UL << 4)
+#define RTC_SR_ITSF (1UL << 5)
+#define RTC_SR_SSRUF (1UL << 6)
+
+#define RTC_MISR_ALRAMF RTC_SR_ALRAF
+#define RTC_MISR_ALRBMF RTC_SR_ALRBF
+#define RTC_MISR_WUTMF RTC_SR_WUTF
+#define RTC_MISR_TSMF RTC_SR_TSF
+#define RTC_MISR_TSOVMF RTC_SR_TSOVF
+#define RTC_MISR_ITSMF RTC_SR_ITSF
+#define RTC_MISR_SSRUMF RTC_SR_SSRUF
+
+#define RTC_SCR_CALRAF RTC_SR_ALRAF
+#define RTC_SCR_CALRBF RTC_SR_ALRBF
+#define RTC_SCR_CWUTF RTC_SR_WUTF
+#define RTC_SCR_CTSF RTC_SR_TSF
+#define RTC_SCR_CTSOVF RTC_SR_TSOVF
+#define RTC_SCR_CITSF RTC_SR_ITSF
+#define RTC_SCR_CSSRUF RTC_SR_SSRUF
+
+#define TAMP_MISR_TAMP1MF (1UL << 0)
+#define TAMP_MISR_TAMP2MF (1UL << 1)
+#define TAMP_MISR_TAMP3MF (1UL << 2)
+
+
+/*
+ * RTC HAL definitions.
+ */
+#define RTC_FORMAT_BIN 0x00000000U
+#define RTC_FORMAT_BCD 0x00000001U
+
+#define RTC_HOURFORMAT_24 0x00000000U
+
+#define RTC_BINARY_NONE 0x00000000U
+#define RTC_BINARY_ONLY (0x1UL << RTC_ICSR_BIN_Pos)
+#define RTC_BINARY_MIX (0x2UL << RTC_ICSR_BIN_Pos)
+
+#define RTC_ALARM_A RTC_CR_ALRAE
+#define RTC_ALARM_B RTC_CR_ALRBE
+
+#define RTC_ALARMDATEWEEKDAYSEL_DATE 0x00000000U
+#define RTC_ALARMDATEWEEKDAYSEL_WEEKDAY RTC_ALRMAR_WDSEL
+#define RTC_ALARMMASK_NONE 0x00000000U
+#define RTC_ALARMMASK_ALL (RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2 \
+		| RTC_ALRMAR_MSK1)
+#define RTC_ALARMSUBSECONDMASK_NONE RTC_ALRMASSR_MASKSS
+#define RTC_ALARMSUBSECONDBINMASK_NONE (32UL << RTC_ALRMASSR_MASKSS_Pos)
+#define RTC_ALARMSUBSECONDBIN_AUTOCLR_NO 0x00000000U
+
+#define RTC_BKP_DR0 0x00U
+#define RTC_BKP_DR1 0x01U
+
+#define RCC_PERIPHCLK_RTC 0x00010000U
+
+#define __HAL_RTC_WRITEPROTECTION_DISABLE(__HANDLE__) \
+		do { \
+			WRITE_REG((__HANDLE__)->Instance->WPR, 0xCAU); \
+			WRITE_REG((__HANDLE__)->Instance->WPR, 0x53U); \
+		} while (0)
+#define __HAL_RTC_WRITEPROTECTION_ENABLE(__HANDLE__) \
+		do { \
+			WRITE_REG((__HANDLE__)->Instance->WPR, 0xFFU); \
+		} while (0)
+#define __HAL_RTC_ALARM_EXTI_ENABLE_IT() do { } while (0)
+
+typedef struct {
+  uint8_t Hours;
+  uint8_t Minutes;
+  uint8_t Seconds;
+  uint8_t TimeFormat;
+  uint32_t SubSeconds;
+  uint32_t SecondFraction;
+  uint32_t DayLightSaving;
+  uint32_t StoreOperation;
+} RTC_TimeTypeDef;
+
+typedef struct {
+  uint8_t WeekDay;
+  uint8_t Month;
+  uint8_t Date;
+  uint8_t Year;
+} RTC_DateTypeDef;
+
+typedef struct {
+  RTC_TimeTypeDef AlarmTime;
+  uint32_t AlarmMask;
+  uint32_t AlarmSubSecondMask;
+  uint32_t BinaryAutoClr;
+  uint32_t AlarmDateWeekDaySel;
+  uint8_t AlarmDateWeekDay;
+  uint32_t Alarm;
+} RTC_AlarmTypeDef;
+
+typedef struct {
+  uint32_t HourFormat;
+  uint32_t AsynchPrediv;
+  uint32_t SynchPrediv;
+  uint32_t OutPut;
+  uint32_t OutPutRemap;
+  uint32_t OutPutPolarity;
+  uint32_t OutPutType;
+  uint32_t OutPutPullUp;
+  uint32_t BinMode;
+  uint32_t BinMixBcdU;
+} RTC_InitTypeDef;
+
+typedef struct {
+  uint32_t RtcFeatures;
+  uint32_t TampFeatures;
+} RTC_IsEnabledTypeDef;
+
+typedef struct {
+  RTC_TypeDef* Instance;
+  RTC_InitTypeDef Init;
+  HAL_LockTypeDef Lock;
+  uint32_t State;
+  RTC_IsEnabledTypeDef IsEnabled;
+} RTC_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* sTime,
+		uint32_t Format);
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* sTime,
+		uint32_t Format);
+HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* sDate,
+		uint32_t Format);
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* sDate,
+		uint32_t Format);
+HAL_StatusTypeDef HAL_RTC_GetAlarm(RTC_HandleTypeDef* hrtc, RTC_AlarmTypeDef* sAlarm,
+		uint32_t Alarm, uint32_t Format);
+void HAL_RTC_AlarmIRQHandler(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_WakeUpTimerIRQHandler(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_TimeStampIRQHandler(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_SSRUIRQHandler(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_TamperIRQHandler(RTC_HandleTypeDef* hrtc);
+void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_AlarmBEventCallback(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_TimeStampEventCallback(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_SSRUEventCallback(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_Tamper1EventCallback(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_Tamper2EventCallback(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_Tamper3EventCallback(RTC_HandleTypeDef* hrtc);
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef* hrtc, uint32_t BackupRegister, uint32_t Data);
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef* hrtc, uint32_t BackupRegister);
+uint8_t RTC_ByteToBcd2(uint8_t Value);
+uint8_t RTC_Bcd2ToByte(uint8_t Value);
+uint32_t HAL_RCCEx_GetPeriphCLKFreq(uint32_t PeriphClk);
+
+
+/*
+ * Interrupts.
+ */
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq(void);
+void __enable_irq(void);
+#define __DMB() __sync_synchronize()
+#if (__CORTEX_M >= 3U)
+uint32_t __LDREXW(__IO uint32_t* addr);
+uint32_t __STREXW(uint32_t value, __IO uint32_t* addr);
+#endif
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn);
+
+
+/*
+ * Timing.  The tick follows the Virtual RTC's clock.
+ */
+uint32_t HAL_GetTick(void);
+HAL_TickFreqTypeDef HAL_GetTickFreq(void);
+
+
+/*
+ * Host counters of the emulated interrupts.
+ */
+typedef struct {
+  uint32_t irqEntries;		// interrupt handlers entered
+  uint32_t stuckIrqs;		// lines disabled for re-entering without end
+  uint32_t exclusiveFails;	// __STREXW that failed
+} HostHalCounters;
+
+/* hostHal_reset
+ *
+ * Function:
+ *	Resets the emulated interrupts, PRIMASK and the counters.  Lines are disabled
+ *	and have no handler.
+ */
+void hostHal_reset(void);
+
+/* hostHal_setIrqHandler
+ *
+ * Function:
+ *	Sets the handler of an interrupt line and the check of whether its source
+ *	is asserted, which pends the line again after the handler returns.
+ *
+ * Parameters:
+ *	IRQn - the interrupt line
+ *	handler - the interrupt handler
+ *	isAsserted - checks if the source is still asserted, or NULL for a pulse
+ */
+void hostHal_setIrqHandler(const IRQn_Type IRQn, void (*handler)(void),
+		bool (*isAsserted)(void));
+
+/* hostHal_raiseIrq
+ *
+ * Function:
+ *	Pends an interrupt line, and runs its handler if it can be taken now.
+ */
+void hostHal_raiseIrq(const IRQn_Type IRQn);
+
+/* hostHal_isInIrq
+ *
+ * Function:
+ *	Checks if an interrupt handler is running.
+ */
+bool hostHal_isInIrq(void);
+
+/* hostHal_enterIrq
+ *
+ * Function:
+ *	Enters an interrupt from the calling thread, waiting until the interrupt
+ *	could be taken.  Clears the exclusive monitor.  Paired with
+ *	hostHal_exitIrq().
+ */
+void hostHal_enterIrq(void);
+
+/* hostHal_exitIrq
+ *
+ * Function:
+ *	Returns from an interrupt entered with hostHal_enterIrq().
+ */
+void hostHal_exitIrq(void);
+
+/* hostHal_setExclusiveHook
+ *
+ * Function:
+ *	Sets a function called between an exclusive load and its store, where an
+ *	interrupt taken clears the exclusive monitor.
+ *
+ * Parameters:
+ *	hook - the function, or NULL for none
+ */
+void hostHal_setExclusiveHook(void (*hook)(void));
+
+/* hostHal_getCounters
+ *
+ * Function:
+ *	Gets the counters of the emulated interrupts.
+ */
+void hostHal_getCounters(HostHalCounters* const counters);
+
+
+#endif /* HOST_INC_HOST_HAL_H_ */
@@ -0,0 +1,171 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		Host Test runs the Calendar module's host tests: checks, test cases run
+ *	each in its own process so that the module's static state starts fresh, and
+ *	a calendar on the Virtual RTC driven by a main loop that sleeps until the
+ *	next alarm.  The RTC interrupt is handled by calendar_RTC_IRQHandler(), as
+ *	in the usage example, or by HAL_RTC_AlarmIRQHandler() and the HAL alarm
+ *	callbacks.
+ *		The calendar's backend is the one the module is built with: BCD, or
+ *	binary only (RTC_CALENDAR_CONTROL_BINARY), both at the usage example's
+ *	256 Hz.
+ */
+
+#ifndef HOST_INC_HOST_TEST_H_
+#define HOST_INC_HOST_TEST_H_
+
+
+#include <host_hal.h>
+#include <virtual_rtc.h>
+#include <calendar.h>
+
+
+/*
+ * RTC mode of the calendar's backend, and the asynchronous prescaler.
+ */
+#ifdef RTC_CALENDAR_CONTROL_BINARY
+#define HOST_TEST_BIN_MODE RTC_BINARY_ONLY
+#else
+#define HOST_TEST_BIN_MODE RTC_BINARY_NONE
+#endif
+#define HOST_TEST_ASYNCH_PREDIV 127U
+
+/*
+ * Names of the backend and core the module is built for, for reports.
+ */
+#ifdef RTC_CALENDAR_CONTROL_BINARY
+#define HOST_TEST_BACKEND_NAME "binary"
+#else
+#define HOST_TEST_BACKEND_NAME "bcd"
+#endif
+#ifdef CORE_CM4
+#define HOST_TEST_CORE_NAME "cm4"
+#else
+#define HOST_TEST_CORE_NAME "cm0+"
+#endif
+
+/*
+ * Checks a condition, reporting it and failing the test case if false.
+ */
+#define CHECK(condition) hostTest_check((condition), #condition, __FILE__, __LINE__)
+
+/*
+ * Checks that a value equals the expected value.
+ */
+#define CHECK_EQUAL(expected, actual) hostTest_checkEqual((long long)(expected), \
+		(long long)(actual), #actual, __FILE__, __LINE__)
+
+/*
+ * RTC handle of the calendar.
+ */
+extern RTC_HandleTypeDef hostTest_hrtc;
+
+
+/* hostTest_check
+ *
+ * Function:
+ *	Reports a failed check.  Used by CHECK.
+ */
+void hostTest_check(const bool condition, const char* const text, const char* const file,
+		const int line);
+
+/* hostTest_checkEqual
+ *
+ * Function:
+ *	Reports a failed equality check.  Used by CHECK_EQUAL.
+ */
+void hostTest_checkEqual(const long long expected, const long long actual,
+		const char* const text, const char* const file, const int line);
+
+/* hostTest_run
+ *
+ * Function:
+ *	Runs a test case in its own process, and reports it.
+ *
+ * Parameters:
+ *	name - name of the test case
+ *	test - the test case
+ */
+void hostTest_run(const char* const name, void (*test)(void));
+
+/* hostTest_finish
+ *
+ * Function:
+ *	Reports the test cases run.
+ *
+ * Return:
+ *	int - exit status, 0 if all test cases passed
+ */
+int hostTest_finish(void);
+
+/* hostTest_initCalendar
+ *
+ * Function:
+ *	Resets the Host HAL and Virtual RTC, enables the RTC interrupt, and
+ *	initializes the calendar at a date and time.
+ *
+ * Parameters:
+ *	now - date and time to set
+ */
+void hostTest_initCalendar(const DateTime now);
+
+/* hostTest_useHalIrq
+ *
+ * Function:
+ *	Selects the RTC interrupt handler.
+ *
+ * Parameters:
+ *	useHal - true for HAL_RTC_AlarmIRQHandler() and the HAL alarm callbacks,
+ *			false for calendar_RTC_IRQHandler()
+ */
+void hostTest_useHalIrq(const bool useHal);
+
+/* hostTest_runFor
+ *
+ * Function:
+ *	Runs the main loop for a time: the scheduler is updated, then the clock
+ *	sleeps to the next alarm, until the time has passed.
+ *
+ * Parameters:
+ *	micros - microseconds to run for
+ */
+void hostTest_runFor(const uint64_t micros);
+
+/* hostTest_nowMillis
+ *
+ * Function:
+ *	Gets the Virtual RTC's calendar in milliseconds since the start of the
+ *	century, rounded down.
+ */
+uint64_t hostTest_nowMillis(void);
+
+/* hostTest_millisOf
+ *
+ * Function:
+ *	Gets a date and time in milliseconds since the start of the century.
+ */
+uint64_t hostTest_millisOf(const DateTime dateTime);
+
+/* hostTest_dateTime
+ *
+ * Function:
+ *	Gets the date and time some milliseconds after another.
+ *
+ * Parameters:
+ *	from - the date and time
+ *	millis - milliseconds after it
+ */
+DateTime hostTest_dateTime(const DateTime from, const uint64_t millis);
+
+/* hostTest_resolutionMillis
+ *
+ * Function:
+ *	Gets the length of one tick of the Virtual RTC, in milliseconds rounded up.
+ */
+uint32_t hostTest_resolutionMillis(void);
+
+
+#endif /* HOST_INC_HOST_TEST_H_ */
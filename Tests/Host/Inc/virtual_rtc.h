@@ -0,0 +1,203 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		Virtual RTC models the STM32WL55's RTC behind the Host HAL: its time,
+ *	sub-second and alarm registers in BCD or binary only mode, alarm matching,
+ *	the status and interrupt flags, write protection, and its interrupt line.
+ *	Its clock only moves when a test moves it, and moving it fast-forwards to
+ *	each alarm match on the way, so that days of scheduling run in
+ *	milliseconds.  The time registers are computed from the clock when read.
+ *		The clock runs at ck_apre, 32768 Hz divided by the asynchronous
+ *	prescaler.  In BCD mode the sub-second register counts down from the
+ *	synchronous prescaler each second, and in binary only mode it counts down
+ *	from 0xFFFFFFFF.  Both restart when the initialization mode is left, after
+ *	the time and date registers are written.  Reading the sub-second or time
+ *	register locks the time and date until the date is read, as the shadow
+ *	registers do.
+ *		An alarm matches on the first tick at which its unmasked fields equal
+ *	the clock's, sets its flag, and asserts the RTC's interrupt while enabled.
+ *	The interrupt runs at once through the Host HAL, so the handler sees the
+ *	clock at the match.
+ */
+
+#ifndef HOST_INC_VIRTUAL_RTC_H_
+#define HOST_INC_VIRTUAL_RTC_H_
+
+
+#include <host_hal.h>
+
+
+/*
+ * Interrupt line of the RTC on the core being built for.
+ */
+#if defined(CORE_CM4)
+#define VIRTUAL_RTC_IRQn RTC_Alarm_IRQn
+#else
+#define VIRTUAL_RTC_IRQn RTC_LSECSS_IRQn
+#endif
+
+/*
+ * Frequency of the RTC's clock (LSE).
+ */
+#define VIRTUAL_RTC_LSE_HZ 32768U
+
+/*
+ * Counters of the Virtual RTC.
+ */
+typedef struct {
+  uint32_t reads;				// register reads
+  uint32_t writes;				// register writes
+  uint32_t alarmMatches[2];		// alarm A and B flags set
+  uint32_t ignoredWrites;		// writes to protected or enabled alarm registers
+} VirtualRtcCounters;
+
+
+/* virtualRtc_init
+ *
+ * Function:
+ *	Resets the RTC's registers, counters and clock, to the start of the century,
+ *	and initializes a HAL RTC handle for it.
+ *
+ * Parameters:
+ *	hrtc - the HAL RTC handle to initialize
+ *	binMode - RTC_BINARY_NONE for BCD mode or RTC_BINARY_ONLY for binary only mode
+ *	asynchPrediv - asynchronous prescaler, the clock runs at 32768 Hz divided by
+ *			one more than it.  In BCD mode, the synchronous prescaler is set for
+ *			1 Hz seconds.
+ */
+void virtualRtc_init(RTC_HandleTypeDef* const hrtc, const uint32_t binMode,
+		const uint32_t asynchPrediv);
+
+/* virtualRtc_advance
+ *
+ * Function:
+ *	Moves the clock forward, stopping at each alarm match on the way to set the
+ *	alarm's flag and take its interrupt.
+ *
+ * Parameters:
+ *	micros - microseconds to move forward
+ */
+void virtualRtc_advance(const uint64_t micros);
+
+/* virtualRtc_advanceToAlarm
+ *
+ * Function:
+ *	Moves the clock forward to the next alarm match, if within a limit, and
+ *	takes its interrupt.
+ *
+ * Parameters:
+ *	maxMicros - furthest to move forward
+ *
+ * Return:
+ *	bool - true if an alarm matched, otherwise the clock moved the whole limit
+ */
+bool virtualRtc_advanceToAlarm(const uint64_t maxMicros);
+
+/* virtualRtc_getMicros
+ *
+ * Function:
+ *	Gets the clock in microseconds since virtualRtc_init().
+ */
+uint64_t virtualRtc_getMicros(void);
+
+/* virtualRtc_getTicksPerSecond
+ *
+ * Function:
+ *	Gets the rate of the clock's ticks.
+ */
+uint32_t virtualRtc_getTicksPerSecond(void);
+
+/* virtualRtc_raiseFlags
+ *
+ * Function:
+ *	Sets status flags of the RTC (RTC_SR_x) or the tamper block (TAMP_MISR_x,
+ *	with tamper set), as their events would, and asserts the interrupt if they
+ *	are enabled.  Tamper flags are always enabled.
+ *
+ * Parameters:
+ *	flags - the flags to set
+ *	tamper - true for tamper flags, false for RTC flags
+ */
+void virtualRtc_raiseFlags(const uint32_t flags, const bool tamper);
+
+/* virtualRtc_isAsserted
+ *
+ * Function:
+ *	Checks if the RTC's interrupt line is asserted.
+ */
+bool virtualRtc_isAsserted(void);
+
+/* virtualRtc_setAccessHook
+ *
+ * Function:
+ *	Sets a function called before each register access, to move the clock or
+ *	raise flags between the accesses of the code under test.  Accesses from
+ *	the hook do not call it again.
+ *
+ * Parameters:
+ *	hook - the function, or NULL for none
+ */
+void virtualRtc_setAccessHook(void (*hook)(void));
+
+/* virtualRtc_getCounters
+ *
+ * Function:
+ *	Gets the counters of the Virtual RTC.
+ */
+void virtualRtc_getCounters(VirtualRtcCounters* const counters);
+
+/* virtualRtc_resetCounters
+ *
+ * Function:
+ *	Resets the counters of the Virtual RTC.
+ */
+void virtualRtc_resetCounters(void);
+
+/* virtualRtc_read
+ *
+ * Function:
+ *	Reads a register if it is one of the RTC's.  Used by the Host HAL.
+ *
+ * Parameters:
+ *	reg - the register
+ *	value - pointer to store the register's value in
+ *
+ * Return:
+ *	bool - true if the register is one of the RTC's
+ */
+bool virtualRtc_read(__IO uint32_t* const reg, uint32_t* const value);
+
+/* virtualRtc_write
+ *
+ * Function:
+ *	Writes a register if it is one of the RTC's.  Used by the Host HAL.
+ *
+ * Parameters:
+ *	reg - the register
+ *	value - the value to write
+ *
+ * Return:
+ *	bool - true if the register is one of the RTC's
+ */
+bool virtualRtc_write(__IO uint32_t* const reg, const uint32_t value);
+
+/* virtualRtc_getCalendarMicros
+ *
+ * Function:
+ *	Gets the calendar in microseconds since the start of the century.  In binary
+ *	only mode, the microseconds since the time was last set.
+ */
+uint64_t virtualRtc_getCalendarMicros(void);
+
+/* virtualRtc_getSeconds
+ *
+ * Function:
+ *	Gets the calendar's whole seconds since the start of the century.  In
+ *	binary only mode, the seconds since the time was last set.
+ */
+uint32_t virtualRtc_getSeconds(void);
+
+
+#endif /* HOST_INC_VIRTUAL_RTC_H_ */
@@ -0,0 +1,122 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Purpose:
+ *		WCET Fixture holds the inputs that drive an event list operation or a
+ *	scheduler update to its most work: the events in the order they are added,
+ *	the time the operation runs at, and the event it acts on.  Work is measured
+ *	in the nodes of the event list stepped through (eventSLL_visits), which is
+ *	the part of an operation that grows with the events.
+ *		Fixtures are the worst layouts found by the wcet_search tool, kept as
+ *	text files with the bound they reached, and replayed by the tests to check
+ *	that no change to the list or the scheduler goes past the bound.
+ */
+
+#ifndef HOST_INC_WCET_FIXTURE_H_
+#define HOST_INC_WCET_FIXTURE_H_
+
+
+#include <host_test.h>
+#include <event_sll.h>
+
+
+/*
+ * Directory of the fixtures, from the host build's directory where the tests are
+ * run.
+ */
+#define WCET_FIXTURE_DIR "Fixture"
+
+/*
+ * Operations measured.
+ */
+typedef enum {
+	WCET_INSERT,		// eventSLL_insert() of the last event into the others
+	WCET_REMOVE,		// eventSLL_remove() of the target event
+	WCET_NEXT_ALARM,	// eventSLL_getNextAlarm() at the time
+	WCET_UPDATE,		// calendar_updateScheduler() at the time, after starting
+	WCET_NUM_OPERATIONS
+} WcetOperation;
+
+/*
+ * An event of a layout, in milliseconds from the start of the calendar except
+ * for the slack.  An event of length 0 is a trigger.  An event with a lead has a
+ * prepare callback.
+ */
+typedef struct {
+	uint32_t start;
+	uint32_t length;
+	uint16_t lead;
+	uint16_t slack;		// seconds
+} WcetEvent;
+
+/*
+ * Inputs of an operation.
+ */
+typedef struct {
+	WcetOperation operation;
+	int count;						// events
+	WcetEvent events[MAX_NUM_EVENTS];	// in the order they are added
+	uint32_t at;					// milliseconds from the start of the calendar
+	int target;						// event acted on, by its order added
+} WcetLayout;
+
+/*
+ * Names of the operations, as in the fixtures' file names.
+ */
+extern const char* const WCET_OPERATION_NAMES[WCET_NUM_OPERATIONS];
+
+
+/* wcetFixture_measure
+ *
+ * Function:
+ *	Runs an operation on its layout and counts the nodes of the event list it
+ *	steps through.  An update initializes the calendar on the Virtual RTC, adds
+ *	the events and starts the scheduler, then sleeps to the time and counts one
+ *	update.
+ *
+ * Parameters:
+ *	layout - inputs of the operation
+ *
+ * Return:
+ *	uint32_t - nodes stepped through
+ */
+uint32_t wcetFixture_measure(const WcetLayout* const layout);
+
+/* wcetFixture_path
+ *
+ * Function:
+ *	Gets the path of an operation's fixture.
+ *
+ * Parameters:
+ *	dir - directory of the fixtures
+ *	operation - the operation
+ *	path - buffer for the path
+ *	size - size of the buffer
+ */
+void wcetFixture_path(const char* const dir, const WcetOperation operation, char* const path,
+		const size_t size);
+
+/* wcetFixture_write
+ *
+ * Function:
+ *	Writes a layout and the bound it reached to a fixture.
+ *
+ * Return:
+ *	bool - true if the fixture was written
+ */
+bool wcetFixture_write(const char* const path, const WcetLayout* const layout,
+		const uint32_t bound);
+
+/* wcetFixture_read
+ *
+ * Function:
+ *	Reads a layout and its bound from a fixture.
+ *
+ * Return:
+ *	bool - true if the fixture was read and its layout fits the event list
+ */
+bool wcetFixture_read(const char* const path, WcetLayout* const layout, uint32_t* const bound);
+
+
+#endif /* HOST_INC_WCET_FIXTURE_H_ */
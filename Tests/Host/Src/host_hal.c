@@ -0,0 +1,446 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ */
+
+
+#include <host_hal.h>
+#include <virtual_rtc.h>
+#include <pthread.h>
+#include <string.h>
+
+
+/*
+ * Times a line can be entered again in a row by its source staying asserted
+ * before it is taken as stuck and disabled.
+ */
+#define STUCK_ENTRIES 1000U
+
+/*
+ * No interrupt handler running.
+ */
+#define NO_IRQ (-1)
+
+/*
+ * Core clock for SysTick, and its reload for the 1 kHz HAL tick.
+ */
+#define CORE_CLOCK_HZ 48000000U
+#define SYSTICK_LOAD ((CORE_CLOCK_HZ / 1000U) - 1U)
+
+
+/*
+ * An emulated interrupt line.
+ */
+typedef struct {
+	void (*handler)(void);		// interrupt handler
+	bool (*isAsserted)(void);	// checks if the source is still asserted
+	bool isEnabled;				// enabled in the NVIC
+	bool isPending;				// pending in the NVIC
+	uint32_t reentries;			// entries in a row with the source asserted
+} Line;
+
+
+/*
+ * Private function prototypes.
+ */
+static void _deliver(void);
+static int _nextPending(void);
+static void _take(const int irq);
+
+
+/*
+ * Emulated core peripherals, interrupt lines and the state serializing them.
+ */
+SysTick_Type hostHal_sysTick = {0, SYSTICK_LOAD, SYSTICK_LOAD, 0};
+DWT_Type hostHal_dwt;
+CoreDebug_Type hostHal_coreDebug;
+static Line _lines[HOST_HAL_NUM_IRQS];		// interrupt lines
+static int _activeIrq = NO_IRQ;				// line of the handler running
+static bool _isExclusive;					// exclusive monitor
+static void (*_exclusiveHook)(void);		// called between exclusive accesses
+static HostHalCounters _counters;			// interrupt counters
+static pthread_mutex_t _lock;				// held while PRIMASK is set or in a handler
+static pthread_once_t _lockOnce = PTHREAD_ONCE_INIT;
+static _Thread_local uint32_t _primask;		// PRIMASK of the thread's context
+
+
+/* _initLock
+ *
+ * Creates the recursive lock, so that a handler can set PRIMASK.
+ */
+static void _initLock(void)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+
+/* hostHal_reset
+ *
+ * Resets the lines, PRIMASK and counters.
+ */
+void hostHal_reset(void)
+{
+	pthread_once(&_lockOnce, _initLock);
+
+	memset(_lines, 0, sizeof(_lines));
+	memset(&_counters, 0, sizeof(_counters));
+	_activeIrq = NO_IRQ;
+	_isExclusive = false;
+	_exclusiveHook = NULL;
+	_primask = 0;
+	hostHal_dwt.CTRL = 0;
+	hostHal_dwt.CYCCNT = 0;
+	hostHal_coreDebug.DEMCR = 0;
+}
+
+
+/* hostHal_setIrqHandler
+ *
+ * Sets the handler and source check of a line.
+ */
+void hostHal_setIrqHandler(const IRQn_Type IRQn, void (*handler)(void),
+		bool (*isAsserted)(void))
+{
+	_lines[IRQn].handler = handler;
+	_lines[IRQn].isAsserted = isAsserted;
+}
+
+
+/* hostHal_raiseIrq
+ *
+ * Pends a line and delivers it if it can be taken.
+ */
+void hostHal_raiseIrq(const IRQn_Type IRQn)
+{
+	_lines[IRQn].isPending = true;
+	_deliver();
+}
+
+
+/* hostHal_isInIrq
+ *
+ * Checks if a handler is running.
+ */
+bool hostHal_isInIrq(void)
+{
+	return _activeIrq != NO_IRQ;
+}
+
+
+/* hostHal_enterIrq
+ *
+ * Enters an interrupt from the calling thread.
+ */
+void hostHal_enterIrq(void)
+{
+	pthread_once(&_lockOnce, _initLock);
+	pthread_mutex_lock(&_lock);
+	_activeIrq = HOST_HAL_NUM_IRQS;
+	_isExclusive = false;
+	_counters.irqEntries++;
+}
+
+
+/* hostHal_exitIrq
+ *
+ * Returns from an interrupt entered with hostHal_enterIrq().
+ */
+void hostHal_exitIrq(void)
+{
+	_activeIrq = NO_IRQ;
+	pthread_mutex_unlock(&_lock);
+}
+
+
+/* hostHal_setExclusiveHook
+ *
+ * Sets the function called between exclusive accesses.
+ */
+void hostHal_setExclusiveHook(void (*hook)(void))
+{
+	_exclusiveHook = hook;
+}
+
+
+/* hostHal_getCounters
+ *
+ * Gets the interrupt counters.
+ */
+void hostHal_getCounters(HostHalCounters* const counters)
+{
+	*counters = _counters;
+}
+
+
+/* hostHal_readReg
+ *
+ * Reads a register, through the Virtual RTC for its registers.
+ */
+uint32_t hostHal_readReg(__IO uint32_t* const reg)
+{
+	uint32_t value;
+
+	if (virtualRtc_read(reg, &value))
+		return value;
+
+	return *reg;
+}
+
+
+/* hostHal_writeReg
+ *
+ * Writes a register, through the Virtual RTC for its registers.
+ */
+void hostHal_writeReg(__IO uint32_t* const reg, const uint32_t value)
+{
+	if (!virtualRtc_write(reg, value))
+		*reg = value;
+}
+
+
+/* __get_PRIMASK
+ *
+ * Gets PRIMASK of the calling thread.
+ */
+uint32_t __get_PRIMASK(void)
+{
+	return _primask;
+}
+
+
+/* __set_PRIMASK
+ *
+ * Sets PRIMASK of the calling thread, delivering pending interrupts when it is
+ * cleared.
+ */
+void __set_PRIMASK(uint32_t priMask)
+{
+	pthread_once(&_lockOnce, _initLock);
+
+	if (priMask != 0U && _primask == 0U)
+	{
+		pthread_mutex_lock(&_lock);
+		_primask = 1;
+	}
+	else if (priMask == 0U && _primask != 0U)
+	{
+		_primask = 0;
+		pthread_mutex_unlock(&_lock);
+		_deliver();
+	}
+}
+
+
+/* __disable_irq
+ *
+ * Sets PRIMASK.
+ */
+void __disable_irq(void)
+{
+	__set_PRIMASK(1);
+}
+
+
+/* __enable_irq
+ *
+ * Clears PRIMASK.
+ */
+void __enable_irq(void)
+{
+	__set_PRIMASK(0);
+}
+
+
+#if (__CORTEX_M >= 3U)
+/* __LDREXW
+ *
+ * Loads a word and sets the exclusive monitor.  The exclusive hook runs after
+ * the load, where an interrupt can be taken before the store.
+ */
+uint32_t __LDREXW(__IO uint32_t* addr)
+{
+	uint32_t value;
+
+	pthread_once(&_lockOnce, _initLock);
+	pthread_mutex_lock(&_lock);
+	value = *addr;
+	_isExclusive = true;
+	pthread_mutex_unlock(&_lock);
+
+	if (_exclusiveHook != NULL)
+		_exclusiveHook();
+
+	return value;
+}
+
+
+/* __STREXW
+ *
+ * Stores a word if the exclusive monitor is still set.  Returns 0 if stored.
+ */
+uint32_t __STREXW(uint32_t value, __IO uint32_t* addr)
+{
+	uint32_t failed = 1;
+
+	pthread_mutex_lock(&_lock);
+	if (_isExclusive)
+	{
+		*addr = value;
+		failed = 0;
+	}
+	else
+	{
+		_counters.exclusiveFails++;
+	}
+	_isExclusive = false;
+	pthread_mutex_unlock(&_lock);
+
+	return failed;
+}
+#endif
+
+
+/* HAL_NVIC_EnableIRQ
+ *
+ * Enables a line.  A source that is asserted pends it.
+ */
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	_lines[IRQn].isEnabled = true;
+	if (_lines[IRQn].isAsserted != NULL && _lines[IRQn].isAsserted())
+		_lines[IRQn].isPending = true;
+	_deliver();
+}
+
+
+/* HAL_NVIC_DisableIRQ
+ *
+ * Disables a line.  It stays pending.
+ */
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+	_lines[IRQn].isEnabled = false;
+}
+
+
+/* HAL_NVIC_ClearPendingIRQ
+ *
+ * Clears a line's pending state.  A source that is still asserted pends it
+ * again.
+ */
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+	_lines[IRQn].isPending = _lines[IRQn].isAsserted != NULL && _lines[IRQn].isAsserted();
+	_lines[IRQn].reentries = 0;
+}
+
+
+/* HAL_NVIC_SetPendingIRQ
+ *
+ * Pends a line.
+ */
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+	hostHal_raiseIrq(IRQn);
+}
+
+
+/* HAL_GetTick
+ *
+ * Gets the milliseconds of the Virtual RTC's clock.
+ */
+uint32_t HAL_GetTick(void)
+{
+	return (uint32_t)(virtualRtc_getMicros() / 1000U);
+}
+
+
+/* HAL_GetTickFreq
+ *
+ * Gets the frequency of the tick.
+ */
+HAL_TickFreqTypeDef HAL_GetTickFreq(void)
+{
+	return HAL_TICK_FREQ_1KHZ;
+}
+
+
+/* _deliver
+ *
+ * Takes pending interrupts while PRIMASK is clear and no handler is running.
+ */
+static void _deliver(void)
+{
+	int irq;
+
+	pthread_once(&_lockOnce, _initLock);
+
+	if (_primask != 0U)
+		return;
+
+	pthread_mutex_lock(&_lock);
+	while (_activeIrq == NO_IRQ && (irq = _nextPending()) != NO_IRQ)
+	{
+		_take(irq);
+	}
+	pthread_mutex_unlock(&_lock);
+}
+
+
+/* _nextPending
+ *
+ * Gets the lowest pending and enabled line with a handler, the highest priority
+ * with equal priorities.
+ */
+static int _nextPending(void)
+{
+	int irq;
+
+	for (irq = 0; irq < HOST_HAL_NUM_IRQS; irq++)
+	{
+		if (_lines[irq].isPending && _lines[irq].isEnabled && _lines[irq].handler != NULL)
+			return irq;
+	}
+
+	return NO_IRQ;
+}
+
+
+/* _take
+ *
+ * Runs a line's handler.  A source still asserted on return pends the line
+ * again, and one that stays asserted disables the line as stuck.
+ */
+static void _take(const int irq)
+{
+	Line* line = &_lines[irq];
+
+	line->isPending = false;
+	_activeIrq = irq;
+	_isExclusive = false;
+	_counters.irqEntries++;
+
+	line->handler();
+
+	_activeIrq = NO_IRQ;
+
+	if (line->isAsserted != NULL && line->isAsserted())
+	{
+		if (++line->reentries >= STUCK_ENTRIES)
+		{
+			_counters.stuckIrqs++;
+			line->isEnabled = false;
+			line->reentries = 0;
+		}
+		line->isPending = true;
+	}
+	else
+	{
+		line->reentries = 0;
+	}
+}
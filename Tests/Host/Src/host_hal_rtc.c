@@ -0,0 +1,353 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * RTC functions of the Host HAL.  They access the Virtual RTC's registers in the
+ * same order as the STM32WL HAL's, so register counts are comparable, without
+ * the HAL's parameter checks, locking and timeouts.
+ */
+
+
+#include <host_hal.h>
+
+
+/*
+ * Backup registers of the tamper block.
+ */
+#define NUM_BACKUP_REGISTERS 20U
+
+/*
+ * Frequency of the RTC's clock (LSE).
+ */
+#define LSE_HZ 32768U
+
+
+/* HAL_RTC_SetTime
+ *
+ * Sets the time in the initialization mode.  In binary only mode the time is not
+ * used, and leaving the initialization mode restarts the counter.
+ */
+HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* sTime,
+		uint32_t Format)
+{
+	uint32_t tmpreg;
+
+	__HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+	SET_BIT(RTC->ICSR, RTC_ICSR_INIT);
+
+	if (hrtc->Init.BinMode != RTC_BINARY_ONLY)
+	{
+		if (Format == RTC_FORMAT_BIN)
+		{
+			tmpreg = ((uint32_t)RTC_ByteToBcd2(sTime->Hours) << RTC_TR_HU_Pos)
+					| ((uint32_t)RTC_ByteToBcd2(sTime->Minutes) << RTC_TR_MNU_Pos)
+					| ((uint32_t)RTC_ByteToBcd2(sTime->Seconds) << RTC_TR_SU_Pos);
+		}
+		else
+		{
+			tmpreg = ((uint32_t)sTime->Hours << RTC_TR_HU_Pos)
+					| ((uint32_t)sTime->Minutes << RTC_TR_MNU_Pos)
+					| ((uint32_t)sTime->Seconds << RTC_TR_SU_Pos);
+		}
+		WRITE_REG(RTC->TR, tmpreg);
+	}
+
+	CLEAR_BIT(RTC->ICSR, RTC_ICSR_INIT);
+	__HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+	return HAL_OK;
+}
+
+
+/* HAL_RTC_GetTime
+ *
+ * Gets the time.  Reading the sub-seconds and time locks the date until it is
+ * read.
+ */
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef* hrtc, RTC_TimeTypeDef* sTime,
+		uint32_t Format)
+{
+	uint32_t tmpreg;
+
+	UNUSED(hrtc);
+
+	sTime->SubSeconds = READ_REG(RTC->SSR);
+	sTime->SecondFraction = READ_REG(RTC->PRER) & RTC_PRER_PREDIV_S;
+	tmpreg = READ_REG(RTC->TR);
+
+	sTime->Hours = (uint8_t)((tmpreg & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos);
+	sTime->Minutes = (uint8_t)((tmpreg & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos);
+	sTime->Seconds = (uint8_t)((tmpreg & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos);
+	sTime->TimeFormat = (uint8_t)((tmpreg & RTC_TR_PM) >> RTC_TR_PM_Pos);
+
+	if (Format == RTC_FORMAT_BIN)
+	{
+		sTime->Hours = RTC_Bcd2ToByte(sTime->Hours);
+		sTime->Minutes = RTC_Bcd2ToByte(sTime->Minutes);
+		sTime->Seconds = RTC_Bcd2ToByte(sTime->Seconds);
+	}
+
+	return HAL_OK;
+}
+
+
+/* HAL_RTC_SetDate
+ *
+ * Sets the date in the initialization mode.
+ */
+HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* sDate,
+		uint32_t Format)
+{
+	uint32_t tmpreg;
+
+	if (Format == RTC_FORMAT_BIN)
+	{
+		tmpreg = ((uint32_t)RTC_ByteToBcd2(sDate->Year) << RTC_DR_YU_Pos)
+				| ((uint32_t)RTC_ByteToBcd2(sDate->Month) << RTC_DR_MU_Pos)
+				| ((uint32_t)RTC_ByteToBcd2(sDate->Date) << RTC_DR_DU_Pos)
+				| ((uint32_t)sDate->WeekDay << RTC_DR_WDU_Pos);
+	}
+	else
+	{
+		tmpreg = ((uint32_t)sDate->Year << RTC_DR_YU_Pos)
+				| ((uint32_t)sDate->Month << RTC_DR_MU_Pos)
+				| ((uint32_t)sDate->Date << RTC_DR_DU_Pos)
+				| ((uint32_t)sDate->WeekDay << RTC_DR_WDU_Pos);
+	}
+
+	__HAL_RTC_WRITEPROTECTION_DISABLE(hrtc);
+	SET_BIT(RTC->ICSR, RTC_ICSR_INIT);
+	WRITE_REG(RTC->DR, tmpreg);
+	CLEAR_BIT(RTC->ICSR, RTC_ICSR_INIT);
+	__HAL_RTC_WRITEPROTECTION_ENABLE(hrtc);
+
+	return HAL_OK;
+}
+
+
+/* HAL_RTC_GetDate
+ *
+ * Gets the date, unlocking the time and date.
+ */
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef* hrtc, RTC_DateTypeDef* sDate,
+		uint32_t Format)
+{
+	uint32_t tmpreg;
+
+	UNUSED(hrtc);
+
+	tmpreg = READ_REG(RTC->DR);
+
+	sDate->Year = (uint8_t)((tmpreg & (RTC_DR_YT | RTC_DR_YU)) >> RTC_DR_YU_Pos);
+	sDate->Month = (uint8_t)((tmpreg & (RTC_DR_MT | RTC_DR_MU)) >> RTC_DR_MU_Pos);
+	sDate->Date = (uint8_t)((tmpreg & (RTC_DR_DT | RTC_DR_DU)) >> RTC_DR_DU_Pos);
+	sDate->WeekDay = (uint8_t)((tmpreg & RTC_DR_WDU) >> RTC_DR_WDU_Pos);
+
+	if (Format == RTC_FORMAT_BIN)
+	{
+		sDate->Year = RTC_Bcd2ToByte(sDate->Year);
+		sDate->Month = RTC_Bcd2ToByte(sDate->Month);
+		sDate->Date = RTC_Bcd2ToByte(sDate->Date);
+	}
+
+	return HAL_OK;
+}
+
+
+/* HAL_RTC_GetAlarm
+ *
+ * Gets an alarm's day, time and sub-seconds.
+ */
+HAL_StatusTypeDef HAL_RTC_GetAlarm(RTC_HandleTypeDef* hrtc, RTC_AlarmTypeDef* sAlarm,
+		uint32_t Alarm, uint32_t Format)
+{
+	uint32_t tmpreg;
+	uint32_t subsecondtmpreg;
+
+	UNUSED(hrtc);
+
+	if (Alarm == RTC_ALARM_A)
+	{
+		tmpreg = READ_REG(RTC->ALRMAR);
+		subsecondtmpreg = READ_REG(RTC->ALRMASSR) & RTC_ALRMASSR_SS;
+	}
+	else
+	{
+		tmpreg = READ_REG(RTC->ALRMBR);
+		subsecondtmpreg = READ_REG(RTC->ALRMBSSR) & RTC_ALRMBSSR_SS;
+	}
+
+	sAlarm->Alarm = Alarm;
+	sAlarm->AlarmTime.Hours = (uint8_t)((tmpreg & (RTC_ALRMAR_HT | RTC_ALRMAR_HU)) >> RTC_ALRMAR_HU_Pos);
+	sAlarm->AlarmTime.Minutes = (uint8_t)((tmpreg & (RTC_ALRMAR_MNT | RTC_ALRMAR_MNU)) >> RTC_ALRMAR_MNU_Pos);
+	sAlarm->AlarmTime.Seconds = (uint8_t)((tmpreg & (RTC_ALRMAR_ST | RTC_ALRMAR_SU)) >> RTC_ALRMAR_SU_Pos);
+	sAlarm->AlarmTime.TimeFormat = (uint8_t)((tmpreg & RTC_ALRMAR_PM) >> RTC_ALRMAR_PM_Pos);
+	sAlarm->AlarmTime.SubSeconds = subsecondtmpreg;
+	sAlarm->AlarmDateWeekDay = (uint8_t)((tmpreg & (RTC_ALRMAR_DT | RTC_ALRMAR_DU)) >> RTC_ALRMAR_DU_Pos);
+	sAlarm->AlarmDateWeekDaySel = tmpreg & RTC_ALRMAR_WDSEL;
+	sAlarm->AlarmMask = tmpreg & RTC_ALARMMASK_ALL;
+
+	if (Format == RTC_FORMAT_BIN)
+	{
+		sAlarm->AlarmTime.Hours = RTC_Bcd2ToByte(sAlarm->AlarmTime.Hours);
+		sAlarm->AlarmTime.Minutes = RTC_Bcd2ToByte(sAlarm->AlarmTime.Minutes);
+		sAlarm->AlarmTime.Seconds = RTC_Bcd2ToByte(sAlarm->AlarmTime.Seconds);
+		sAlarm->AlarmDateWeekDay = RTC_Bcd2ToByte(sAlarm->AlarmDateWeekDay);
+	}
+
+	return HAL_OK;
+}
+
+
+/* HAL_RTC_AlarmIRQHandler
+ *
+ * Clears the flags of the enabled alarms that fired and calls their callbacks.
+ */
+void HAL_RTC_AlarmIRQHandler(RTC_HandleTypeDef* hrtc)
+{
+	uint32_t tmp = READ_REG(RTC->MISR) & hrtc->IsEnabled.RtcFeatures;
+
+	if ((tmp & RTC_MISR_ALRAMF) != 0U)
+	{
+		WRITE_REG(RTC->SCR, RTC_SCR_CALRAF);
+		HAL_RTC_AlarmAEventCallback(hrtc);
+	}
+
+	if ((tmp & RTC_MISR_ALRBMF) != 0U)
+	{
+		WRITE_REG(RTC->SCR, RTC_SCR_CALRBF);
+		HAL_RTCEx_AlarmBEventCallback(hrtc);
+	}
+}
+
+
+/* HAL_RTCEx_WakeUpTimerIRQHandler
+ *
+ * Clears the wakeup timer flag and calls its callback.
+ */
+void HAL_RTCEx_WakeUpTimerIRQHandler(RTC_HandleTypeDef* hrtc)
+{
+	if ((READ_REG(RTC->MISR) & RTC_MISR_WUTMF) != 0U)
+	{
+		WRITE_REG(RTC->SCR, RTC_SCR_CWUTF);
+		HAL_RTCEx_WakeUpTimerEventCallback(hrtc);
+	}
+}
+
+
+/* HAL_RTCEx_TimeStampIRQHandler
+ *
+ * Calls the timestamp callback and clears the timestamp flags.
+ */
+void HAL_RTCEx_TimeStampIRQHandler(RTC_HandleTypeDef* hrtc)
+{
+	if ((READ_REG(RTC->MISR) & RTC_MISR_TSMF) != 0U)
+	{
+		HAL_RTCEx_TimeStampEventCallback(hrtc);
+		WRITE_REG(RTC->SCR, RTC_SCR_CITSF | RTC_SCR_CTSF);
+	}
+}
+
+
+/* HAL_RTCEx_SSRUIRQHandler
+ *
+ * Clears the sub-second underflow flag and calls its callback.
+ */
+void HAL_RTCEx_SSRUIRQHandler(RTC_HandleTypeDef* hrtc)
+{
+	if ((READ_REG(RTC->MISR) & RTC_MISR_SSRUMF) != 0U)
+	{
+		WRITE_REG(RTC->SCR, RTC_SCR_CSSRUF);
+		HAL_RTCEx_SSRUEventCallback(hrtc);
+	}
+}
+
+
+/* HAL_RTCEx_TamperIRQHandler
+ *
+ * Clears the tamper flags and calls their callbacks.
+ */
+void HAL_RTCEx_TamperIRQHandler(RTC_HandleTypeDef* hrtc)
+{
+	uint32_t tmp = READ_REG(TAMP->MISR);
+
+	WRITE_REG(TAMP->SCR, tmp);
+
+	if ((tmp & TAMP_MISR_TAMP1MF) != 0U)
+		HAL_RTCEx_Tamper1EventCallback(hrtc);
+	if ((tmp & TAMP_MISR_TAMP2MF) != 0U)
+		HAL_RTCEx_Tamper2EventCallback(hrtc);
+	if ((tmp & TAMP_MISR_TAMP3MF) != 0U)
+		HAL_RTCEx_Tamper3EventCallback(hrtc);
+}
+
+
+/*
+ * Callbacks, overridden by the application.
+ */
+__weak void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef* hrtc) { UNUSED(hrtc); }
+__weak void HAL_RTCEx_AlarmBEventCallback(RTC_HandleTypeDef* hrtc) { UNUSED(hrtc); }
+__weak void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef* hrtc) { UNUSED(hrtc); }
+__weak void HAL_RTCEx_TimeStampEventCallback(RTC_HandleTypeDef* hrtc) { UNUSED(hrtc); }
+__weak void HAL_RTCEx_SSRUEventCallback(RTC_HandleTypeDef* hrtc) { UNUSED(hrtc); }
+__weak void HAL_RTCEx_Tamper1EventCallback(RTC_HandleTypeDef* hrtc) { UNUSED(hrtc); }
+__weak void HAL_RTCEx_Tamper2EventCallback(RTC_HandleTypeDef* hrtc) { UNUSED(hrtc); }
+__weak void HAL_RTCEx_Tamper3EventCallback(RTC_HandleTypeDef* hrtc) { UNUSED(hrtc); }
+
+
+/* HAL_RTCEx_BKUPWrite
+ *
+ * Writes a backup register.
+ */
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef* hrtc, uint32_t BackupRegister, uint32_t Data)
+{
+	UNUSED(hrtc);
+
+	if (BackupRegister < NUM_BACKUP_REGISTERS)
+		WRITE_REG(TAMP->BKPR[BackupRegister], Data);
+}
+
+
+/* HAL_RTCEx_BKUPRead
+ *
+ * Reads a backup register.
+ */
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef* hrtc, uint32_t BackupRegister)
+{
+	UNUSED(hrtc);
+
+	if (BackupRegister < NUM_BACKUP_REGISTERS)
+		return READ_REG(TAMP->BKPR[BackupRegister]);
+
+	return 0;
+}
+
+
+/* RTC_ByteToBcd2
+ *
+ * Converts a byte from binary to BCD.
+ */
+uint8_t RTC_ByteToBcd2(uint8_t Value)
+{
+	return (uint8_t)(((Value / 10U) << 4U) | (Value % 10U));
+}
+
+
+/* RTC_Bcd2ToByte
+ *
+ * Converts a byte from BCD to binary.
+ */
+uint8_t RTC_Bcd2ToByte(uint8_t Value)
+{
+	return (uint8_t)(((Value >> 4U) * 10U) + (Value & 0x0FU));
+}
+
+
+/* HAL_RCCEx_GetPeriphCLKFreq
+ *
+ * Gets the frequency of a peripheral clock.  The RTC is clocked by the LSE.
+ */
+uint32_t HAL_RCCEx_GetPeriphCLKFreq(uint32_t PeriphClk)
+{
+	return (PeriphClk == RCC_PERIPHCLK_RTC) ? LSE_HZ : 0U;
+}
@@ -0,0 +1,242 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ */
+
+
+#include <host_test.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+
+/*
+ * Private function prototypes.
+ */
+static void _calendarIrqHandler(void);
+static void _halIrqHandler(void);
+
+
+/*
+ * Test state.
+ */
+RTC_HandleTypeDef hostTest_hrtc;
+static int _failures;			// failed checks of the test case
+static int _casesRun;			// test cases run
+static int _casesFailed;		// test cases failed
+static uint64_t _offsetMillis;	// calendar milliseconds at the Virtual RTC's zero
+
+
+/* hostTest_check
+ *
+ * Reports a failed check.
+ */
+void hostTest_check(const bool condition, const char* const text, const char* const file,
+		const int line)
+{
+	if (!condition)
+	{
+		_failures++;
+		printf("    %s:%d: CHECK(%s) failed\n", file, line, text);
+	}
+}
+
+
+/* hostTest_checkEqual
+ *
+ * Reports a failed equality check.
+ */
+void hostTest_checkEqual(const long long expected, const long long actual,
+		const char* const text, const char* const file, const int line)
+{
+	if (expected != actual)
+	{
+		_failures++;
+		printf("    %s:%d: %s is %lld, expected %lld\n", file, line, text, actual, expected);
+	}
+}
+
+
+/* hostTest_run
+ *
+ * Runs a test case in a child process.
+ */
+void hostTest_run(const char* const name, void (*test)(void))
+{
+	pid_t pid;
+	int status = 0;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0)
+	{
+		_failures = 0;
+		test();
+		fflush(stdout);
+		_exit(_failures == 0 ? 0 : 1);
+	}
+
+	waitpid(pid, &status, 0);
+	_casesRun++;
+
+	if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+	{
+		printf("  pass  %s\n", name);
+	}
+	else
+	{
+		_casesFailed++;
+		if (WIFSIGNALED(status))
+			printf("  FAIL  %s (signal %d)\n", name, WTERMSIG(status));
+		else
+			printf("  FAIL  %s\n", name);
+	}
+}
+
+
+/* hostTest_finish
+ *
+ * Reports the test cases run.
+ */
+int hostTest_finish(void)
+{
+	printf("%d of %d test cases passed\n", _casesRun - _casesFailed, _casesRun);
+
+	return _casesFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+/* hostTest_initCalendar
+ *
+ * Resets the HAL and RTC and initializes the calendar.
+ */
+void hostTest_initCalendar(const DateTime now)
+{
+	hostHal_reset();
+	virtualRtc_init(&hostTest_hrtc, HOST_TEST_BIN_MODE, HOST_TEST_ASYNCH_PREDIV);
+	hostTest_useHalIrq(false);
+	HAL_NVIC_EnableIRQ(VIRTUAL_RTC_IRQn);
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_init(&hostTest_hrtc));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_setDateTime(now));
+
+	// the binary counter counts from the time set, the BCD calendar holds it
+	_offsetMillis = (HOST_TEST_BIN_MODE == RTC_BINARY_ONLY) ? hostTest_millisOf(now) : 0U;
+}
+
+
+/* hostTest_useHalIrq
+ *
+ * Selects the RTC interrupt handler.
+ */
+void hostTest_useHalIrq(const bool useHal)
+{
+	hostHal_setIrqHandler(VIRTUAL_RTC_IRQn, useHal ? _halIrqHandler : _calendarIrqHandler,
+			virtualRtc_isAsserted);
+}
+
+
+/* hostTest_runFor
+ *
+ * Updates the scheduler and sleeps to the next alarm until the time has passed.
+ */
+void hostTest_runFor(const uint64_t micros)
+{
+	uint64_t end = virtualRtc_getMicros() + micros;
+
+	calendar_updateScheduler();
+	while (virtualRtc_getMicros() < end)
+	{
+		virtualRtc_advanceToAlarm(end - virtualRtc_getMicros());
+		calendar_updateScheduler();
+	}
+}
+
+
+/* hostTest_nowMillis
+ *
+ * Gets the calendar in milliseconds.
+ */
+uint64_t hostTest_nowMillis(void)
+{
+	return _offsetMillis + (virtualRtc_getCalendarMicros() / 1000U);
+}
+
+
+/* hostTest_millisOf
+ *
+ * Gets a date and time in milliseconds.
+ */
+uint64_t hostTest_millisOf(const DateTime dateTime)
+{
+	return ((uint64_t)dateTime_toSeconds(dateTime) * 1000U) + dateTime.millisecond;
+}
+
+
+/* hostTest_dateTime
+ *
+ * Gets the date and time some milliseconds after another.
+ */
+DateTime hostTest_dateTime(const DateTime from, const uint64_t millis)
+{
+	DateTime dateTime;
+	uint64_t total = hostTest_millisOf(from) + millis;
+
+	dateTime_fromSeconds((uint32_t)(total / 1000U), &dateTime);
+	dateTime.millisecond = (uint16_t)(total % 1000U);
+
+	return dateTime;
+}
+
+
+/* hostTest_resolutionMillis
+ *
+ * Gets the length of one tick in milliseconds.
+ */
+uint32_t hostTest_resolutionMillis(void)
+{
+	return (1000U + virtualRtc_getTicksPerSecond() - 1U) / virtualRtc_getTicksPerSecond();
+}
+
+
+/* HAL_RTC_AlarmAEventCallback
+ *
+ * Alarm A callback of HAL_RTC_AlarmIRQHandler(), as in the usage example.
+ */
+void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef* hrtc)
+{
+	UNUSED(hrtc);
+	calendar_AlarmA_ISR();
+}
+
+
+/* HAL_RTCEx_AlarmBEventCallback
+ *
+ * Alarm B callback of HAL_RTC_AlarmIRQHandler(), as in the usage example.
+ */
+void HAL_RTCEx_AlarmBEventCallback(RTC_HandleTypeDef* hrtc)
+{
+	UNUSED(hrtc);
+	calendar_AlarmB_ISR();
+}
+
+
+/* _calendarIrqHandler
+ *
+ * RTC interrupt handler of the usage example.
+ */
+static void _calendarIrqHandler(void)
+{
+	calendar_RTC_IRQHandler(&hostTest_hrtc);
+}
+
+
+/* _halIrqHandler
+ *
+ * RTC interrupt handler through the HAL.
+ */
+static void _halIrqHandler(void)
+{
+	HAL_RTC_AlarmIRQHandler(&hostTest_hrtc);
+}
@@ -0,0 +1,906 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ */
+
+
+#include <virtual_rtc.h>
+#include <date_time.h>
+#include <string.h>
+
+
+/*
+ * Microseconds in a second.
+ */
+#define MICROS_PER_SECOND 1000000ULL
+
+/*
+ * Seconds in a day, hour and minute.
+ */
+#define SECONDS_PER_DAY 86400U
+#define SECONDS_PER_HOUR 3600U
+#define SECONDS_PER_MINUTE 60U
+
+/*
+ * Sub-second bits an alarm compares at most in BCD and binary only modes.
+ */
+#define MAX_BCD_SS_BITS 15U
+#define MAX_BIN_SS_BITS 32U
+
+/*
+ * Write protection key sequence.
+ */
+#define WPR_KEY_1 0xCAU
+#define WPR_KEY_2 0x53U
+
+/*
+ * Flags of the RTC that assert the interrupt line of each core.
+ */
+#if defined(CORE_CM4)
+#define LINE_FLAGS (RTC_MISR_ALRAMF | RTC_MISR_ALRBMF)
+#else
+#define LINE_FLAGS 0xFFFFFFFFU
+#endif
+
+
+/*
+ * One of the RTC's two alarms.
+ */
+typedef struct {
+	__IO uint32_t* alarmReg;		// ALRMxR
+	__IO uint32_t* subSecondMaskReg;	// ALRMxSSR, without the sub-seconds
+	__IO uint32_t* subSecondReg;	// ALRxBINR, with the sub-seconds of ALRMxSSR
+	uint32_t enableBit;				// CR ALRxE
+	uint32_t flag;					// SR ALRxF
+} Alarm;
+
+
+/*
+ * Private function prototypes.
+ */
+static void _getAlarm(const int whichAlarm, Alarm* const alarm);
+static bool _advanceTo(const uint64_t target, const bool stopAtAlarm);
+static bool _nextMatch(const Alarm* const alarm, const uint64_t after,
+		const uint64_t limit, uint64_t* const match);
+static bool _nextBcdMatch(const Alarm* const alarm, const uint64_t after,
+		const uint64_t limit, uint64_t* const match);
+static bool _nextBinaryMatch(const Alarm* const alarm, const uint64_t after,
+		const uint64_t limit, uint64_t* const match);
+static uint32_t _mismatchSkip(const uint32_t alarmReg, const uint32_t seconds);
+static uint64_t _ticksIn(const uint64_t micros);
+static uint64_t _microsOf(const uint64_t ticks);
+static uint64_t _calendarTick(const uint64_t micros);
+static uint32_t _timeRegister(const uint32_t seconds);
+static uint32_t _dateRegister(const uint32_t seconds);
+static uint32_t _secondsFromRegisters(const uint32_t timeReg, const uint32_t dateReg);
+static uint32_t _subSecondBits(const uint32_t subSecondMaskReg, const uint32_t maxBits);
+static uint32_t _enabledFlags(void);
+static bool _isBinary(void);
+static bool _isProtected(__IO uint32_t* const reg);
+static bool _isAlarmRegister(__IO uint32_t* const reg, Alarm* const alarm);
+static void _setFlags(const uint32_t flags);
+static void _callHook(void);
+
+
+/*
+ * Registers of the RTC and the tamper block, and the state behind them.
+ */
+RTC_TypeDef virtualRtc_rtc;
+TAMP_TypeDef virtualRtc_tamp;
+static RTC_HandleTypeDef* _hrtc;		// handle initialized for the RTC
+static uint32_t _ticksPerSecond;		// rate of the clock
+static uint64_t _micros;				// clock since virtualRtc_init()
+static uint64_t _calendarStart;			// clock when the initialization mode was left
+static uint32_t _calendarSeconds;		// calendar seconds when it was left
+static uint32_t _initSeconds;			// calendar seconds written in initialization mode
+static bool _isLocked;					// time and date locked in the shadow registers
+static uint64_t _lockedTick;			// calendar tick locked
+static uint32_t _protectKeys;			// write protection keys written in order
+static VirtualRtcCounters _counters;	// counters of accesses and matches
+static void (*_accessHook)(void);		// function called before each access
+static bool _isInHook;					// the access hook is running
+
+
+/* virtualRtc_init
+ *
+ * Resets the registers and clock, and initializes the handle as HAL_RTC_Init()
+ * would.
+ */
+void virtualRtc_init(RTC_HandleTypeDef* const hrtc, const uint32_t binMode,
+		const uint32_t asynchPrediv)
+{
+	memset(&virtualRtc_rtc, 0, sizeof(virtualRtc_rtc));
+	memset(&virtualRtc_tamp, 0, sizeof(virtualRtc_tamp));
+	memset(&_counters, 0, sizeof(_counters));
+	memset(hrtc, 0, sizeof(*hrtc));
+
+	_ticksPerSecond = VIRTUAL_RTC_LSE_HZ / (asynchPrediv + 1U);
+	_micros = 0;
+	_calendarStart = 0;
+	_calendarSeconds = 0;
+	_initSeconds = 0;
+	_isLocked = false;
+	_protectKeys = 0;
+	_accessHook = NULL;
+	_isInHook = false;
+
+	// the date resets to the first of January
+	virtualRtc_rtc.PRER = (asynchPrediv << RTC_PRER_PREDIV_A_Pos)
+			| ((_ticksPerSecond - 1U) << RTC_PRER_PREDIV_S_Pos);
+	virtualRtc_rtc.ICSR = binMode | RTC_ICSR_RSF;
+
+	hrtc->Instance = RTC;
+	hrtc->Init.HourFormat = RTC_HOURFORMAT_24;
+	hrtc->Init.AsynchPrediv = asynchPrediv;
+	hrtc->Init.SynchPrediv = _ticksPerSecond - 1U;
+	hrtc->Init.BinMode = binMode;
+	_hrtc = hrtc;
+}
+
+
+/* virtualRtc_advance
+ *
+ * Moves the clock forward through each alarm match.
+ */
+void virtualRtc_advance(const uint64_t micros)
+{
+	_advanceTo(_micros + micros, false);
+}
+
+
+/* virtualRtc_advanceToAlarm
+ *
+ * Moves the clock forward to the next alarm match within a limit.
+ */
+bool virtualRtc_advanceToAlarm(const uint64_t maxMicros)
+{
+	return _advanceTo(_micros + maxMicros, true);
+}
+
+
+/* virtualRtc_getMicros
+ *
+ * Gets the clock.
+ */
+uint64_t virtualRtc_getMicros(void)
+{
+	return _micros;
+}
+
+
+/* virtualRtc_getTicksPerSecond
+ *
+ * Gets the rate of the clock.
+ */
+uint32_t virtualRtc_getTicksPerSecond(void)
+{
+	return _ticksPerSecond;
+}
+
+
+/* virtualRtc_getSeconds
+ *
+ * Gets the calendar's whole seconds.
+ */
+uint32_t virtualRtc_getSeconds(void)
+{
+	return (uint32_t)(_calendarTick(_micros) / _ticksPerSecond);
+}
+
+
+/* virtualRtc_getCalendarMicros
+ *
+ * Gets the calendar in microseconds.
+ */
+uint64_t virtualRtc_getCalendarMicros(void)
+{
+	return ((uint64_t)_calendarSeconds * MICROS_PER_SECOND) + (_micros - _calendarStart);
+}
+
+
+/* virtualRtc_raiseFlags
+ *
+ * Sets RTC or tamper flags and asserts the interrupt.
+ */
+void virtualRtc_raiseFlags(const uint32_t flags, const bool tamper)
+{
+	if (tamper)
+	{
+		virtualRtc_tamp.SR |= flags;
+		if (virtualRtc_isAsserted())
+			hostHal_raiseIrq(VIRTUAL_RTC_IRQn);
+	}
+	else
+	{
+		_setFlags(flags);
+	}
+}
+
+
+/* virtualRtc_isAsserted
+ *
+ * Checks if an enabled flag of the core's RTC interrupt is set.
+ */
+bool virtualRtc_isAsserted(void)
+{
+	uint32_t enabled = _enabledFlags();
+
+#if defined(CORE_CM4)
+	return (virtualRtc_rtc.SR & enabled & LINE_FLAGS) != 0U;
+#else
+	return (virtualRtc_rtc.SR & enabled & LINE_FLAGS) != 0U || virtualRtc_tamp.SR != 0U;
+#endif
+}
+
+
+/* virtualRtc_setAccessHook
+ *
+ * Sets the function called before each register access.
+ */
+void virtualRtc_setAccessHook(void (*hook)(void))
+{
+	_accessHook = hook;
+}
+
+
+/* virtualRtc_getCounters
+ *
+ * Gets the counters.
+ */
+void virtualRtc_getCounters(VirtualRtcCounters* const counters)
+{
+	*counters = _counters;
+}
+
+
+/* virtualRtc_resetCounters
+ *
+ * Resets the counters.
+ */
+void virtualRtc_resetCounters(void)
+{
+	memset(&_counters, 0, sizeof(_counters));
+}
+
+
+/* virtualRtc_read
+ *
+ * Reads an RTC or tamper register.  The time, date, sub-second and masked
+ * status registers are computed from the clock.
+ */
+bool virtualRtc_read(__IO uint32_t* const reg, uint32_t* const value)
+{
+	uint64_t tick;
+	Alarm alarm;
+
+	if (!((reg >= (__IO uint32_t*)&virtualRtc_rtc
+			&& reg < (__IO uint32_t*)(&virtualRtc_rtc + 1))
+			|| (reg >= (__IO uint32_t*)&virtualRtc_tamp
+			&& reg < (__IO uint32_t*)(&virtualRtc_tamp + 1))))
+	{
+		return false;
+	}
+
+	_callHook();
+	_counters.reads++;
+
+	tick = _calendarTick(_micros);
+
+	if (reg == &virtualRtc_rtc.SSR)
+	{
+		if (_isBinary())
+		{
+			*value = ~(uint32_t)(tick - ((uint64_t)_calendarSeconds * _ticksPerSecond));
+		}
+		else
+		{
+			// reading the sub-seconds locks the time and date
+			if (!_isLocked)
+			{
+				_isLocked = true;
+				_lockedTick = tick;
+			}
+			*value = (_ticksPerSecond - 1U) - (uint32_t)(tick % _ticksPerSecond);
+		}
+	}
+	else if (reg == &virtualRtc_rtc.TR)
+	{
+		if (_isBinary())
+		{
+			*value = 0;
+		}
+		else
+		{
+			// reading the time locks the date
+			if (!_isLocked)
+			{
+				_isLocked = true;
+				_lockedTick = tick;
+			}
+			*value = _timeRegister((uint32_t)(_lockedTick / _ticksPerSecond));
+		}
+	}
+	else if (reg == &virtualRtc_rtc.DR)
+	{
+		if (_isBinary())
+		{
+			*value = 0;
+		}
+		else
+		{
+			// reading the date unlocks the time and date
+			*value = _dateRegister((uint32_t)((_isLocked ? _lockedTick : tick)
+					/ _ticksPerSecond));
+			_isLocked = false;
+		}
+	}
+	else if (reg == &virtualRtc_rtc.MISR)
+	{
+		*value = virtualRtc_rtc.SR & _enabledFlags();
+	}
+	else if (reg == &virtualRtc_tamp.MISR)
+	{
+		*value = virtualRtc_tamp.SR;
+	}
+	else if (reg == &virtualRtc_rtc.ALRMASSR || reg == &virtualRtc_rtc.ALRMBSSR)
+	{
+		// the sub-seconds of the alarm are those of its binary register
+		_getAlarm(reg == &virtualRtc_rtc.ALRMASSR ? 0 : 1, &alarm);
+		*value = (*alarm.subSecondMaskReg & ~RTC_ALRMASSR_SS)
+				| (*alarm.subSecondReg & RTC_ALRMASSR_SS);
+	}
+	else
+	{
+		*value = *reg;
+	}
+
+	return true;
+}
+
+
+/* virtualRtc_write
+ *
+ * Writes an RTC or tamper register.  Writes to protected registers while write
+ * protected, and to an alarm's registers while it is enabled, are ignored.
+ */
+bool virtualRtc_write(__IO uint32_t* const reg, const uint32_t value)
+{
+	Alarm alarm;
+	uint32_t cr;
+
+	if (!((reg >= (__IO uint32_t*)&virtualRtc_rtc
+			&& reg < (__IO uint32_t*)(&virtualRtc_rtc + 1))
+			|| (reg >= (__IO uint32_t*)&virtualRtc_tamp
+			&& reg < (__IO uint32_t*)(&virtualRtc_tamp + 1))))
+	{
+		return false;
+	}
+
+	_callHook();
+	_counters.writes++;
+
+	// write protection key sequence
+	if (reg == &virtualRtc_rtc.WPR)
+	{
+		if (value == WPR_KEY_1)
+			_protectKeys = 1;
+		else if (value == WPR_KEY_2 && _protectKeys == 1)
+			_protectKeys = 2;
+		else
+			_protectKeys = 0;
+		return true;
+	}
+
+	if (_isProtected(reg) && _protectKeys != 2)
+	{
+		_counters.ignoredWrites++;
+		return true;
+	}
+
+	// alarm registers are written with the alarm disabled
+	if (_isAlarmRegister(reg, &alarm))
+	{
+		if (virtualRtc_rtc.CR & alarm.enableBit)
+		{
+			_counters.ignoredWrites++;
+		}
+		else if (reg == alarm.subSecondMaskReg)
+		{
+			*alarm.subSecondMaskReg = value & ~RTC_ALRMASSR_SS;
+			*alarm.subSecondReg = (*alarm.subSecondReg & ~RTC_ALRMASSR_SS)
+					| (value & RTC_ALRMASSR_SS);
+		}
+		else
+		{
+			*reg = value;
+		}
+		return true;
+	}
+
+	if (reg == &virtualRtc_rtc.ICSR)
+	{
+		// entering the initialization mode holds the calendar, and leaving it
+		// restarts the calendar at the time and date written
+		if ((value & RTC_ICSR_INIT) && !(virtualRtc_rtc.ICSR & RTC_ICSR_INIT))
+		{
+			_initSeconds = virtualRtc_getSeconds();
+			virtualRtc_rtc.ICSR |= RTC_ICSR_INIT | RTC_ICSR_INITF;
+		}
+		else if (!(value & RTC_ICSR_INIT) && (virtualRtc_rtc.ICSR & RTC_ICSR_INIT))
+		{
+			_calendarStart = _micros;
+			_calendarSeconds = _isBinary() ? 0U : _initSeconds;
+			_isLocked = false;
+			virtualRtc_rtc.ICSR &= ~(RTC_ICSR_INIT | RTC_ICSR_INITF);
+		}
+	}
+	else if (reg == &virtualRtc_rtc.TR || reg == &virtualRtc_rtc.DR)
+	{
+		// the time and date are written in the initialization mode
+		if (!(virtualRtc_rtc.ICSR & RTC_ICSR_INIT))
+		{
+			_counters.ignoredWrites++;
+		}
+		else if (reg == &virtualRtc_rtc.TR)
+		{
+			_initSeconds = _secondsFromRegisters(value, _dateRegister(_initSeconds));
+		}
+		else
+		{
+			_initSeconds = _secondsFromRegisters(_timeRegister(_initSeconds), value);
+		}
+	}
+	else if (reg == &virtualRtc_rtc.SCR)
+	{
+		virtualRtc_rtc.SR &= ~value;
+	}
+	else if (reg == &virtualRtc_tamp.SCR)
+	{
+		virtualRtc_tamp.SR &= ~value;
+	}
+	else if (reg == &virtualRtc_rtc.SSR || reg == &virtualRtc_rtc.SR
+			|| reg == &virtualRtc_rtc.MISR || reg == &virtualRtc_tamp.SR
+			|| reg == &virtualRtc_tamp.MISR)
+	{
+		// read only
+		_counters.ignoredWrites++;
+	}
+	else if (reg == &virtualRtc_rtc.CR)
+	{
+		// enabling an interrupt with its flag set asserts the line
+		cr = virtualRtc_rtc.CR;
+		virtualRtc_rtc.CR = value;
+		if ((value & ~cr) != 0U && virtualRtc_isAsserted())
+			hostHal_raiseIrq(VIRTUAL_RTC_IRQn);
+	}
+	else
+	{
+		*reg = value;
+	}
+
+	return true;
+}
+
+
+/* _getAlarm
+ *
+ * Gets the registers and bits of alarm A (0) or B (1).
+ */
+static void _getAlarm(const int whichAlarm, Alarm* const alarm)
+{
+	if (whichAlarm == 0)
+	{
+		alarm->alarmReg = &virtualRtc_rtc.ALRMAR;
+		alarm->subSecondMaskReg = &virtualRtc_rtc.ALRMASSR;
+		alarm->subSecondReg = &virtualRtc_rtc.ALRABINR;
+		alarm->enableBit = RTC_CR_ALRAE;
+		alarm->flag = RTC_SR_ALRAF;
+	}
+	else
+	{
+		alarm->alarmReg = &virtualRtc_rtc.ALRMBR;
+		alarm->subSecondMaskReg = &virtualRtc_rtc.ALRMBSSR;
+		alarm->subSecondReg = &virtualRtc_rtc.ALRBBINR;
+		alarm->enableBit = RTC_CR_ALRBE;
+		alarm->flag = RTC_SR_ALRBF;
+	}
+}
+
+
+/* _advanceTo
+ *
+ * Moves the clock to a target, stopping at each alarm match on the way to set
+ * the flags of the alarms that match and take their interrupt.  The handler can
+ * re-arm the alarms, so the next match is found again after each.
+ */
+static bool _advanceTo(const uint64_t target, const bool stopAtAlarm)
+{
+	Alarm alarm;
+	uint64_t after, limit, match, earliest;
+	uint32_t flags;
+	int i;
+
+	for (;;)
+	{
+		after = _calendarTick(_micros);
+		limit = _calendarTick(target);
+		flags = 0;
+		earliest = 0;
+
+		// the earliest match of the alarms, both alarms can match the same tick
+		for (i = 0; i < 2; i++)
+		{
+			_getAlarm(i, &alarm);
+			if (_nextMatch(&alarm, after, limit, &match))
+			{
+				if (flags == 0U || match < earliest)
+				{
+					earliest = match;
+					flags = alarm.flag;
+				}
+				else if (match == earliest)
+				{
+					flags |= alarm.flag;
+				}
+			}
+		}
+
+		// no alarm matches before the target
+		if (flags == 0U)
+		{
+			_micros = target;
+			return false;
+		}
+
+		// move to the start of the tick that matches
+		_micros = _calendarStart + _microsOf(earliest
+				- ((uint64_t)_calendarSeconds * _ticksPerSecond));
+		_setFlags(flags);
+
+		if (stopAtAlarm)
+			return true;
+	}
+}
+
+
+/* _nextMatch
+ *
+ * Finds the first calendar tick after a tick, and up to a limit, that an
+ * enabled alarm matches.
+ */
+static bool _nextMatch(const Alarm* const alarm, const uint64_t after,
+		const uint64_t limit, uint64_t* const match)
+{
+	if (!(virtualRtc_rtc.CR & alarm->enableBit) || after >= limit)
+		return false;
+
+	if (_isBinary())
+		return _nextBinaryMatch(alarm, after, limit, match);
+	else
+		return _nextBcdMatch(alarm, after, limit, match);
+}
+
+
+/* _nextBcdMatch
+ *
+ * Finds the first match of an alarm in BCD mode.  Seconds whose unmasked day
+ * and time fields differ are skipped by the largest field that differs, then
+ * the sub-seconds are compared in a second that matches.  With no sub-second
+ * bits compared the alarm matches at the start of the second.
+ */
+static bool _nextBcdMatch(const Alarm* const alarm, const uint64_t after,
+		const uint64_t limit, uint64_t* const match)
+{
+	uint32_t alarmReg = *alarm->alarmReg;
+	uint32_t bits = _subSecondBits(*alarm->subSecondMaskReg, MAX_BCD_SS_BITS);
+	uint32_t mask = (bits == 0U) ? 0U : (0xFFFFFFFFU >> (32U - bits));
+	uint32_t subSeconds = *alarm->subSecondReg;
+	uint64_t tick = after + 1U;
+	uint32_t seconds, skip, first, k;
+
+	while (tick <= limit)
+	{
+		seconds = (uint32_t)(tick / _ticksPerSecond);
+
+		// skip to the next second whose fields could match
+		skip = _mismatchSkip(alarmReg, seconds);
+		if (skip != 0U)
+		{
+			tick = (uint64_t)skip * _ticksPerSecond;
+			continue;
+		}
+
+		// compare the sub-seconds, the counter counts down
+		first = (uint32_t)(tick % _ticksPerSecond);
+		for (k = first; k < _ticksPerSecond; k++)
+		{
+			if ((mask == 0U) ? (k == 0U)
+					: (((_ticksPerSecond - 1U - k) ^ subSeconds) & mask) == 0U)
+			{
+				*match = ((uint64_t)seconds * _ticksPerSecond) + k;
+				return *match <= limit;
+			}
+		}
+
+		tick = ((uint64_t)seconds + 1U) * _ticksPerSecond;
+	}
+
+	return false;
+}
+
+
+/* _nextBinaryMatch
+ *
+ * Finds the first match of an alarm in binary only mode, where the compared
+ * low bits of the down counter equal the alarm's.
+ */
+static bool _nextBinaryMatch(const Alarm* const alarm, const uint64_t after,
+		const uint64_t limit, uint64_t* const match)
+{
+	uint32_t bits = _subSecondBits(*alarm->subSecondMaskReg, MAX_BIN_SS_BITS);
+	uint64_t mask = (bits == 0U) ? 0U : (0xFFFFFFFFULL >> (32U - bits));
+	uint64_t start = (uint64_t)_calendarSeconds * _ticksPerSecond;
+	uint64_t elapsed = after + 1U - start;
+	uint64_t wanted = (~(uint64_t)*alarm->subSecondReg) & mask;
+
+	// the counter is ~elapsed, so the elapsed ticks' low bits are the inverse of
+	// the alarm's
+	elapsed += (wanted - elapsed) & mask;
+	*match = start + elapsed;
+
+	return *match <= limit;
+}
+
+
+/* _mismatchSkip
+ *
+ * Checks the unmasked day and time fields of an alarm against a second.  Returns
+ * 0 if they match, or the first second of the next day, hour, minute or second
+ * that could, by the largest field that differs.
+ */
+static uint32_t _mismatchSkip(const uint32_t alarmReg, const uint32_t seconds)
+{
+	uint32_t timeReg = _timeRegister(seconds);
+	uint32_t dateReg = _dateRegister(seconds);
+	uint32_t day;
+
+	if (!(alarmReg & RTC_ALRMAR_MSK4))
+	{
+		if (alarmReg & RTC_ALRMAR_WDSEL)
+			day = (dateReg & RTC_DR_WDU) >> RTC_DR_WDU_Pos;
+		else
+			day = (dateReg & (RTC_DR_DT | RTC_DR_DU)) >> RTC_DR_DU_Pos;
+
+		if (day != ((alarmReg & (RTC_ALRMAR_DT | RTC_ALRMAR_DU)) >> RTC_ALRMAR_DU_Pos))
+			return ((seconds / SECONDS_PER_DAY) + 1U) * SECONDS_PER_DAY;
+	}
+
+	if (!(alarmReg & RTC_ALRMAR_MSK3)
+			&& ((timeReg & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos)
+			!= ((alarmReg & (RTC_ALRMAR_HT | RTC_ALRMAR_HU)) >> RTC_ALRMAR_HU_Pos))
+	{
+		return ((seconds / SECONDS_PER_HOUR) + 1U) * SECONDS_PER_HOUR;
+	}
+
+	if (!(alarmReg & RTC_ALRMAR_MSK2)
+			&& ((timeReg & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos)
+			!= ((alarmReg & (RTC_ALRMAR_MNT | RTC_ALRMAR_MNU)) >> RTC_ALRMAR_MNU_Pos))
+	{
+		return ((seconds / SECONDS_PER_MINUTE) + 1U) * SECONDS_PER_MINUTE;
+	}
+
+	if (!(alarmReg & RTC_ALRMAR_MSK1)
+			&& ((timeReg & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos)
+			!= ((alarmReg & (RTC_ALRMAR_ST | RTC_ALRMAR_SU)) >> RTC_ALRMAR_SU_Pos))
+	{
+		return seconds + 1U;
+	}
+
+	return 0;
+}
+
+
+/* _ticksIn
+ *
+ * Converts a duration of the clock to whole ticks.
+ */
+static uint64_t _ticksIn(const uint64_t micros)
+{
+	return ((micros / MICROS_PER_SECOND) * _ticksPerSecond)
+			+ (((micros % MICROS_PER_SECOND) * _ticksPerSecond) / MICROS_PER_SECOND);
+}
+
+
+/* _microsOf
+ *
+ * Converts ticks to the first microsecond within the last of them.
+ */
+static uint64_t _microsOf(const uint64_t ticks)
+{
+	return ((ticks / _ticksPerSecond) * MICROS_PER_SECOND)
+			+ ((((ticks % _ticksPerSecond) * MICROS_PER_SECOND) + _ticksPerSecond - 1U)
+			/ _ticksPerSecond);
+}
+
+
+/* _calendarTick
+ *
+ * Converts the clock to ticks since the start of the century by the calendar.
+ */
+static uint64_t _calendarTick(const uint64_t micros)
+{
+	return ((uint64_t)_calendarSeconds * _ticksPerSecond) + _ticksIn(micros - _calendarStart);
+}
+
+
+/* _timeRegister
+ *
+ * Encodes the time of day of a second since the start of the century as the
+ * time register.
+ */
+static uint32_t _timeRegister(const uint32_t seconds)
+{
+	DateTime dateTime;
+
+	dateTime_fromSeconds(seconds, &dateTime);
+
+	return ((uint32_t)RTC_ByteToBcd2(dateTime.hour) << RTC_TR_HU_Pos)
+			| ((uint32_t)RTC_ByteToBcd2(dateTime.minute) << RTC_TR_MNU_Pos)
+			| ((uint32_t)RTC_ByteToBcd2(dateTime.second) << RTC_TR_SU_Pos);
+}
+
+
+/* _dateRegister
+ *
+ * Encodes the date of a second since the start of the century as the date
+ * register.  The first of January 2000 was a Saturday (6).
+ */
+static uint32_t _dateRegister(const uint32_t seconds)
+{
+	DateTime dateTime;
+	uint32_t weekDay = (((seconds / SECONDS_PER_DAY) + 5U) % 7U) + 1U;
+
+	dateTime_fromSeconds(seconds, &dateTime);
+
+	return ((uint32_t)RTC_ByteToBcd2(dateTime.year) << RTC_DR_YU_Pos)
+			| (weekDay << RTC_DR_WDU_Pos)
+			| ((uint32_t)RTC_ByteToBcd2(dateTime.month) << RTC_DR_MU_Pos)
+			| ((uint32_t)RTC_ByteToBcd2(dateTime.day) << RTC_DR_DU_Pos);
+}
+
+
+/* _secondsFromRegisters
+ *
+ * Decodes the time and date registers to seconds since the start of the
+ * century.
+ */
+static uint32_t _secondsFromRegisters(const uint32_t timeReg, const uint32_t dateReg)
+{
+	DateTime dateTime;
+
+	dateTime.year = RTC_Bcd2ToByte((uint8_t)((dateReg & (RTC_DR_YT | RTC_DR_YU)) >> RTC_DR_YU_Pos));
+	dateTime.month = RTC_Bcd2ToByte((uint8_t)((dateReg & (RTC_DR_MT | RTC_DR_MU)) >> RTC_DR_MU_Pos));
+	dateTime.day = RTC_Bcd2ToByte((uint8_t)((dateReg & (RTC_DR_DT | RTC_DR_DU)) >> RTC_DR_DU_Pos));
+	dateTime.hour = RTC_Bcd2ToByte((uint8_t)((timeReg & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos));
+	dateTime.minute = RTC_Bcd2ToByte((uint8_t)((timeReg & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos));
+	dateTime.second = RTC_Bcd2ToByte((uint8_t)((timeReg & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos));
+	dateTime.millisecond = 0;
+
+	return dateTime_toSeconds(dateTime);
+}
+
+
+/* _subSecondBits
+ *
+ * Gets the number of low sub-second bits an alarm compares.
+ */
+static uint32_t _subSecondBits(const uint32_t subSecondMaskReg, const uint32_t maxBits)
+{
+	uint32_t bits = (subSecondMaskReg & RTC_ALRMASSR_MASKSS) >> RTC_ALRMASSR_MASKSS_Pos;
+
+	return (bits > maxBits) ? maxBits : bits;
+}
+
+
+/* _enabledFlags
+ *
+ * Gets the RTC flags whose interrupts are enabled.
+ */
+static uint32_t _enabledFlags(void)
+{
+	uint32_t enabled = 0;
+	uint32_t cr = virtualRtc_rtc.CR;
+
+	if (cr & RTC_CR_ALRAIE)
+		enabled |= RTC_MISR_ALRAMF;
+	if (cr & RTC_CR_ALRBIE)
+		enabled |= RTC_MISR_ALRBMF;
+	if (cr & RTC_CR_WUTIE)
+		enabled |= RTC_MISR_WUTMF;
+	if (cr & RTC_CR_TSIE)
+		enabled |= RTC_MISR_TSMF | RTC_MISR_TSOVMF | RTC_MISR_ITSMF;
+	if (cr & RTC_CR_SSRUIE)
+		enabled |= RTC_MISR_SSRUMF;
+
+	return enabled;
+}
+
+
+/* _isBinary
+ *
+ * Checks if the RTC is in binary only mode.
+ */
+static bool _isBinary(void)
+{
+	return (virtualRtc_rtc.ICSR & RTC_ICSR_BIN) == RTC_BINARY_ONLY;
+}
+
+
+/* _isProtected
+ *
+ * Checks if a register is write protected.
+ */
+static bool _isProtected(__IO uint32_t* const reg)
+{
+	return reg == &virtualRtc_rtc.TR || reg == &virtualRtc_rtc.DR
+			|| reg == &virtualRtc_rtc.ICSR || reg == &virtualRtc_rtc.PRER
+			|| reg == &virtualRtc_rtc.WUTR || reg == &virtualRtc_rtc.CR
+			|| reg == &virtualRtc_rtc.CALR || reg == &virtualRtc_rtc.SHIFTR
+			|| reg == &virtualRtc_rtc.ALRMAR || reg == &virtualRtc_rtc.ALRMASSR
+			|| reg == &virtualRtc_rtc.ALRMBR || reg == &virtualRtc_rtc.ALRMBSSR
+			|| reg == &virtualRtc_rtc.ALRABINR || reg == &virtualRtc_rtc.ALRBBINR;
+}
+
+
+/* _isAlarmRegister
+ *
+ * Checks if a register is one of an alarm's, and gets the alarm.
+ */
+static bool _isAlarmRegister(__IO uint32_t* const reg, Alarm* const alarm)
+{
+	int i;
+
+	for (i = 0; i < 2; i++)
+	{
+		_getAlarm(i, alarm);
+		if (reg == alarm->alarmReg || reg == alarm->subSecondMaskReg
+				|| reg == alarm->subSecondReg)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/* _setFlags
+ *
+ * Sets RTC flags, and asserts the interrupt if an enabled one is set.
+ */
+static void _setFlags(const uint32_t flags)
+{
+	if (flags & RTC_SR_ALRAF)
+		_counters.alarmMatches[0]++;
+	if (flags & RTC_SR_ALRBF)
+		_counters.alarmMatches[1]++;
+
+	virtualRtc_rtc.SR |= flags;
+	if (virtualRtc_isAsserted())
+		hostHal_raiseIrq(VIRTUAL_RTC_IRQn);
+}
+
+
+/* _callHook
+ *
+ * Calls the access hook, unless it is the one accessing.
+ */
+static void _callHook(void)
+{
+	if (_accessHook != NULL && !_isInHook)
+	{
+		_isInHook = true;
+		_accessHook();
+		_isInHook = false;
+	}
+}
@@ -0,0 +1,230 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ */
+
+
+#include <wcet_fixture.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/*
+ * Start of the calendar the layouts are placed from.
+ */
+static const DateTime START = {24, 6, 1, 0, 0, 0, 0};
+
+const char* const WCET_OPERATION_NAMES[WCET_NUM_OPERATIONS] = {
+	"insert", "remove", "next_alarm", "update"
+};
+
+
+/*
+ * Private function prototypes.
+ */
+static CalendarEvent _event(const WcetEvent* const event);
+static void _fill(Event_SLL* const sll, const WcetLayout* const layout, const int count);
+static uint32_t _measureUpdate(const WcetLayout* const layout);
+static void _noop(void);
+
+
+/*
+ * List the list operations are measured on.
+ */
+static Event_SLL _sll;
+
+
+/* wcetFixture_measure
+ *
+ * Counts the nodes an operation steps through on its layout.
+ */
+uint32_t wcetFixture_measure(const WcetLayout* const layout)
+{
+	DateTime alarm;
+
+	switch (layout->operation)
+	{
+	case WCET_INSERT:
+		_fill(&_sll, layout, layout->count - 1);
+		eventSLL_visits = 0;
+		eventSLL_insert(&_sll, _event(&(layout->events[layout->count - 1])));
+		break;
+	case WCET_REMOVE:
+		_fill(&_sll, layout, layout->count);
+		eventSLL_visits = 0;
+		eventSLL_remove(&_sll, (unsigned int)layout->target);
+		break;
+	case WCET_NEXT_ALARM:
+		_fill(&_sll, layout, layout->count);
+		eventSLL_visits = 0;
+		eventSLL_getNextAlarm(&_sll, hostTest_dateTime(START, layout->at), &alarm);
+		break;
+	default:
+		return _measureUpdate(layout);
+	}
+
+	return eventSLL_visits;
+}
+
+
+/* wcetFixture_path
+ *
+ * Gets the path of an operation's fixture.
+ */
+void wcetFixture_path(const char* const dir, const WcetOperation operation, char* const path,
+		const size_t size)
+{
+	snprintf(path, size, "%s/wcet_%s.txt", dir, WCET_OPERATION_NAMES[operation]);
+}
+
+
+/* wcetFixture_write
+ *
+ * Writes a layout and its bound to a fixture.
+ */
+bool wcetFixture_write(const char* const path, const WcetLayout* const layout,
+		const uint32_t bound)
+{
+	FILE* file;
+	int i;
+
+	file = fopen(path, "w");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "# worst case found by wcet_search, in event list nodes stepped through\n");
+	fprintf(file, "# event: start ms, length ms, lead ms, slack s, in the order added\n");
+	fprintf(file, "operation %s\n", WCET_OPERATION_NAMES[layout->operation]);
+	fprintf(file, "bound %u\n", bound);
+	fprintf(file, "at %u\n", layout->at);
+	fprintf(file, "target %d\n", layout->target);
+	for (i = 0; i < layout->count; i++)
+	{
+		fprintf(file, "event %u %u %u %u\n", layout->events[i].start, layout->events[i].length,
+				layout->events[i].lead, layout->events[i].slack);
+	}
+
+	return fclose(file) == 0;
+}
+
+
+/* wcetFixture_read
+ *
+ * Reads a layout and its bound from a fixture.
+ */
+bool wcetFixture_read(const char* const path, WcetLayout* const layout, uint32_t* const bound)
+{
+	FILE* file;
+	char line[128];
+	char name[32];
+	unsigned int lead;
+	unsigned int slack;
+	int i;
+	bool isValid = true;
+
+	file = fopen(path, "r");
+	if (file == NULL)
+		return false;
+
+	memset(layout, 0, sizeof(*layout));
+	layout->operation = WCET_NUM_OPERATIONS;
+	while (isValid && fgets(line, sizeof(line), file) != NULL)
+	{
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		if (sscanf(line, "operation %31s", name) == 1)
+		{
+			for (i = 0; i < WCET_NUM_OPERATIONS; i++)
+			{
+				if (strcmp(name, WCET_OPERATION_NAMES[i]) == 0)
+					layout->operation = (WcetOperation)i;
+			}
+		}
+		else if (sscanf(line, "bound %u", bound) == 1
+				|| sscanf(line, "at %u", &(layout->at)) == 1
+				|| sscanf(line, "target %d", &(layout->target)) == 1)
+		{
+		}
+		else if (layout->count < MAX_NUM_EVENTS
+				&& sscanf(line, "event %u %u %u %u", &(layout->events[layout->count].start),
+						&(layout->events[layout->count].length), &lead, &slack) == 4)
+		{
+			layout->events[layout->count].lead = (uint16_t)lead;
+			layout->events[layout->count].slack = (uint16_t)slack;
+			layout->count++;
+		}
+		else
+		{
+			isValid = false;
+		}
+	}
+	fclose(file);
+
+	return isValid && layout->operation != WCET_NUM_OPERATIONS && layout->count > 0
+			&& layout->target >= 0 && layout->target < layout->count;
+}
+
+
+/* _event
+ *
+ * Gets the calendar event of a layout's event.
+ */
+static CalendarEvent _event(const WcetEvent* const event)
+{
+	CalendarEvent calendarEvent = {
+		.start = hostTest_dateTime(START, event->start),
+		.end = hostTest_dateTime(START, (uint64_t)event->start + event->length),
+		.start_callback = _noop,
+		.end_callback = _noop,
+		.slack = event->slack,
+		.prepare_callback = (event->lead > 0U) ? _noop : NULL,
+		.lead = event->lead,
+	};
+
+	return calendarEvent;
+}
+
+
+/* _fill
+ *
+ * Inserts the first of a layout's events into an empty list.  The IDs they take
+ * are their order added.
+ */
+static void _fill(Event_SLL* const sll, const WcetLayout* const layout, const int count)
+{
+	int i;
+
+	eventSLL_reset(sll);
+	for (i = 0; i < count; i++)
+		eventSLL_insert(sll, _event(&(layout->events[i])));
+}
+
+
+/* _measureUpdate
+ *
+ * Counts the nodes one update steps through at the layout's time, on a calendar
+ * started with its events.  The calendar of an earlier layout is reset first.
+ */
+static uint32_t _measureUpdate(const WcetLayout* const layout)
+{
+	int i;
+
+	// stopped and emptied first, the time can only be set while paused
+	calendar_resetEvents();
+	hostTest_initCalendar(START);
+	for (i = 0; i < layout->count; i++)
+		calendar_addEvent(_event(&(layout->events[i])));
+	calendar_startScheduler();
+
+	virtualRtc_advance((uint64_t)layout->at * 1000U);
+	eventSLL_visits = 0;
+	calendar_updateScheduler();
+
+	return eventSLL_visits;
+}
+
+
+static void _noop(void)
+{
+}
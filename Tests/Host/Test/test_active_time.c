@@ -0,0 +1,197 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Active time tests: an event's active time follows its start and end callbacks
+ * on the Virtual RTC's clock, and resetting the events ends it and leaves
+ * nothing of the old schedule armed or pending.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 11, 5, 18, 0, 0, 0};
+
+/*
+ * Seconds from the start of the first event's start and end.
+ */
+#define START_S 10U
+#define END_S 40U
+
+/*
+ * Number of callbacks.
+ */
+static int _starts;
+static int _ends;
+
+
+static void _onStart(void)
+{
+	_starts++;
+}
+
+
+static void _onEnd(void)
+{
+	_ends++;
+}
+
+
+/* _event
+ *
+ * Gets an event between two times in seconds from the start.
+ */
+static CalendarEvent _event(const uint32_t startSeconds, const uint32_t endSeconds)
+{
+	CalendarEvent event = {
+		.start = hostTest_dateTime(START, (uint64_t)startSeconds * 1000U),
+		.end = hostTest_dateTime(START, (uint64_t)endSeconds * 1000U),
+		.start_callback = _onStart,
+		.end_callback = _onEnd,
+	};
+
+	return event;
+}
+
+
+/* _start
+ *
+ * Initializes the calendar with the first event, ID 0, and starts it.
+ */
+static void _start(void)
+{
+	hostTest_initCalendar(START);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(_event(START_S, END_S)));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+}
+
+
+/* _checkActive
+ *
+ * Checks an event's active time and if it is active.
+ */
+static void _checkActive(const unsigned int id, const uint32_t seconds, const bool isActive)
+{
+	uint32_t activeSeconds = 0;
+	bool isActiveNow = !isActive;
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getActiveTime(id, &activeSeconds, &isActiveNow));
+	CHECK_EQUAL(seconds, activeSeconds);
+	CHECK_EQUAL(isActive, isActiveNow);
+}
+
+
+static void test_activeForWindow(void)
+{
+	uint32_t seconds = 0;
+
+	_start();
+
+	hostTest_runFor(60U * 1000000U);
+
+	CHECK_EQUAL(1, _starts);
+	CHECK_EQUAL(1, _ends);
+	_checkActive(0, END_S - START_S, false);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getClassActiveTime(0, &seconds));
+	CHECK_EQUAL(END_S - START_S, seconds);
+}
+
+
+static void test_activeSoFar(void)
+{
+	uint32_t seconds;
+	uint16_t millisecond;
+
+	_start();
+
+	// the time so far is counted to the cached time, brought up to date by
+	// reading the clock
+	hostTest_runFor(25U * 1000000U);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getEpoch(&seconds, &millisecond));
+	_checkActive(0, 25U - START_S, true);
+}
+
+
+static void test_resetEndsActiveTime(void)
+{
+	CalendarStats before;
+	CalendarStats after;
+	uint32_t seconds;
+	uint16_t millisecond;
+
+	_start();
+	hostTest_runFor(25U * 1000000U);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getEpoch(&seconds, &millisecond));
+
+	// resetting inside the event ends its active time without its end callback,
+	// stops the scheduler and disarms the alarms
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_resetEvents());
+	CHECK_EQUAL(0, _ends);
+	CHECK_EQUAL(CALENDAR_PARAMETER_ERROR, calendar_getActiveTime(0, &seconds, NULL));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getClassActiveTime(0, &seconds));
+	CHECK_EQUAL(25U - START_S, seconds);
+	CHECK_EQUAL(CALENDAR_PAUSED, calendar_updateScheduler());
+	CHECK(!(virtualRtc_rtc.CR & (RTC_CR_ALRAE | RTC_CR_ALRBE)));
+
+	// nothing of the old schedule fires or runs past its end
+	calendar_getStats(&before);
+	virtualRtc_advance(30U * 1000000U);
+	calendar_getStats(&after);
+	CHECK_EQUAL(before.alarmsFired, after.alarmsFired);
+
+	// a new schedule runs from a clean state, its event taking ID 0
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(_event(60U, 65U)));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	hostTest_runFor(20U * 1000000U);
+
+	calendar_getStats(&after);
+	CHECK_EQUAL(before.transitions + 2U, after.transitions);
+	CHECK_EQUAL(before.skippedTransitions, after.skippedTransitions);
+	CHECK_EQUAL(2, _starts);
+	CHECK_EQUAL(1, _ends);
+	_checkActive(0, 5U, false);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getClassActiveTime(0, &seconds));
+	CHECK_EQUAL(25U - START_S + 5U, seconds);
+}
+
+
+static void test_resetDuringReplay(void)
+{
+	bool isPending = false;
+	int i;
+
+	hostTest_initCalendar(START);
+	for (i = 0; i < 4; i++)
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(_event(START_S + (2U * i), START_S + (2U * i) + 1U)));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	// the main loop is late, a bounded update leaves transitions to run
+	virtualRtc_advance(20U * 1000000U);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_updateSchedulerBounded(1, &isPending));
+	CHECK(isPending);
+
+	// the reset drops them, the new schedule does not run them
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_resetEvents());
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(_event(40U, 45U)));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	hostTest_runFor(30U * 1000000U);
+
+	CHECK_EQUAL(2, _starts);
+	CHECK_EQUAL(1, _ends);
+	_checkActive(0, 5U, false);
+}
+
+
+int main(void)
+{
+	hostTest_run("active for the event's window", test_activeForWindow);
+	hostTest_run("active so far", test_activeSoFar);
+	hostTest_run("reset ends the active time", test_resetEndsActiveTime);
+	hostTest_run("reset during a bounded replay", test_resetDuringReplay);
+
+	return hostTest_finish();
+}
@@ -0,0 +1,121 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Alarm driver tests: arming an alarm already armed with the same register
+ * values, or disarming one already disarmed, only reads the registers and does
+ * not write them, and the alarm still fires as armed.  New values are written
+ * and confirmed.
+ */
+
+
+#include <host_test.h>
+#include <rtc_calendar_control.h>
+
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 5, 20, 6, 0, 0, 0};
+
+
+/* _accessesOf
+ *
+ * Gets the Virtual RTC's counters since they were last reset.
+ */
+static VirtualRtcCounters _accessesOf(void)
+{
+	VirtualRtcCounters rtc;
+
+	virtualRtc_getCounters(&rtc);
+	virtualRtc_resetCounters();
+
+	return rtc;
+}
+
+
+static void test_sameValuesNotWritten(void)
+{
+	RtcAlarmRegisters regs;
+	VirtualRtcCounters rtc;
+
+	hostTest_initCalendar(START);
+	CHECK_EQUAL(RTC_CALENDAR_CONTROL_OKAY,
+			rtcCalendarControl_encodeAlarm(hostTest_dateTime(START, 2500U), &regs));
+
+	// the first arm writes the registers
+	virtualRtc_resetCounters();
+	CHECK_EQUAL(RTC_CALENDAR_CONTROL_OKAY, rtcCalendarControl_armEncoded_A(&regs));
+	rtc = _accessesOf();
+	CHECK(rtc.writes > 0U);
+	CHECK_EQUAL(regs.subSeconds, virtualRtc_rtc.ALRABINR);
+
+	// arming it again compares them and writes nothing
+	CHECK_EQUAL(RTC_CALENDAR_CONTROL_OKAY, rtcCalendarControl_armEncoded_A(&regs));
+	rtc = _accessesOf();
+	CHECK_EQUAL(0U, rtc.writes);
+	CHECK_EQUAL(0U, rtc.ignoredWrites);
+	CHECK(rtc.reads > 0U);
+
+	// and the alarm fires as first armed
+	CHECK(virtualRtc_advanceToAlarm(5000000U));
+	rtc = _accessesOf();
+	CHECK_EQUAL(1U, rtc.alarmMatches[0]);
+	CHECK_EQUAL(0U, rtc.alarmMatches[1]);
+}
+
+
+static void test_newValuesWritten(void)
+{
+	RtcAlarmRegisters first;
+	RtcAlarmRegisters second;
+	VirtualRtcCounters rtc;
+
+	hostTest_initCalendar(START);
+	rtcCalendarControl_encodeAlarm(hostTest_dateTime(START, 2500U), &first);
+	rtcCalendarControl_encodeAlarm(hostTest_dateTime(START, 3000U), &second);
+	CHECK_EQUAL(RTC_CALENDAR_CONTROL_OKAY, rtcCalendarControl_armEncoded_B(&first));
+
+	// a different value is written, over the armed alarm
+	virtualRtc_resetCounters();
+	CHECK_EQUAL(RTC_CALENDAR_CONTROL_OKAY, rtcCalendarControl_armEncoded_B(&second));
+	rtc = _accessesOf();
+	CHECK(rtc.writes > 0U);
+	CHECK_EQUAL(0U, rtc.ignoredWrites);
+	CHECK_EQUAL(second.subSeconds, virtualRtc_rtc.ALRBBINR);
+}
+
+
+static void test_disarmedNotWritten(void)
+{
+	RtcAlarmRegisters regs;
+	VirtualRtcCounters rtc;
+
+	hostTest_initCalendar(START);
+	rtcCalendarControl_encodeAlarm(hostTest_dateTime(START, 2500U), &regs);
+	CHECK_EQUAL(RTC_CALENDAR_CONTROL_OKAY, rtcCalendarControl_armEncoded_A(&regs));
+
+	// the first disarm writes, the second only reads
+	virtualRtc_resetCounters();
+	CHECK_EQUAL(RTC_CALENDAR_CONTROL_OKAY, rtcCalendarControl_diableAlarm_A());
+	rtc = _accessesOf();
+	CHECK(rtc.writes > 0U);
+
+	CHECK_EQUAL(RTC_CALENDAR_CONTROL_OKAY, rtcCalendarControl_diableAlarm_A());
+	rtc = _accessesOf();
+	CHECK_EQUAL(0U, rtc.writes);
+	CHECK(rtc.reads > 0U);
+
+	// and the alarm does not fire
+	CHECK(!virtualRtc_advanceToAlarm(5000000U));
+}
+
+
+int main(void)
+{
+	hostTest_run("same values not written", test_sameValuesNotWritten);
+	hostTest_run("new values written", test_newValuesWritten);
+	hostTest_run("disarmed alarm not written", test_disarmedNotWritten);
+
+	return hostTest_finish();
+}
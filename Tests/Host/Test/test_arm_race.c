@@ -0,0 +1,180 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Arming race tests: the RTC passes a transition's time while its alarm is being
+ * programmed, so that the alarm can not match until the date comes around
+ * again.  The transition must still run by the next update, not a month later.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar, an hour before the end of a month.
+ */
+static const DateTime START = {24, 4, 30, 23, 0, 0, 0};
+
+/*
+ * Milliseconds from the start of the event's start and end.
+ */
+#define START_MS 1000U
+#define END_MS 2000U
+
+/*
+ * Registers of the alarm being raced, and their values before the update.
+ */
+static __IO uint32_t* _alarmRegs[3];
+static uint32_t _alarmRegsBefore[3];
+static uint32_t _enableBit;
+
+/*
+ * Milliseconds from the start the clock jumps to, and if it has.
+ */
+static uint64_t _jumpTo;
+static bool _hasJumped;
+
+/*
+ * Calendar milliseconds at each callback.
+ */
+static uint64_t _startedAt;
+static uint64_t _endedAt;
+static int _starts;
+static int _ends;
+
+
+static void _onStart(void)
+{
+	_startedAt = hostTest_nowMillis();
+	_starts++;
+}
+
+
+static void _onEnd(void)
+{
+	_endedAt = hostTest_nowMillis();
+	_ends++;
+}
+
+
+/* _isProgrammed
+ *
+ * Checks if a register of the raced alarm has been written, with the alarm not
+ * yet enabled.
+ */
+static bool _isProgrammed(void)
+{
+	int i;
+
+	if (virtualRtc_rtc.CR & _enableBit)
+		return false;
+
+	for (i = 0; i < 3; i++)
+	{
+		if (*_alarmRegs[i] != _alarmRegsBefore[i])
+			return true;
+	}
+
+	return false;
+}
+
+
+/* _jumpWhileProgrammed
+ *
+ * Moves the clock past the raced alarm's time between programming the alarm
+ * and enabling it, as a long preemption would.
+ */
+static void _jumpWhileProgrammed(void)
+{
+	if (!_hasJumped && _isProgrammed())
+	{
+		_hasJumped = true;
+		virtualRtc_advance((hostTest_millisOf(START) + _jumpTo - hostTest_nowMillis()) * 1000U);
+	}
+}
+
+
+/* _race
+ *
+ * Starts the calendar with one event, jumping the clock while the start arms the
+ * alarms.  Alarm A is armed with the start and Alarm B with the end.
+ */
+static void _race(const int whichAlarm, const uint64_t jumpTo)
+{
+	CalendarEvent event = {
+		.start = hostTest_dateTime(START, START_MS),
+		.end = hostTest_dateTime(START, END_MS),
+		.start_callback = _onStart,
+		.end_callback = _onEnd,
+	};
+
+	hostTest_initCalendar(START);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(event));
+
+	if (whichAlarm == 0)
+	{
+		_alarmRegs[0] = &virtualRtc_rtc.ALRMAR;
+		_alarmRegs[1] = &virtualRtc_rtc.ALRMASSR;
+		_alarmRegs[2] = &virtualRtc_rtc.ALRABINR;
+		_enableBit = RTC_CR_ALRAE;
+	}
+	else
+	{
+		_alarmRegs[0] = &virtualRtc_rtc.ALRMBR;
+		_alarmRegs[1] = &virtualRtc_rtc.ALRMBSSR;
+		_alarmRegs[2] = &virtualRtc_rtc.ALRBBINR;
+		_enableBit = RTC_CR_ALRBE;
+	}
+	_alarmRegsBefore[0] = *_alarmRegs[0];
+	_alarmRegsBefore[1] = *_alarmRegs[1];
+	_alarmRegsBefore[2] = *_alarmRegs[2];
+	_jumpTo = jumpTo;
+
+	virtualRtc_setAccessHook(_jumpWhileProgrammed);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	virtualRtc_setAccessHook(NULL);
+	CHECK(_hasJumped);
+}
+
+
+static void test_startPassesWhileArmed(void)
+{
+	_race(0, START_MS + 500U);
+
+	// the start ran by the next update, without the clock moving on
+	calendar_updateScheduler();
+	CHECK_EQUAL(1, _starts);
+	CHECK(_startedAt <= hostTest_millisOf(START) + START_MS + 500U + hostTest_resolutionMillis());
+
+	// the end still runs on its alarm
+	hostTest_runFor(3000000U);
+	CHECK_EQUAL(1, _ends);
+	CHECK(_endedAt >= hostTest_millisOf(START) + END_MS);
+	CHECK(_endedAt <= hostTest_millisOf(START) + END_MS + hostTest_resolutionMillis());
+}
+
+
+static void test_bothPassWhileArmed(void)
+{
+	uint64_t jumpedTo;
+
+	_race(1, END_MS + 500U);
+	jumpedTo = hostTest_millisOf(START) + END_MS + 500U;
+
+	// the clock passed both transitions while Alarm B was armed, Alarm A fired
+	// on the way, and both ran by the next update without the clock moving on
+	calendar_updateScheduler();
+	CHECK_EQUAL(1, _starts);
+	CHECK_EQUAL(1, _ends);
+	CHECK(_endedAt <= jumpedTo + hostTest_resolutionMillis());
+}
+
+
+int main(void)
+{
+	hostTest_run("start passes while its alarm is armed", test_startPassesWhileArmed);
+	hostTest_run("both pass while the alarms are armed", test_bothPassWhileArmed);
+
+	return hostTest_finish();
+}
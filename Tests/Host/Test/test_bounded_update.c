@@ -0,0 +1,206 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Bounded update tests: a late main loop replays the passed transitions at most
+ * K per call, in order, and a pause and restart in the middle of the replay ends
+ * the event the replay last entered and starts the one in progress now.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 4, 15, 9, 0, 0, 0};
+
+/*
+ * Most transitions run per call.
+ */
+#define MAX_TRANSITIONS 2U
+
+/*
+ * Most callbacks logged.
+ */
+#define MAX_LOG 16
+
+/*
+ * Callbacks in the order they ran: an event's number for its start, negated for
+ * its end.  Events are numbered from 1.
+ */
+static int _log[MAX_LOG];
+static int _logCount;
+
+
+/* _record
+ *
+ * Logs a callback.
+ */
+static void _record(const int entry)
+{
+	if (_logCount < MAX_LOG)
+		_log[_logCount] = entry;
+	_logCount++;
+}
+
+
+static void _onStart1(void)
+{
+	_record(1);
+}
+
+
+static void _onEnd1(void)
+{
+	_record(-1);
+}
+
+
+static void _onStart2(void)
+{
+	_record(2);
+}
+
+
+static void _onEnd2(void)
+{
+	_record(-2);
+}
+
+
+static void _onStart3(void)
+{
+	_record(3);
+}
+
+
+static void _onEnd3(void)
+{
+	_record(-3);
+}
+
+
+/* _start
+ *
+ * Starts the calendar with three events, the first two short and back to back,
+ * and the third in progress when the main loop comes back, late.
+ */
+static void _start(void)
+{
+	CalendarEvent events[] = {
+		{
+			.start = hostTest_dateTime(START, 10000U),
+			.end = hostTest_dateTime(START, 11000U),
+			.start_callback = _onStart1,
+			.end_callback = _onEnd1,
+		},
+		{
+			.start = hostTest_dateTime(START, 11000U),
+			.end = hostTest_dateTime(START, 13000U),
+			.start_callback = _onStart2,
+			.end_callback = _onEnd2,
+		},
+		{
+			.start = hostTest_dateTime(START, 20000U),
+			.end = hostTest_dateTime(START, 60000U),
+			.start_callback = _onStart3,
+			.end_callback = _onEnd3,
+		},
+	};
+	unsigned int i;
+
+	hostTest_initCalendar(START);
+	for (i = 0; i < sizeof(events) / sizeof(events[0]); i++)
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(events[i]));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	virtualRtc_advance(30U * 1000000U);
+}
+
+
+/* _updateBounded
+ *
+ * Runs a bounded update and checks it ran no more than the limit.  Returns if
+ * transitions are left to run.
+ */
+static bool _updateBounded(void)
+{
+	CalendarStats before;
+	CalendarStats after;
+	bool isPending = false;
+
+	calendar_getStats(&before);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_updateSchedulerBounded(MAX_TRANSITIONS, &isPending));
+	calendar_getStats(&after);
+	CHECK(after.transitions - before.transitions <= MAX_TRANSITIONS);
+
+	return isPending;
+}
+
+
+/* _checkLog
+ *
+ * Checks the callbacks that ran, in order.
+ */
+static void _checkLog(const int* const expected, const int count)
+{
+	int i;
+
+	CHECK_EQUAL(count, _logCount);
+	for (i = 0; i < count && i < _logCount; i++)
+		CHECK_EQUAL(expected[i], _log[i]);
+}
+
+
+static void test_replayIsBounded(void)
+{
+	const int expected[] = {1, -1, 2, -2, 3};
+	int calls = 1;
+
+	_start();
+
+	// four transitions passed, run two at a time
+	while (_updateBounded())
+		calls++;
+
+	CHECK_EQUAL(2, calls);
+	_checkLog(expected, 5);
+}
+
+
+static void test_restartDuringReplay(void)
+{
+	const int expected[] = {1, -1, 2, -2, 3, -3};
+	CalendarStats stats;
+
+	_start();
+
+	// the replay stops with the second event entered
+	CHECK(_updateBounded());
+	CHECK_EQUAL(3, _logCount);
+
+	// a pause and restart skips the rest of the replay, but ends the second event
+	// and starts the third, in progress now
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_pauseScheduler());
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	CHECK(!_updateBounded());
+	CHECK_EQUAL(5, _logCount);
+
+	// the third ends on its alarm
+	hostTest_runFor(40U * 1000000U);
+	_checkLog(expected, 6);
+
+	calendar_getStats(&stats);
+	CHECK(stats.skippedTransitions > 0U);
+}
+
+
+int main(void)
+{
+	hostTest_run("replay is bounded", test_replayIsBounded);
+	hostTest_run("restart during a replay", test_restartDuringReplay);
+
+	return hostTest_finish();
+}
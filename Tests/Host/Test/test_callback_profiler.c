@@ -0,0 +1,178 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Callback profiler tests: callbacks that take a known number of cycles of the
+ * Host HAL's SysTick are timed into their event's profile, with the count, the
+ * fewest, most and mean cycles, and the callbacks over the budget.  Removing an
+ * event clears its profile for the event that takes its ID next.  Only built
+ * with the profiler (the trace variant).
+ */
+
+
+#include <host_test.h>
+
+
+#ifdef CALENDAR_PROFILE_CALLBACKS
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 7, 1, 12, 0, 0, 0};
+
+/*
+ * Cycles taken by the callbacks: the first event's start well within the budget
+ * and its end over it, the second's exactly the budget.
+ */
+#define UNDER_BUDGET_CYCLES 1000U
+#define OVER_BUDGET_CYCLES (CALENDAR_CALLBACK_BUDGET_CYCLES + 1000U)
+#define AT_BUDGET_CYCLES CALENDAR_CALLBACK_BUDGET_CYCLES
+
+
+/* _spend
+ *
+ * Takes cycles of the cycle counter, built from the HAL tick and SysTick on the
+ * Cortex-M0+: whole ticks by moving the clock, the rest by SysTick's down count.
+ * SysTick must be at its reload.
+ */
+static void _spend(const uint32_t cycles)
+{
+	uint32_t cyclesPerTick = SysTick->LOAD + 1U;
+
+	virtualRtc_advance((uint64_t)(cycles / cyclesPerTick) * 1000U);
+	SysTick->VAL = SysTick->LOAD - (cycles % cyclesPerTick);
+}
+
+
+static void _spendUnderBudget(void)
+{
+	_spend(UNDER_BUDGET_CYCLES);
+}
+
+
+static void _spendOverBudget(void)
+{
+	_spend(OVER_BUDGET_CYCLES);
+}
+
+
+static void _spendAtBudget(void)
+{
+	_spend(AT_BUDGET_CYCLES);
+}
+
+
+/* _addEvent
+ *
+ * Adds an event with its callbacks, a second long and starting some seconds from
+ * the start.
+ */
+static void _addEvent(const uint32_t startSeconds, void (*startCallback)(void),
+		void (*endCallback)(void))
+{
+	CalendarEvent event = {
+		.start = hostTest_dateTime(START, (uint64_t)startSeconds * 1000U),
+		.end = hostTest_dateTime(START, ((uint64_t)startSeconds + 1U) * 1000U),
+		.start_callback = startCallback,
+		.end_callback = endCallback,
+	};
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(event));
+}
+
+
+/* _runFor
+ *
+ * Runs the scheduler, with SysTick at its reload for each update.
+ */
+static void _runFor(const uint64_t micros)
+{
+	uint64_t end = virtualRtc_getMicros() + micros;
+
+	SysTick->VAL = SysTick->LOAD;
+	calendar_updateScheduler();
+	while (virtualRtc_getMicros() < end && virtualRtc_advanceToAlarm(end - virtualRtc_getMicros()))
+	{
+		SysTick->VAL = SysTick->LOAD;
+		calendar_updateScheduler();
+	}
+	SysTick->VAL = SysTick->LOAD;
+}
+
+
+static void test_profilesCallbacks(void)
+{
+	CallbackProfile profile;
+
+	hostTest_initCalendar(START);
+	_addEvent(1U, _spendUnderBudget, _spendOverBudget);
+	_addEvent(3U, _spendAtBudget, _spendAtBudget);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	_runFor(5U * 1000000U);
+
+	// one callback under the budget and one over it
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getCallbackProfile(0U, &profile));
+	CHECK_EQUAL(2U, profile.count);
+	CHECK_EQUAL(UNDER_BUDGET_CYCLES, profile.minCycles);
+	CHECK_EQUAL(OVER_BUDGET_CYCLES, profile.maxCycles);
+	CHECK_EQUAL((UNDER_BUDGET_CYCLES + OVER_BUDGET_CYCLES) / 2U, profile.meanCycles);
+	CHECK_EQUAL(1U, profile.overBudget);
+
+	// exactly the budget is not over it
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getCallbackProfile(1U, &profile));
+	CHECK_EQUAL(2U, profile.count);
+	CHECK_EQUAL(AT_BUDGET_CYCLES, profile.minCycles);
+	CHECK_EQUAL(AT_BUDGET_CYCLES, profile.maxCycles);
+	CHECK_EQUAL(AT_BUDGET_CYCLES, profile.meanCycles);
+	CHECK_EQUAL(0U, profile.overBudget);
+
+	// no event, no profile
+	CHECK_EQUAL(CALENDAR_PARAMETER_ERROR, calendar_getCallbackProfile(2U, &profile));
+}
+
+
+static void test_clearedWhenRemoved(void)
+{
+	CallbackProfile profile;
+
+	hostTest_initCalendar(START);
+	_addEvent(1U, _spendOverBudget, _spendOverBudget);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	_runFor(3U * 1000000U);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getCallbackProfile(0U, &profile));
+	CHECK_EQUAL(2U, profile.count);
+
+	// the removed event's profile is gone
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_pauseScheduler());
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_removeEvent(0U));
+	CHECK_EQUAL(CALENDAR_PARAMETER_ERROR, calendar_getCallbackProfile(0U, &profile));
+
+	// and the event taking its ID starts from nothing
+	_addEvent(10U, _spendUnderBudget, _spendUnderBudget);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getCallbackProfile(0U, &profile));
+	CHECK_EQUAL(0U, profile.count);
+	CHECK_EQUAL(0U, profile.minCycles);
+	CHECK_EQUAL(0U, profile.maxCycles);
+	CHECK_EQUAL(0U, profile.meanCycles);
+	CHECK_EQUAL(0U, profile.overBudget);
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	_runFor(10U * 1000000U);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getCallbackProfile(0U, &profile));
+	CHECK_EQUAL(2U, profile.count);
+	CHECK_EQUAL(UNDER_BUDGET_CYCLES, profile.maxCycles);
+	CHECK_EQUAL(0U, profile.overBudget);
+}
+
+#endif
+
+
+int main(void)
+{
+#ifdef CALENDAR_PROFILE_CALLBACKS
+	hostTest_run("profiles callbacks", test_profilesCallbacks);
+	hostTest_run("cleared when removed", test_clearedWhenRemoved);
+#endif
+
+	return hostTest_finish();
+}
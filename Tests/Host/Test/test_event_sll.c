@@ -0,0 +1,136 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Event SLL tests: the list keeps its events in start order whatever order they
+ * are inserted in, and the scheduler runs them in that order.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 6, 1, 12, 0, 0, 0};
+
+/*
+ * Calendar milliseconds at each start callback.
+ */
+static uint64_t _startedAt[4];
+static int _starts;
+
+
+static void _onStart(void)
+{
+	if (_starts < 4)
+		_startedAt[_starts] = hostTest_nowMillis();
+	_starts++;
+}
+
+
+/* _event
+ *
+ * Gets an event some seconds from the start, lasting a second.
+ */
+static CalendarEvent _event(const uint32_t startSeconds)
+{
+	CalendarEvent event = {
+		.start = hostTest_dateTime(START, startSeconds * 1000U),
+		.end = hostTest_dateTime(START, (startSeconds + 1U) * 1000U),
+		.start_callback = _onStart,
+		.lead = (uint16_t)startSeconds,	// tags the event with its start
+	};
+
+	return event;
+}
+
+
+/* _checkOrder
+ *
+ * Checks that the list holds events with the tags in order.
+ */
+static void _checkOrder(Event_SLL* const sll, const uint16_t* const tags, const int count)
+{
+	int idx = sll->usedHead;
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		CHECK(idx != EVENTS_SLL_NO_EVENT);
+		if (idx == EVENTS_SLL_NO_EVENT)
+			return;
+		CHECK_EQUAL(tags[i], sll->events[idx].event.lead);
+		idx = sll->events[idx].next;
+	}
+	CHECK_EQUAL(EVENTS_SLL_NO_EVENT, idx);
+}
+
+
+static void test_insertKeepsStartOrder(void)
+{
+	static Event_SLL sll;
+	const uint16_t order[] = {10, 15, 17, 20, 30};
+
+	CHECK(eventSLL_reset(&sll));
+
+	// an event between two others is not appended after the later one
+	CHECK(eventSLL_insert(&sll, _event(10)));
+	CHECK(eventSLL_insert(&sll, _event(20)));
+	CHECK(eventSLL_insert(&sll, _event(15)));
+	CHECK(eventSLL_insert(&sll, _event(30)));
+	CHECK(eventSLL_insert(&sll, _event(17)));
+
+	_checkOrder(&sll, order, 5);
+}
+
+
+static void test_equalStartsKeepInsertOrder(void)
+{
+	static Event_SLL sll;
+	CalendarEvent first = _event(10);
+	CalendarEvent second = _event(10);
+	const uint16_t order[] = {5, 1, 2, 20};
+
+	CHECK(eventSLL_reset(&sll));
+
+	first.lead = 1;
+	second.lead = 2;
+	CHECK(eventSLL_insert(&sll, _event(20)));
+	CHECK(eventSLL_insert(&sll, first));
+	CHECK(eventSLL_insert(&sll, _event(5)));
+	CHECK(eventSLL_insert(&sll, second));
+
+	_checkOrder(&sll, order, 4);
+}
+
+
+static void test_schedulerRunsInStartOrder(void)
+{
+	hostTest_initCalendar(START);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(_event(10)));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(_event(30)));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(_event(20)));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	hostTest_runFor(60U * 1000000U);
+
+	CHECK_EQUAL(3, _starts);
+	CHECK(_startedAt[0] >= hostTest_millisOf(START) + 10000U);
+	CHECK(_startedAt[0] < hostTest_millisOf(START) + 11000U);
+	CHECK(_startedAt[1] >= hostTest_millisOf(START) + 20000U);
+	CHECK(_startedAt[1] < hostTest_millisOf(START) + 21000U);
+	CHECK(_startedAt[2] >= hostTest_millisOf(START) + 30000U);
+	CHECK(_startedAt[2] < hostTest_millisOf(START) + 31000U);
+}
+
+
+int main(void)
+{
+	hostTest_run("insert keeps start order", test_insertKeepsStartOrder);
+	hostTest_run("equal starts keep insert order", test_equalStartsKeepInsertOrder);
+	hostTest_run("scheduler runs in start order", test_schedulerRunsInStartOrder);
+
+	return hostTest_finish();
+}
@@ -0,0 +1,218 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * RTC interrupt tests: calendar_RTC_IRQHandler() hands each RTC source other
+ * than the calendar's alarms to the HAL handler that clears it, so that the
+ * interrupt is not taken again and again.  On the Cortex-M4 the other sources
+ * have their own interrupt lines and never reach it.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Interrupts a source may take: its own, and one for an alarm taken with it.
+ */
+#define MAX_IRQ_ENTRIES 2U
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 3, 10, 1, 59, 59, 0};
+
+
+/*
+ * Callbacks of the HAL handlers.
+ */
+static int _wakeups;
+static int _timestamps;
+static int _underflows;
+static int _tampers;
+
+
+void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef* hrtc)
+{
+	UNUSED(hrtc);
+	_wakeups++;
+}
+
+
+void HAL_RTCEx_TimeStampEventCallback(RTC_HandleTypeDef* hrtc)
+{
+	UNUSED(hrtc);
+	_timestamps++;
+}
+
+
+void HAL_RTCEx_SSRUEventCallback(RTC_HandleTypeDef* hrtc)
+{
+	UNUSED(hrtc);
+	_underflows++;
+}
+
+
+void HAL_RTCEx_Tamper2EventCallback(RTC_HandleTypeDef* hrtc)
+{
+	UNUSED(hrtc);
+	_tampers++;
+}
+
+
+/* _enableInterrupts
+ *
+ * Enables interrupts of RTC sources, as the HAL does when they are set up.
+ */
+static void _enableInterrupts(const uint32_t bits)
+{
+	__HAL_RTC_WRITEPROTECTION_DISABLE(&hostTest_hrtc);
+	SET_BIT(RTC->CR, bits);
+	__HAL_RTC_WRITEPROTECTION_ENABLE(&hostTest_hrtc);
+}
+
+
+/* _start
+ *
+ * Initializes the calendar with an event a second from the start, or none, and
+ * clears the interrupt counters.
+ */
+static void _start(const bool hasEvent)
+{
+	CalendarEvent event = {
+		.start = hostTest_dateTime(START, 1000),
+		.end = hostTest_dateTime(START, 2000),
+	};
+
+	hostTest_initCalendar(START);
+	if (hasEvent)
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(event));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	hostHal_reset();
+	hostTest_useHalIrq(false);
+	HAL_NVIC_EnableIRQ(VIRTUAL_RTC_IRQn);
+}
+
+
+#ifdef CORE_CM0PLUS
+
+/* _checkCleared
+ *
+ * Checks that the RTC interrupt was cleared after at most a few entries.
+ */
+static void _checkCleared(void)
+{
+	HostHalCounters hal;
+
+	hostHal_getCounters(&hal);
+	CHECK_EQUAL(0, hal.stuckIrqs);
+	CHECK(hal.irqEntries <= MAX_IRQ_ENTRIES);
+	CHECK(!virtualRtc_isAsserted());
+}
+
+
+static void test_wakeupTimer(void)
+{
+	_start(false);
+	_enableInterrupts(RTC_CR_WUTE | RTC_CR_WUTIE);
+
+	virtualRtc_raiseFlags(RTC_SR_WUTF, false);
+
+	CHECK_EQUAL(1, _wakeups);
+	_checkCleared();
+}
+
+
+static void test_timestamp(void)
+{
+	_start(false);
+	_enableInterrupts(RTC_CR_TSE | RTC_CR_TSIE);
+
+	virtualRtc_raiseFlags(RTC_SR_TSF, false);
+
+	CHECK_EQUAL(1, _timestamps);
+	_checkCleared();
+}
+
+
+static void test_subSecondUnderflow(void)
+{
+	_start(false);
+	_enableInterrupts(RTC_CR_SSRUIE);
+
+	virtualRtc_raiseFlags(RTC_SR_SSRUF, false);
+
+	CHECK_EQUAL(1, _underflows);
+	_checkCleared();
+}
+
+
+static void test_tamper(void)
+{
+	_start(false);
+
+	virtualRtc_raiseFlags(TAMP_MISR_TAMP2MF, true);
+
+	CHECK_EQUAL(1, _tampers);
+	_checkCleared();
+}
+
+
+static void test_alarmWithWakeup(void)
+{
+	CalendarStats stats;
+
+	_start(true);
+	_enableInterrupts(RTC_CR_WUTE | RTC_CR_WUTIE);
+
+	// the wakeup timer flags while the alarm's interrupt is masked, both are
+	// taken in one entry
+	__disable_irq();
+	virtualRtc_raiseFlags(RTC_SR_WUTF, false);
+	virtualRtc_advanceToAlarm(2000000U);
+	__enable_irq();
+
+	CHECK_EQUAL(1, _wakeups);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(1, stats.alarmsFired);
+	_checkCleared();
+}
+
+#else
+
+static void test_otherSourcesOwnLines(void)
+{
+	HostHalCounters hal;
+
+	_start(false);
+	_enableInterrupts(RTC_CR_WUTE | RTC_CR_WUTIE | RTC_CR_SSRUIE);
+
+	virtualRtc_raiseFlags(RTC_SR_WUTF | RTC_SR_SSRUF, false);
+	virtualRtc_raiseFlags(TAMP_MISR_TAMP2MF, true);
+
+	// the alarm line is not asserted, and its handler leaves them alone
+	hostHal_getCounters(&hal);
+	CHECK_EQUAL(0, hal.irqEntries);
+	calendar_RTC_IRQHandler(&hostTest_hrtc);
+	CHECK_EQUAL(0, _wakeups);
+	CHECK_EQUAL(0, _underflows);
+	CHECK_EQUAL(0, _tampers);
+}
+
+#endif
+
+
+int main(void)
+{
+#ifdef CORE_CM0PLUS
+	hostTest_run("wakeup timer", test_wakeupTimer);
+	hostTest_run("timestamp", test_timestamp);
+	hostTest_run("sub-second underflow", test_subSecondUnderflow);
+	hostTest_run("tamper", test_tamper);
+	hostTest_run("alarm with wakeup timer", test_alarmWithWakeup);
+#else
+	hostTest_run("other sources have their own lines", test_otherSourcesOwnLines);
+#endif
+
+	return hostTest_finish();
+}
@@ -0,0 +1,154 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Latency compensation tests: the main loop runs each update a fixed lag after
+ * its alarm.  Events of a compensated class have their alarms armed early by an
+ * estimate that converges on the lag, so their callbacks end up within a few
+ * ticks of their transitions.  Events of the default, uncompensated class are
+ * never armed early and their callbacks always run the lag after.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 6, 3, 8, 0, 0, 0};
+
+/*
+ * Lag of the main loop after each alarm, in microseconds, and the compensated
+ * class the events are given.
+ */
+#define LAG_US 50000U
+#define LAG_MS (LAG_US / 1000U)
+#define COMPENSATED_CLASS 1U
+
+/*
+ * Events, each a second long and two seconds apart, and the transitions of the
+ * first events the estimate is left to converge over.
+ */
+#define NUM_EVENTS (MAX_NUM_EVENTS / 2)
+#define NUM_TRANSITIONS (NUM_EVENTS * 2)
+#define SETTLING_TRANSITIONS 16
+
+/*
+ * Error of each callback after its transition, in milliseconds.
+ */
+static int64_t _errors[NUM_TRANSITIONS];
+static int _callbacks;
+
+
+/* _record
+ *
+ * Records the error of a callback, the transitions are run in order one second
+ * apart.
+ */
+static void _record(void)
+{
+	uint64_t transition = hostTest_millisOf(START) + (((uint64_t)_callbacks + 1U) * 1000U);
+
+	if (_callbacks < NUM_TRANSITIONS)
+		_errors[_callbacks] = (int64_t)hostTest_nowMillis() - (int64_t)transition;
+	_callbacks++;
+}
+
+
+/* _runLagged
+ *
+ * Adds the events with a latency class, and runs them with the main loop lagging
+ * each alarm.
+ */
+static void _runLagged(const uint8_t latencyClass)
+{
+	int i;
+
+	_callbacks = 0;
+	hostTest_initCalendar(START);
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		CalendarEvent event = {
+			.start = hostTest_dateTime(START, ((uint64_t)i * 2U + 1U) * 1000U),
+			.end = hostTest_dateTime(START, ((uint64_t)i * 2U + 2U) * 1000U),
+			.start_callback = _record,
+			.end_callback = _record,
+			.latency_class = latencyClass,
+		};
+
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(event));
+	}
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	calendar_updateScheduler();
+
+	while (_callbacks < NUM_TRANSITIONS && virtualRtc_advanceToAlarm(3000000U))
+	{
+		virtualRtc_advance(LAG_US);
+		calendar_updateScheduler();
+	}
+	CHECK_EQUAL(NUM_TRANSITIONS, _callbacks);
+}
+
+
+static void test_estimateConverges(void)
+{
+	int32_t estimate;
+	int32_t lastError;
+	int64_t tolerance;
+	int i;
+
+	_runLagged(COMPENSATED_CLASS);
+	tolerance = (2 * (int64_t)hostTest_resolutionMillis()) + 4;
+
+	// the first callback lags by the whole lag, then the estimate takes it up
+	CHECK(_errors[0] >= (int64_t)LAG_MS);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getLatency(COMPENSATED_CLASS, &estimate, &lastError));
+	CHECK(estimate >= (int32_t)LAG_MS - (int32_t)tolerance);
+	CHECK(estimate <= (int32_t)LAG_MS + (int32_t)tolerance);
+
+	// once settled, callbacks run within a few ticks of their transitions
+	for (i = SETTLING_TRANSITIONS; i < NUM_TRANSITIONS; i++)
+	{
+		CHECK(_errors[i] <= tolerance);
+		CHECK(_errors[i] >= -tolerance);
+	}
+	CHECK(lastError <= tolerance && lastError >= -tolerance);
+
+	// the uncompensated class was not touched
+	CHECK_EQUAL(CALENDAR_OKAY,
+			calendar_getLatency(CALENDAR_LATENCY_UNCOMPENSATED, &estimate, &lastError));
+	CHECK_EQUAL(0, estimate);
+}
+
+
+static void test_uncompensatedByDefault(void)
+{
+	int32_t estimate;
+	int32_t lastError;
+	int i;
+
+	_runLagged(CALENDAR_LATENCY_UNCOMPENSATED);
+
+	// never run early, every callback lags by the lag, within a tick
+	for (i = 0; i < NUM_TRANSITIONS; i++)
+	{
+		CHECK(_errors[i] >= (int64_t)LAG_MS);
+		CHECK(_errors[i] <= (int64_t)LAG_MS + (int64_t)hostTest_resolutionMillis());
+	}
+
+	// the lag is measured, but not compensated
+	CHECK_EQUAL(CALENDAR_OKAY,
+			calendar_getLatency(CALENDAR_LATENCY_UNCOMPENSATED, &estimate, &lastError));
+	CHECK_EQUAL(0, estimate);
+	CHECK(lastError >= (int32_t)LAG_MS - (int32_t)hostTest_resolutionMillis());
+}
+
+
+int main(void)
+{
+	hostTest_run("estimate converges on the lag", test_estimateConverges);
+	hostTest_run("uncompensated by default", test_uncompensatedByDefault);
+
+	return hostTest_finish();
+}
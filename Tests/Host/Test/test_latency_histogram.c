@@ -0,0 +1,149 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Latency histogram tests: the main loop runs each update a known number of RTC
+ * ticks after its alarm, so that the latencies measured fall on each side of the
+ * buckets' bounds.  Latencies past the last bound all land in the last bucket,
+ * and a reset clears the histogram for the alarms after it.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar, on a whole second.
+ */
+static const DateTime START = {24, 9, 9, 9, 0, 0, 0};
+
+/*
+ * Seconds between triggers, longer than the longest lag.
+ */
+#define TRIGGER_SECONDS 20U
+
+/*
+ * Lag of the main loop after each alarm, in ticks of the RTC at 256 Hz, and the
+ * latency measured from it in milliseconds, rounded down to a tick's millisecond.
+ */
+static const uint32_t LAG_TICKS[] = {0, 1, 2, 3, 4, 8, 9, 16, 17, 32, 33, 2560};
+#define NUM_LAGS (sizeof(LAG_TICKS) / sizeof(LAG_TICKS[0]))
+
+/*
+ * Bucket of each lag's latency (0, 3, 7, 11, 15, 31, 35, 62, 66, 125, 128, and
+ * 10000 ms), bucket n holding latencies under 2^(n + 1) ms, the last all longer.
+ */
+static const uint32_t EXPECTED_BUCKETS[CALENDAR_LATENCY_BUCKETS] = {1, 1, 1, 2, 1, 2, 2, 2};
+#define EXPECTED_MAX_MILLIS 10000U
+
+
+static void _onTrigger(void)
+{
+}
+
+
+/* _start
+ *
+ * Starts the calendar with a trigger for each lag and one after them.
+ */
+static void _start(void)
+{
+	uint32_t i;
+
+	hostTest_initCalendar(START);
+	for (i = 0; i < NUM_LAGS + 1U; i++)
+	{
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_addTrigger(
+				hostTest_dateTime(START, (uint64_t)(i + 1U) * TRIGGER_SECONDS * 1000U), _onTrigger));
+	}
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	calendar_updateScheduler();
+}
+
+
+/* _runLagged
+ *
+ * Sleeps to the next alarm and updates the scheduler some ticks after it.
+ */
+static void _runLagged(const uint32_t lagTicks)
+{
+	uint32_t ticksPerSecond = virtualRtc_getTicksPerSecond();
+
+	CHECK(virtualRtc_advanceToAlarm((uint64_t)TRIGGER_SECONDS * 1000000U));
+	virtualRtc_advance((((uint64_t)lagTicks * 1000000U) + ticksPerSecond - 1U) / ticksPerSecond);
+	calendar_updateScheduler();
+}
+
+
+static void test_bucketBounds(void)
+{
+	CalendarLatencyHistogram histogram;
+	uint32_t i;
+
+	_start();
+	for (i = 0; i < NUM_LAGS; i++)
+		_runLagged(LAG_TICKS[i]);
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getLatencyHistogram(&histogram));
+	CHECK_EQUAL(NUM_LAGS, histogram.count);
+	CHECK_EQUAL(EXPECTED_MAX_MILLIS, histogram.maxMillis);
+	for (i = 0; i < CALENDAR_LATENCY_BUCKETS; i++)
+		CHECK_EQUAL(EXPECTED_BUCKETS[i], histogram.buckets[i]);
+}
+
+
+static void test_overflowSaturates(void)
+{
+	CalendarLatencyHistogram histogram;
+	uint32_t i;
+
+	// the longest lags all land in the last bucket, however long
+	_start();
+	_runLagged(33U);
+	_runLagged(256U);
+	_runLagged(2560U);
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getLatencyHistogram(&histogram));
+	CHECK_EQUAL(3U, histogram.count);
+	CHECK_EQUAL(3U, histogram.buckets[CALENDAR_LATENCY_BUCKETS - 1]);
+	for (i = 0; i < CALENDAR_LATENCY_BUCKETS - 1; i++)
+		CHECK_EQUAL(0U, histogram.buckets[i]);
+	CHECK_EQUAL(EXPECTED_MAX_MILLIS, histogram.maxMillis);
+}
+
+
+static void test_reset(void)
+{
+	CalendarLatencyHistogram histogram;
+	uint32_t i;
+
+	_start();
+	_runLagged(2560U);
+	_runLagged(4U);
+
+	// a reset clears the buckets, the count and the longest latency
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_resetLatencyHistogram());
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getLatencyHistogram(&histogram));
+	CHECK_EQUAL(0U, histogram.count);
+	CHECK_EQUAL(0U, histogram.maxMillis);
+	for (i = 0; i < CALENDAR_LATENCY_BUCKETS; i++)
+		CHECK_EQUAL(0U, histogram.buckets[i]);
+
+	// and the next alarm is counted from nothing, the alarm before it not again
+	calendar_updateScheduler();
+	_runLagged(2U);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getLatencyHistogram(&histogram));
+	CHECK_EQUAL(1U, histogram.count);
+	CHECK_EQUAL(1U, histogram.buckets[2]);
+	CHECK_EQUAL(7U, histogram.maxMillis);
+}
+
+
+int main(void)
+{
+	hostTest_run("bucket bounds", test_bucketBounds);
+	hostTest_run("overflow saturates", test_overflowSaturates);
+	hostTest_run("reset", test_reset);
+
+	return hostTest_finish();
+}
@@ -0,0 +1,154 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Pending fire stress tests: a thread standing in for the alarm interrupt signals
+ * fires as fast as it can while the main loop takes them, through the exclusive
+ * accesses on the Cortex-M4 and the PRIMASK section on the Cortex-M0+.  Every
+ * fire must be taken exactly once.
+ */
+
+
+#include <host_test.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+
+/*
+ * Number of fires the interrupt thread signals.
+ */
+#define NUM_FIRES 200000U
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 2, 29, 12, 0, 0, 0};
+
+
+/*
+ * The calendar's signal of fired alarms, private to calendar.c.
+ */
+void _alarmFired(void);
+uint32_t _takePendingFires(void);
+
+
+/*
+ * Fires signalled by the interrupt thread, and if it is still signalling.  When
+ * racing, the thread waits to signal until the main loop is between an exclusive
+ * load and its store.
+ */
+static atomic_uint _signalled;
+static atomic_bool _isSignalling;
+static atomic_bool _isRacing;
+static atomic_bool _hasLoaded;
+
+
+/* _interruptThread
+ *
+ * Signals fires from interrupts entered one after the other.
+ */
+static void* _interruptThread(void* arg)
+{
+	uint32_t i;
+
+	(void)arg;
+	while (atomic_load(&_isRacing) && !atomic_load(&_hasLoaded))
+	{
+	}
+
+	for (i = 0; i < NUM_FIRES; i++)
+	{
+		hostHal_enterIrq();
+		_alarmFired();
+		hostHal_exitIrq();
+		atomic_fetch_add(&_signalled, 1U);
+	}
+	atomic_store(&_isSignalling, false);
+
+	return NULL;
+}
+
+
+/* _stress
+ *
+ * Takes fires in the main loop while the interrupt thread signals them, and
+ * checks that every fire was taken once.  The hook is called between each
+ * exclusive load and store, if not NULL.
+ */
+static void _stress(void (*exclusiveHook)(void))
+{
+	pthread_t thread;
+	CalendarStats stats;
+	uint64_t taken = 0;
+
+	hostTest_initCalendar(START);
+	hostHal_reset();
+	hostHal_setExclusiveHook(exclusiveHook);
+	atomic_store(&_signalled, 0U);
+	atomic_store(&_isSignalling, true);
+	atomic_store(&_isRacing, exclusiveHook != NULL);
+	atomic_store(&_hasLoaded, false);
+
+	CHECK_EQUAL(0, pthread_create(&thread, NULL, _interruptThread, NULL));
+	while (atomic_load(&_isSignalling))
+		taken += _takePendingFires();
+	CHECK_EQUAL(0, pthread_join(thread, NULL));
+	hostHal_setExclusiveHook(NULL);
+	taken += _takePendingFires();
+
+	CHECK_EQUAL(NUM_FIRES, taken);
+	CHECK_EQUAL(0, _takePendingFires());
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(NUM_FIRES, stats.alarmsFired);
+}
+
+
+static void test_noFireLost(void)
+{
+	_stress(NULL);
+}
+
+
+#if (__CORTEX_M >= 3U)
+
+/* _waitForFire
+ *
+ * Waits between an exclusive load and its store until the interrupt thread has
+ * signalled another fire, so that the store races it.
+ */
+static void _waitForFire(void)
+{
+	uint32_t before = atomic_load(&_signalled);
+
+	atomic_store(&_hasLoaded, true);
+	while (atomic_load(&_isSignalling) && atomic_load(&_signalled) == before)
+	{
+	}
+}
+
+
+static void test_noFireLostWhenStoreRaces(void)
+{
+	HostHalCounters hal;
+
+	// every exchange is interrupted between its load and store, the store fails
+	// and the exchange is retried with the new count.  The first fire waits for
+	// the first load, so that at least one store races it
+	_stress(_waitForFire);
+
+	hostHal_getCounters(&hal);
+	CHECK(hal.exclusiveFails > 0U);
+}
+
+#endif
+
+
+int main(void)
+{
+	hostTest_run("no fire lost", test_noFireLost);
+#if (__CORTEX_M >= 3U)
+	hostTest_run("no fire lost when the store races", test_noFireLostWhenStoreRaces);
+#endif
+
+	return hostTest_finish();
+}
@@ -0,0 +1,162 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Alarm A/B ping-pong tests: back-to-back one-second events run every
+ * transition on its alarm, with both alarms taking turns, also when the RTC
+ * moves on while the alarms are being armed.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar, a minute before midnight.
+ */
+static const DateTime START = {24, 12, 31, 23, 59, 0, 0};
+
+/*
+ * Number of back-to-back events.
+ */
+#define NUM_EVENTS 30
+
+/*
+ * Milliseconds a transition may run from its time when register accesses are
+ * slow, well under the one-second spacing of the events.
+ */
+#define SLOW_TOLERANCE_MS 250U
+
+/*
+ * Calendar milliseconds at each callback.
+ */
+static uint64_t _startedAt[NUM_EVENTS];
+static uint64_t _endedAt[NUM_EVENTS];
+static int _starts;
+static int _ends;
+
+/*
+ * Microseconds the clock moves on with each register access of a slow arm.
+ */
+static uint64_t _accessMicros;
+
+
+static void _onStart(void)
+{
+	if (_starts < NUM_EVENTS)
+		_startedAt[_starts] = hostTest_nowMillis();
+	_starts++;
+}
+
+
+static void _onEnd(void)
+{
+	if (_ends < NUM_EVENTS)
+		_endedAt[_ends] = hostTest_nowMillis();
+	_ends++;
+}
+
+
+/* _slowAccess
+ *
+ * Moves the clock on with a register access, as a slow bus would.
+ */
+static void _slowAccess(void)
+{
+	virtualRtc_advance(_accessMicros);
+}
+
+
+/* _addBackToBack
+ *
+ * Adds one-second events, each starting when the one before it ends, from a
+ * second after the start.
+ */
+static void _addBackToBack(void)
+{
+	int i;
+
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		CalendarEvent event = {
+			.start = hostTest_dateTime(START, (uint64_t)(i + 1) * 1000U),
+			.end = hostTest_dateTime(START, (uint64_t)(i + 2) * 1000U),
+			.start_callback = _onStart,
+			.end_callback = _onEnd,
+		};
+
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(event));
+	}
+}
+
+
+static void test_backToBackEvents(void)
+{
+	VirtualRtcCounters rtc;
+	uint64_t start;
+	int i;
+
+	hostTest_initCalendar(START);
+	_addBackToBack();
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	hostTest_runFor((NUM_EVENTS + 5U) * 1000000ULL);
+
+	// no transition was missed, each ran on its alarm across the new year
+	CHECK_EQUAL(NUM_EVENTS, _starts);
+	CHECK_EQUAL(NUM_EVENTS, _ends);
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		start = hostTest_millisOf(START) + ((uint64_t)(i + 1) * 1000U);
+		CHECK(_startedAt[i] >= start);
+		CHECK(_startedAt[i] <= start + hostTest_resolutionMillis());
+		CHECK(_endedAt[i] >= start + 1000U);
+		CHECK(_endedAt[i] <= start + 1000U + hostTest_resolutionMillis());
+	}
+
+	// both alarms took turns
+	virtualRtc_getCounters(&rtc);
+	CHECK(rtc.alarmMatches[0] >= NUM_EVENTS / 2);
+	CHECK(rtc.alarmMatches[1] >= NUM_EVENTS / 2);
+	CHECK_EQUAL(0, rtc.ignoredWrites);
+}
+
+
+static void test_slowArmingMissesNoTransition(void)
+{
+	uint64_t start;
+	int i;
+
+	hostTest_initCalendar(START);
+	_addBackToBack();
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	// each register access takes a millisecond, so an update's arming takes
+	// several ticks
+	_accessMicros = 1000U;
+	virtualRtc_setAccessHook(_slowAccess);
+	hostTest_runFor((NUM_EVENTS + 5U) * 1000000ULL);
+	virtualRtc_setAccessHook(NULL);
+
+	// every transition ran near its time, latency compensation moving the
+	// alarms ahead of the slow accesses
+	CHECK_EQUAL(NUM_EVENTS, _starts);
+	CHECK_EQUAL(NUM_EVENTS, _ends);
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		start = hostTest_millisOf(START) + ((uint64_t)(i + 1) * 1000U);
+		CHECK(_startedAt[i] + SLOW_TOLERANCE_MS >= start);
+		CHECK(_startedAt[i] <= start + SLOW_TOLERANCE_MS);
+		CHECK(_endedAt[i] + SLOW_TOLERANCE_MS >= start + 1000U);
+		CHECK(_endedAt[i] <= start + 1000U + SLOW_TOLERANCE_MS);
+	}
+}
+
+
+int main(void)
+{
+	hostTest_run("back-to-back events", test_backToBackEvents);
+	hostTest_run("slow arming misses no transition", test_slowArmingMissesNoTransition);
+
+	return hostTest_finish();
+}
@@ -0,0 +1,141 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Rebase tests of the binary backend: once the counter runs half its range past
+ * the base, reading the time moves the base forward and stores it in the backup
+ * registers.  A read from the main loop and one from the second tick interrupt
+ * both rebase, so an interrupt raised while the main loop reads the counter must
+ * not be taken until its rebase is done.  The BCD backend has no base, and no
+ * cases here.
+ */
+
+
+#include <host_test.h>
+
+
+#ifdef RTC_CALENDAR_CONTROL_BINARY
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 1, 1, 0, 0, 0, 0};
+
+/*
+ * Seconds to the first rebase, half the counter's range at 256 Hz, and past it.
+ */
+#define REBASE_SECONDS (0x80000000ULL / 256U)
+#define PAST_REBASE_SECONDS 10U
+
+/*
+ * Line of the second tick interrupt, a spare line of the Host HAL.
+ */
+#define SECOND_TICK_IRQn ((IRQn_Type)3)
+
+
+/*
+ * Backup register holding the base's seconds when the interrupt was taken, and
+ * the interrupts taken.
+ */
+static uint32_t _baseAtTick;
+static int _ticks;
+static bool _isRaising;
+
+
+static bool _isNotAsserted(void)
+{
+	return false;
+}
+
+
+/* _secondTick
+ *
+ * Second tick interrupt, reading the time.
+ */
+static void _secondTick(void)
+{
+	_baseAtTick = READ_REG(TAMP->BKPR[RTC_BKP_DR0]);
+	_ticks++;
+	calendar_secondTick_ISR();
+}
+
+
+/* _raiseOnRead
+ *
+ * Raises the second tick interrupt as the main loop reads the counter.
+ */
+static void _raiseOnRead(void)
+{
+	if (_isRaising && !hostHal_isInIrq())
+	{
+		_isRaising = false;
+		hostHal_raiseIrq(SECOND_TICK_IRQn);
+	}
+}
+
+
+static void test_interruptDuringRebase(void)
+{
+	uint32_t baseBefore;
+	uint32_t seconds;
+	uint16_t millisecond;
+	uint32_t expected;
+
+	hostTest_initCalendar(START);
+	hostHal_setIrqHandler(SECOND_TICK_IRQn, _secondTick, _isNotAsserted);
+	HAL_NVIC_EnableIRQ(SECOND_TICK_IRQn);
+	virtualRtc_advance((REBASE_SECONDS + PAST_REBASE_SECONDS) * 1000000U);
+	baseBefore = READ_REG(TAMP->BKPR[RTC_BKP_DR0]);
+
+	// the tick is raised as the main loop reads the counter, and taken once its
+	// read has rebased
+	_isRaising = true;
+	virtualRtc_setAccessHook(_raiseOnRead);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getEpoch(&seconds, &millisecond));
+	virtualRtc_setAccessHook(NULL);
+
+	expected = dateTime_toSeconds(START) + (uint32_t)REBASE_SECONDS + PAST_REBASE_SECONDS;
+	CHECK_EQUAL(1, _ticks);
+	CHECK(_baseAtTick != baseBefore);
+	CHECK_EQUAL(expected, seconds);
+	CHECK_EQUAL(expected, calendar_getCachedEpoch());
+
+	// the base was moved once, by whole seconds, and converts the counter to the
+	// same time from the backup registers
+	CHECK_EQUAL(_baseAtTick, READ_REG(TAMP->BKPR[RTC_BKP_DR0]));
+	CHECK(READ_REG(TAMP->BKPR[RTC_BKP_DR0]) <= expected);
+	CHECK_EQUAL((expected - READ_REG(TAMP->BKPR[RTC_BKP_DR0])) * 256U,
+			~READ_REG(virtualRtc_rtc.SSR) - READ_REG(TAMP->BKPR[RTC_BKP_DR1]));
+}
+
+
+static void test_timeAcrossRebase(void)
+{
+	uint32_t seconds;
+	uint16_t millisecond;
+	uint64_t step;
+
+	hostTest_initCalendar(START);
+	virtualRtc_advance((REBASE_SECONDS - 2U) * 1000000U);
+
+	// reads stay continuous through the rebase
+	for (step = 0; step < 4U; step++)
+	{
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_getEpoch(&seconds, &millisecond));
+		CHECK_EQUAL(dateTime_toSeconds(START) + REBASE_SECONDS - 2U + step, seconds);
+		virtualRtc_advance(1000000U);
+	}
+}
+
+#endif
+
+
+int main(void)
+{
+#ifdef RTC_CALENDAR_CONTROL_BINARY
+	hostTest_run("interrupt during a rebase", test_interruptDuringRebase);
+	hostTest_run("time across a rebase", test_timeAcrossRebase);
+#endif
+
+	return hostTest_finish();
+}
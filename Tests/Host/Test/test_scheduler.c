@@ -0,0 +1,244 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Scheduler tests on the Virtual RTC: events start and end on their alarms,
+ * far events are reached through hop alarms, the statistics count them and
+ * start over when the events are reset, and the RTC reads back the time the
+ * clock moved to.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar, a leap day.
+ */
+static const DateTime START = {24, 2, 29, 23, 59, 0, 0};
+
+/*
+ * Calendar milliseconds at each callback.
+ */
+static uint64_t _startedAt[4];
+static uint64_t _endedAt[4];
+static int _starts;
+static int _ends;
+
+
+static void _onStart(void)
+{
+	if (_starts < 4)
+		_startedAt[_starts] = hostTest_nowMillis();
+	_starts++;
+}
+
+
+static void _onEnd(void)
+{
+	if (_ends < 4)
+		_endedAt[_ends] = hostTest_nowMillis();
+	_ends++;
+}
+
+
+/* _checkAt
+ *
+ * Checks that a callback ran on the alarm of its time, within one tick.
+ */
+static void _checkAt(const DateTime expected, const uint64_t actualMillis)
+{
+	uint64_t expectedMillis = hostTest_millisOf(expected);
+
+	CHECK(actualMillis >= expectedMillis);
+	CHECK(actualMillis <= expectedMillis + hostTest_resolutionMillis());
+}
+
+
+/* _addEvent
+ *
+ * Adds an event some milliseconds from the start, lasting some milliseconds.
+ */
+static void _addEvent(const uint64_t startMillis, const uint64_t lengthMillis)
+{
+	CalendarEvent event = {
+		.start = hostTest_dateTime(START, startMillis),
+		.end = hostTest_dateTime(START, startMillis + lengthMillis),
+		.start_callback = _onStart,
+		.end_callback = _onEnd,
+	};
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(event));
+}
+
+
+static void test_eventsRunOnTheirAlarms(void)
+{
+	VirtualRtcCounters rtc;
+	HostHalCounters hal;
+
+	hostTest_initCalendar(START);
+	_addEvent(1500, 250);
+	_addEvent(90000, 3600000);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	hostTest_runFor(2ULL * 3600U * 1000000U);
+
+	CHECK_EQUAL(2, _starts);
+	CHECK_EQUAL(2, _ends);
+	_checkAt(hostTest_dateTime(START, 1500), _startedAt[0]);
+	_checkAt(hostTest_dateTime(START, 1750), _endedAt[0]);
+	_checkAt(hostTest_dateTime(START, 90000), _startedAt[1]);
+	_checkAt(hostTest_dateTime(START, 3690000), _endedAt[1]);
+
+	// every write reached the RTC and every interrupt was cleared
+	virtualRtc_getCounters(&rtc);
+	hostHal_getCounters(&hal);
+	CHECK_EQUAL(0, rtc.ignoredWrites);
+	CHECK_EQUAL(0, hal.stuckIrqs);
+}
+
+
+static void test_halInterruptPath(void)
+{
+	hostTest_initCalendar(START);
+	hostTest_useHalIrq(true);
+	_addEvent(2000, 1000);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	hostTest_runFor(10U * 1000000U);
+
+	CHECK_EQUAL(1, _starts);
+	CHECK_EQUAL(1, _ends);
+	_checkAt(hostTest_dateTime(START, 2000), _startedAt[0]);
+	_checkAt(hostTest_dateTime(START, 3000), _endedAt[0]);
+}
+
+
+static void test_farEventHops(void)
+{
+	uint32_t hops = 0;
+	uint64_t days = 70;
+
+	hostTest_initCalendar(START);
+	_addEvent(days * 86400U * 1000U, 60000);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	hostTest_runFor((days + 1U) * 86400ULL * 1000000U);
+
+	CHECK_EQUAL(1, _starts);
+	CHECK_EQUAL(1, _ends);
+	_checkAt(hostTest_dateTime(START, days * 86400U * 1000U), _startedAt[0]);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getHopWakeups(&hops));
+#ifndef RTC_CALENDAR_CONTROL_BINARY
+	// BCD alarms reach at most a month ahead
+	CHECK(hops >= 2);
+#endif
+}
+
+
+/* _checkStatsZero
+ *
+ * Checks that the statistics and hop wakeups are all zero.
+ */
+static void _checkStatsZero(void)
+{
+	CalendarStats stats;
+	uint32_t hops = 1;
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getHopWakeups(&hops));
+	CHECK_EQUAL(0, hops);
+	CHECK_EQUAL(0, stats.updates);
+	CHECK_EQUAL(0, stats.alarmsFired);
+	CHECK_EQUAL(0, stats.spuriousAlarms);
+	CHECK_EQUAL(0, stats.storms);
+	CHECK_EQUAL(0, stats.transitions);
+	CHECK_EQUAL(0, stats.skippedTransitions);
+	CHECK_EQUAL(0, stats.rearms);
+	CHECK_EQUAL(0, stats.maxUpdateCycles);
+	CHECK_EQUAL(0, stats.maxEvents);
+}
+
+
+static void test_statsResetWithEvents(void)
+{
+	CalendarStats stats;
+	uint32_t hops = 0;
+	uint64_t days = 70;
+
+	hostTest_initCalendar(START);
+	_checkStatsZero();
+
+	// the first event's alarms re-arm with the second's from the interrupt, and
+	// the far event is reached through hops
+	_addEvent(1500, 250);
+	_addEvent(90000, 60000);
+	_addEvent(days * 86400U * 1000U, 60000);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	hostTest_runFor((days + 1U) * 86400ULL * 1000000U);
+
+	CHECK_EQUAL(3, _starts);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getHopWakeups(&hops));
+	CHECK_EQUAL(6, stats.transitions);
+	CHECK(stats.rearms > 0U);
+	CHECK(stats.alarmsFired >= stats.rearms);
+	CHECK(stats.updates >= stats.alarmsFired);
+	CHECK_EQUAL(3, stats.maxEvents);
+	CHECK_EQUAL(0, stats.spuriousAlarms);
+#ifndef RTC_CALENDAR_CONTROL_BINARY
+	CHECK(hops >= 2);
+#endif
+
+	// resetting the events starts the counts over
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_resetEvents());
+	_checkStatsZero();
+
+	_addEvent((days + 2U) * 86400U * 1000U, 1000);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	hostTest_runFor(2ULL * 86400U * 1000000U);
+
+	CHECK_EQUAL(4, _starts);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(2, stats.transitions);
+	CHECK_EQUAL(1, stats.maxEvents);
+}
+
+
+static void test_readsBackTheClock(void)
+{
+	DateTime now;
+	uint32_t seconds;
+	uint16_t millisecond;
+	uint64_t expected;
+
+	hostTest_initCalendar(START);
+	virtualRtc_advance((86400ULL * 1000000U) + 1500000U);
+	expected = hostTest_millisOf(START) + (86400U * 1000U) + 1500U;
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getDateTime(&now));
+	CHECK_EQUAL(24, now.year);
+	CHECK_EQUAL(3, now.month);
+	CHECK_EQUAL(1, now.day);
+	CHECK_EQUAL(23, now.hour);
+	CHECK_EQUAL(59, now.minute);
+	CHECK_EQUAL(1, now.second);
+	CHECK(now.millisecond >= 500 - hostTest_resolutionMillis());
+	CHECK(now.millisecond <= 500 + hostTest_resolutionMillis());
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getEpoch(&seconds, &millisecond));
+	CHECK_EQUAL(expected / 1000U, seconds);
+}
+
+
+int main(void)
+{
+	hostTest_run("events run on their alarms", test_eventsRunOnTheirAlarms);
+	hostTest_run("HAL interrupt path", test_halInterruptPath);
+	hostTest_run("far event hops", test_farEventHops);
+	hostTest_run("stats reset with the events", test_statsResetWithEvents);
+	hostTest_run("reads back the clock", test_readsBackTheClock);
+
+	return hostTest_finish();
+}
@@ -0,0 +1,307 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Alarm interrupt storm tests: an alarm flag that sets again as soon as it is
+ * cleared masks the alarm interrupt after a few entries instead of starving the
+ * main loop, also when it starts while the main loop is updating, and the next
+ * update unmasks it and runs the schedule on.  Transitions that fire as fast as
+ * the alarms and the lookahead allow are not taken as a storm.  Storms and
+ * alarms that fired before either alarm was reached are counted until the events
+ * are reset.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 8, 15, 9, 30, 0, 0};
+
+/*
+ * Number of one-second events, every other second from a second after the
+ * start.
+ */
+#define NUM_EVENTS 4
+
+/*
+ * Interrupt entries a storm may take before it is masked, well under the
+ * entries the host HAL takes a line as stuck after.
+ */
+#define MAX_STORM_ENTRIES 16U
+
+/*
+ * Calendar milliseconds at each start callback.
+ */
+static uint64_t _startedAt[NUM_EVENTS];
+static int _starts;
+
+/*
+ * Register accesses left that set the Alarm A flag again.
+ */
+static uint32_t _glitchesLeft;
+
+
+static void _onStart(void)
+{
+	if (_starts < NUM_EVENTS)
+		_startedAt[_starts] = hostTest_nowMillis();
+	_starts++;
+}
+
+
+/* _glitch
+ *
+ * Sets the Alarm A flag again with a register access, as a faulty alarm would.
+ */
+static void _glitch(void)
+{
+	if (_glitchesLeft > 0U)
+	{
+		_glitchesLeft--;
+		virtualRtc_raiseFlags(RTC_SR_ALRAF, false);
+	}
+}
+
+
+/* _storm
+ *
+ * Sets the Alarm A flag again with each register access while a function runs.
+ */
+static void _storm(void (*run)(void), const uint32_t glitches)
+{
+	_glitchesLeft = glitches;
+	virtualRtc_setAccessHook(_glitch);
+	run();
+	virtualRtc_setAccessHook(NULL);
+}
+
+
+/* _raiseAlarmA
+ *
+ * Sets the Alarm A flag.
+ */
+static void _raiseAlarmA(void)
+{
+	virtualRtc_raiseFlags(RTC_SR_ALRAF, false);
+}
+
+
+/* _update
+ *
+ * Updates the scheduler.
+ */
+static void _update(void)
+{
+	calendar_updateScheduler();
+}
+
+
+/* _start
+ *
+ * Initializes the calendar with the events, starts it and arms the alarms.
+ */
+static void _start(void)
+{
+	int i;
+
+	hostTest_initCalendar(START);
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		CalendarEvent event = {
+			.start = hostTest_dateTime(START, (uint64_t)(2 * i + 1) * 1000U),
+			.end = hostTest_dateTime(START, (uint64_t)(2 * i + 2) * 1000U),
+			.start_callback = _onStart,
+		};
+
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(event));
+	}
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_updateScheduler());
+}
+
+
+/* _checkRecovered
+ *
+ * Checks that one storm was recovered from, the interrupt was never taken as
+ * stuck, and the schedule runs on its alarms after it.
+ */
+static void _checkRecovered(void)
+{
+	HostHalCounters hal;
+	CalendarStats stats;
+	uint64_t start;
+	int i;
+
+	hostHal_getCounters(&hal);
+	CHECK_EQUAL(0, hal.stuckIrqs);
+	CHECK(hal.irqEntries <= MAX_STORM_ENTRIES);
+
+	hostTest_runFor(2U * (NUM_EVENTS + 1U) * 1000000ULL);
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(1, stats.storms);
+	CHECK(!virtualRtc_isAsserted());
+
+	CHECK_EQUAL(NUM_EVENTS, _starts);
+	for (i = 0; i < NUM_EVENTS; i++)
+	{
+		start = hostTest_millisOf(START) + ((uint64_t)(2 * i + 1) * 1000U);
+		CHECK(_startedAt[i] >= start);
+		CHECK(_startedAt[i] <= start + hostTest_resolutionMillis());
+	}
+}
+
+
+static void test_stormIsMasked(void)
+{
+	HostHalCounters hal;
+	CalendarStats stats;
+
+	_start();
+
+	// the flag sets again with every access of the alarm interrupt, the main loop
+	// is not running
+	_storm(_raiseAlarmA, UINT32_MAX);
+
+	// the interrupt was masked after a few entries, still asserted
+	hostHal_getCounters(&hal);
+	CHECK(hal.irqEntries > 1U);
+	CHECK(hal.irqEntries <= MAX_STORM_ENTRIES);
+	CHECK(virtualRtc_isAsserted());
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(0, stats.storms);
+
+	_checkRecovered();
+}
+
+
+static void test_stormDuringUpdate(void)
+{
+	_start();
+
+	// the storm starts while the main loop updates for the first alarm, after it
+	// took the fires pending
+	virtualRtc_advanceToAlarm(2000000U);
+	_storm(_update, UINT32_MAX);
+
+	// the next update recovers with the interrupt masked, the first event has
+	// started
+	CHECK_EQUAL(1, _starts);
+	_checkRecovered();
+}
+
+
+static void test_alarmDuringRecovery(void)
+{
+	_start();
+
+	_storm(_raiseAlarmA, UINT32_MAX);
+
+	// the flag is set once more while the recovering update disarms the alarms,
+	// with the interrupt still masked
+	_storm(_update, 1U);
+
+	_checkRecovered();
+}
+
+
+static void test_burstIsNotStorm(void)
+{
+	HostHalCounters hal;
+	CalendarStats stats;
+	int i;
+
+	hostTest_initCalendar(START);
+	for (i = 0; i < NUM_EVENTS * 2; i++)
+	{
+		CalendarEvent event = {
+			.start = hostTest_dateTime(START, 1000U + ((uint64_t)i * 200U)),
+			.end = hostTest_dateTime(START, 1100U + ((uint64_t)i * 200U)),
+		};
+
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_addEvent(event));
+	}
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_updateScheduler());
+
+	// transitions a tenth of a second apart while the main loop is not running,
+	// the armed alarms fire and are re-armed from the lookahead until it runs out
+	hostHal_reset();
+	hostTest_useHalIrq(false);
+	HAL_NVIC_EnableIRQ(VIRTUAL_RTC_IRQn);
+	virtualRtc_advance(3000000U);
+	hostHal_getCounters(&hal);
+	CHECK(hal.irqEntries > 4U);
+
+	// genuine fires are not a storm, the update runs the rest
+	hostTest_runFor(2000000U);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(0, stats.storms);
+	CHECK_EQUAL(NUM_EVENTS * 4, stats.transitions);
+}
+
+
+/* _checkFaults
+ *
+ * Checks the alarm faults counted, from both getters.
+ */
+static void _checkFaults(const uint32_t expectedStorms, const uint32_t expectedMismatches)
+{
+	CalendarStats stats;
+	uint32_t storms = UINT32_MAX;
+	uint32_t mismatches = UINT32_MAX;
+
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getAlarmFaults(&storms, &mismatches));
+	CHECK_EQUAL(expectedStorms, storms);
+	CHECK_EQUAL(expectedMismatches, mismatches);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(expectedStorms, stats.storms);
+	CHECK_EQUAL(expectedMismatches, stats.spuriousAlarms);
+}
+
+
+static void test_faultsResetWithEvents(void)
+{
+	CalendarStats before;
+	CalendarStats stats;
+
+	_start();
+	_checkFaults(0, 0);
+
+	// a storm, recovered from by the next update
+	_storm(_raiseAlarmA, UINT32_MAX);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_updateScheduler());
+	_checkFaults(1, 0);
+
+	// an alarm flag set before either alarm is reached re-arms Alarm A from the
+	// lookahead, and the update finds neither reached
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&before));
+	_raiseAlarmA();
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(before.rearms + 1U, stats.rearms);
+	CHECK_EQUAL(before.alarmsFired + 1U, stats.alarmsFired);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_updateScheduler());
+	_checkFaults(1, 1);
+
+	// resetting the events starts the counts over
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_resetEvents());
+	_checkFaults(0, 0);
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_getStats(&stats));
+	CHECK_EQUAL(0, stats.rearms);
+	CHECK_EQUAL(0, stats.alarmsFired);
+}
+
+
+int main(void)
+{
+	hostTest_run("storm is masked", test_stormIsMasked);
+	hostTest_run("storm during an update", test_stormDuringUpdate);
+	hostTest_run("alarm during recovery", test_alarmDuringRecovery);
+	hostTest_run("burst of transitions is not a storm", test_burstIsNotStorm);
+	hostTest_run("faults reset with the events", test_faultsResetWithEvents);
+
+	return hostTest_finish();
+}
@@ -0,0 +1,147 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Sub-second tests: each tick of the RTC's sub-second counter reads back as the
+ * millisecond it starts at, and transitions at every millisecond of a second fire
+ * on the first tick at or after it.  The lag of a fire behind its millisecond is
+ * less than one tick, and the time read in its callback is never before it.
+ */
+
+
+#include <host_test.h>
+
+
+/*
+ * Start of the tests' calendar.
+ */
+static const DateTime START = {24, 8, 31, 23, 59, 50, 0};
+
+/*
+ * Triggers, one a second, and the milliseconds between their targets within the
+ * second, stepping across the second's ticks.  The last is at 999 ms, within the
+ * last tick of the second.
+ */
+#define NUM_TRIGGERS MAX_NUM_EVENTS
+#define TARGET_STEP_MS 31U
+
+/*
+ * Target and the time fired of each trigger, in milliseconds from the start, and
+ * the time read in its callback, in milliseconds since the start of the century.
+ */
+static uint32_t _targets[NUM_TRIGGERS];
+static uint64_t _firedMicros[NUM_TRIGGERS];
+static uint64_t _readMillis[NUM_TRIGGERS];
+static int _fired;
+
+
+/* _microsFromStart
+ *
+ * Gets the Virtual RTC's calendar in microseconds from the start.
+ */
+static uint64_t _microsFromStart(void)
+{
+	uint64_t micros = virtualRtc_getCalendarMicros();
+
+	// the binary counter counts from the time set, the BCD calendar holds it
+	if (HOST_TEST_BIN_MODE != RTC_BINARY_ONLY)
+		micros -= hostTest_millisOf(START) * 1000U;
+
+	return micros;
+}
+
+
+static void _onTrigger(void)
+{
+	uint32_t seconds;
+	uint16_t millisecond;
+
+	if (_fired < NUM_TRIGGERS)
+	{
+		_firedMicros[_fired] = _microsFromStart();
+		calendar_getEpoch(&seconds, &millisecond);
+		_readMillis[_fired] = ((uint64_t)seconds * 1000U) + millisecond;
+	}
+	_fired++;
+}
+
+
+static void test_ticksReadBack(void)
+{
+	uint32_t ticksPerSecond;
+	uint32_t tick;
+	uint32_t seconds;
+	uint16_t millisecond;
+	uint64_t at;
+
+	hostTest_initCalendar(START);
+	ticksPerSecond = virtualRtc_getTicksPerSecond();
+
+	// each tick reads as the millisecond it starts at, rounded down, the last
+	// reading within a tick of the end of the second
+	for (tick = 0; tick < ticksPerSecond; tick++)
+	{
+		at = (((uint64_t)tick * 1000000U) + ticksPerSecond - 1U) / ticksPerSecond;
+		virtualRtc_advance(at - _microsFromStart());
+
+		CHECK_EQUAL(CALENDAR_OKAY, calendar_getEpoch(&seconds, &millisecond));
+		CHECK_EQUAL((tick * 1000U) / ticksPerSecond, millisecond);
+	}
+	CHECK(millisecond >= 1000U - hostTest_resolutionMillis());
+}
+
+
+static void test_firesOnSubSecondTargets(void)
+{
+	uint64_t tickMicros;
+	uint64_t lag;
+	uint64_t maxLag = 0;
+	uint64_t totalLag = 0;
+	int i;
+
+	hostTest_initCalendar(START);
+	tickMicros = (1000000U + virtualRtc_getTicksPerSecond() - 1U) / virtualRtc_getTicksPerSecond();
+
+	// one trigger a second, each at a later millisecond of its second, crossing
+	// into the next minute, hour and day
+	for (i = 0; i < NUM_TRIGGERS; i++)
+	{
+		_targets[i] = ((uint32_t)(i + 1) * 1000U)
+				+ ((i == NUM_TRIGGERS - 1) ? 999U : ((i * TARGET_STEP_MS) % 1000U));
+		CHECK_EQUAL(CALENDAR_OKAY,
+				calendar_addTrigger(hostTest_dateTime(START, _targets[i]), _onTrigger));
+	}
+	CHECK_EQUAL(CALENDAR_OKAY, calendar_startScheduler());
+
+	hostTest_runFor((NUM_TRIGGERS + 2ULL) * 1000000U);
+
+	CHECK_EQUAL(NUM_TRIGGERS, _fired);
+	for (i = 0; i < NUM_TRIGGERS && i < _fired; i++)
+	{
+		// fired on the first tick at or after the target
+		CHECK(_firedMicros[i] >= (uint64_t)_targets[i] * 1000U);
+		lag = _firedMicros[i] - ((uint64_t)_targets[i] * 1000U);
+		CHECK(lag < tickMicros);
+
+		// the time read when it fired is not before it
+		CHECK(_readMillis[i] >= hostTest_millisOf(START) + _targets[i]);
+
+		if (lag > maxLag)
+			maxLag = lag;
+		totalLag += lag;
+	}
+
+	// targets spread over the ticks lag by half a tick on average
+	CHECK(totalLag / NUM_TRIGGERS > tickMicros / 4U);
+	CHECK(totalLag / NUM_TRIGGERS < (3U * tickMicros) / 4U);
+	CHECK(maxLag > tickMicros / 2U);
+}
+
+
+int main(void)
+{
+	hostTest_run("ticks read back", test_ticksReadBack);
+	hostTest_run("fires on sub-second targets", test_firesOnSubSecondTargets);
+
+	return hostTest_finish();
+}
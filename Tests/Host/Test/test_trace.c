@@ -0,0 +1,250 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Trace tests: records read back in order with calendarTrace_read(), a cursor
+ * that fell behind the ring skips to its oldest record, and a record still being
+ * written is not read until it is complete.  A dump of the buffer and a stream
+ * of read records are decoded by Tools/calendar_trace_decode.py.  Only built
+ * with the trace (the trace variant).
+ */
+
+
+#include <host_test.h>
+#include <calendar_trace.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#ifdef CALENDAR_TRACE
+
+/*
+ * Trace decoder, from the directory the tests are run in.
+ */
+#define TRACE_DECODER "python3 ../../Tools/calendar_trace_decode.py"
+
+/*
+ * Records written past the end of the ring.
+ */
+#define OVERRUN 10U
+
+/*
+ * Longest line of the decoder's output.
+ */
+#define MAX_LINE 160
+
+
+/* _recordMany
+ *
+ * Records events entered, numbered on from the records so far.
+ */
+static void _recordMany(const uint32_t count)
+{
+	uint32_t i;
+	uint32_t head = calendarTrace_getBuffer()->head;
+
+	for (i = 0; i < count; i++)
+		calendarTrace_record(CALENDAR_TRACE_EVENT_ENTERED, (uint16_t)(head + i), head + i);
+}
+
+
+/* _checkRead
+ *
+ * Reads a record and checks it is the record with a sequence.
+ */
+static void _checkRead(uint32_t* const cursor, const uint32_t sequence)
+{
+	CalendarTraceRecord record;
+
+	CHECK(calendarTrace_read(cursor, &record));
+	CHECK_EQUAL(sequence, record.sequence);
+	CHECK_EQUAL(CALENDAR_TRACE_EVENT_ENTERED, record.type);
+	CHECK_EQUAL((uint16_t)(sequence - 1U), record.arg);
+	CHECK_EQUAL(sequence - 1U, record.seconds);
+	CHECK_EQUAL(sequence, *cursor);
+}
+
+
+/* _decode
+ *
+ * Writes bytes to a file and decodes it, returning the number of lines of the
+ * timeline and keeping the first and whether any reported lost records.
+ */
+static int _decode(const void* const data, const size_t size, char* const first,
+		bool* const isLost)
+{
+	char path[] = "/tmp/calendar_traceXXXXXX";
+	char command[sizeof(TRACE_DECODER) + sizeof(path) + 1];
+	char line[MAX_LINE];
+	FILE* file;
+	FILE* decoder;
+	int fd;
+	int lines = 0;
+
+	*isLost = false;
+	first[0] = '\0';
+
+	fd = mkstemp(path);
+	CHECK(fd >= 0);
+	if (fd < 0)
+		return 0;
+	file = fdopen(fd, "wb");
+	CHECK_EQUAL(size, fwrite(data, 1, size, file));
+	fclose(file);
+
+	snprintf(command, sizeof(command), "%s %s", TRACE_DECODER, path);
+	decoder = popen(command, "r");
+	CHECK(decoder != NULL);
+	while (decoder != NULL && fgets(line, sizeof(line), decoder) != NULL)
+	{
+		if (lines == 0)
+			strcpy(first, line);
+		if (strstr(line, "records lost") != NULL)
+			*isLost = true;
+		lines++;
+	}
+	if (decoder != NULL)
+		CHECK_EQUAL(0, pclose(decoder));
+	unlink(path);
+
+	return lines;
+}
+
+
+static void test_readsInOrder(void)
+{
+	CalendarTraceRecord record;
+	uint32_t cursor = 0;
+	uint32_t i;
+
+	calendarTrace_init();
+	_recordMany(CALENDAR_TRACE_SIZE / 2U);
+
+	for (i = 1; i <= CALENDAR_TRACE_SIZE / 2U; i++)
+		_checkRead(&cursor, i);
+	CHECK(!calendarTrace_read(&cursor, &record));
+	CHECK_EQUAL(CALENDAR_TRACE_SIZE / 2U, cursor);
+}
+
+
+static void test_skipsOverwritten(void)
+{
+	CalendarTraceRecord record;
+	uint32_t cursor = 0;
+	uint32_t i;
+
+	// the first records were overwritten, reading from the start begins at the
+	// oldest record left
+	calendarTrace_init();
+	_recordMany(CALENDAR_TRACE_SIZE + OVERRUN);
+
+	for (i = OVERRUN + 1U; i <= CALENDAR_TRACE_SIZE + OVERRUN; i++)
+		_checkRead(&cursor, i);
+	CHECK(!calendarTrace_read(&cursor, &record));
+}
+
+
+static void test_lappedCursor(void)
+{
+	uint32_t cursor = 0;
+	uint32_t head;
+
+	calendarTrace_init();
+	_recordMany(5U);
+	_checkRead(&cursor, 1U);
+	_checkRead(&cursor, 2U);
+
+	// a reader part way through is lapped, twice over
+	_recordMany(2U * CALENDAR_TRACE_SIZE);
+	head = calendarTrace_getBuffer()->head;
+	_checkRead(&cursor, head - CALENDAR_TRACE_SIZE + 1U);
+	_checkRead(&cursor, head - CALENDAR_TRACE_SIZE + 2U);
+}
+
+
+static void test_recordBeingWritten(void)
+{
+	CalendarTraceRecord record;
+	volatile CalendarTraceRecord* slot;
+	uint32_t cursor = 0;
+
+	calendarTrace_init();
+	_recordMany(3U);
+	_checkRead(&cursor, 1U);
+
+	// the next record's sequence is cleared while it is written, it is not read
+	// and the cursor stays on it
+	slot = (volatile CalendarTraceRecord*)&calendarTrace_getBuffer()->records[1];
+	slot->sequence = 0U;
+	CHECK(!calendarTrace_read(&cursor, &record));
+	CHECK_EQUAL(1U, cursor);
+
+	// once complete it is read
+	slot->sequence = 2U;
+	_checkRead(&cursor, 2U);
+	_checkRead(&cursor, 3U);
+}
+
+
+static void test_decodesDump(void)
+{
+	const volatile CalendarTrace* trace;
+	CalendarTrace dump;
+	char first[MAX_LINE];
+	bool isLost;
+
+	// a full buffer decodes to a timeline of every record in it, oldest first
+	calendarTrace_init();
+	_recordMany(CALENDAR_TRACE_SIZE + OVERRUN);
+	trace = calendarTrace_getBuffer();
+	memcpy(&dump, (const void*)trace, sizeof(dump));
+
+	CHECK_EQUAL(CALENDAR_TRACE_SIZE, _decode(&dump, sizeof(dump), first, &isLost));
+	CHECK(!isLost);
+	CHECK_EQUAL(OVERRUN + 1U, (uint32_t)strtoul(first, NULL, 10));
+	CHECK(strstr(first, "EVENT_ENTERED") != NULL);
+}
+
+
+static void test_decodesStream(void)
+{
+	CalendarTraceRecord records[CALENDAR_TRACE_SIZE];
+	char first[MAX_LINE];
+	bool isLost;
+	uint32_t cursor = 0;
+	uint32_t count = 0;
+
+	// records read before and after a lap, the gap reported as lost
+	calendarTrace_init();
+	_recordMany(4U);
+	while (count < 2U && calendarTrace_read(&cursor, &records[count]))
+		count++;
+	_recordMany(CALENDAR_TRACE_SIZE);
+	while (count < CALENDAR_TRACE_SIZE && calendarTrace_read(&cursor, &records[count]))
+		count++;
+
+	CHECK_EQUAL(CALENDAR_TRACE_SIZE, count);
+	CHECK_EQUAL(CALENDAR_TRACE_SIZE + 1U,
+			(uint32_t)_decode(records, sizeof(CalendarTraceRecord) * count, first, &isLost));
+	CHECK(isLost);
+	CHECK_EQUAL(1U, (uint32_t)strtoul(first, NULL, 10));
+}
+
+#endif
+
+
+int main(void)
+{
+#ifdef CALENDAR_TRACE
+	hostTest_run("reads in order", test_readsInOrder);
+	hostTest_run("skips overwritten records", test_skipsOverwritten);
+	hostTest_run("lapped cursor", test_lappedCursor);
+	hostTest_run("record being written", test_recordBeingWritten);
+	hostTest_run("decodes a dump", test_decodesDump);
+	hostTest_run("decodes a stream", test_decodesStream);
+#endif
+
+	return hostTest_finish();
+}
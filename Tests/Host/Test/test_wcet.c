@@ -0,0 +1,65 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Worst-case regression tests: replays the worst layouts wcet_search found for
+ * the event list's operations and the scheduler update, and checks that each
+ * steps through no more nodes of the list than the bound its fixture reached.
+ * Regenerate the fixtures with make wcet when a change lowers a bound.
+ */
+
+
+#include <wcet_fixture.h>
+
+
+/* _replay
+ *
+ * Replays an operation's fixture and checks it against its bound.
+ */
+static void _replay(const WcetOperation operation)
+{
+	WcetLayout layout;
+	uint32_t bound = 0;
+	char path[256];
+
+	wcetFixture_path(WCET_FIXTURE_DIR, operation, path, sizeof(path));
+	CHECK(wcetFixture_read(path, &layout, &bound));
+	CHECK_EQUAL(operation, layout.operation);
+	CHECK(bound > 0U);
+	CHECK(wcetFixture_measure(&layout) <= bound);
+}
+
+
+static void test_insert(void)
+{
+	_replay(WCET_INSERT);
+}
+
+
+static void test_remove(void)
+{
+	_replay(WCET_REMOVE);
+}
+
+
+static void test_nextAlarm(void)
+{
+	_replay(WCET_NEXT_ALARM);
+}
+
+
+static void test_update(void)
+{
+	_replay(WCET_UPDATE);
+}
+
+
+int main(void)
+{
+	hostTest_run("insert within its bound", test_insert);
+	hostTest_run("remove within its bound", test_remove);
+	hostTest_run("next alarm within its bound", test_nextAlarm);
+	hostTest_run("update within its bound", test_update);
+
+	return hostTest_finish();
+}
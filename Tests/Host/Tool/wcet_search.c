@@ -0,0 +1,291 @@
+/*
+ * Author:  Kevin Imlay
+ * Date:  September, 2023
+ *
+ * Worst-case input search: for each of eventSLL_insert(), eventSLL_remove(),
+ * eventSLL_getNextAlarm() and a scheduler update, searches for the event layout,
+ * time, and insertion order that make it step through the most nodes of the
+ * event list, and writes the worst found as a fixture with the bound it reached.
+ *
+ * The search is guided by the work measured: it keeps a corpus of the worst
+ * layouts so far, mutates one of them (moving, stretching, adding, dropping and
+ * reordering events, and moving the time and target), and keeps the mutant if
+ * it does at least as much work as the least of the corpus.  The random sequence
+ * is fixed, so a run with the same iterations finds the same layouts.
+ *
+ *	wcet_search [directory [iterations]]
+ */
+
+
+#include <wcet_fixture.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/*
+ * Iterations of the search for each operation, unless given.
+ */
+#define ITERATIONS 20000
+
+/*
+ * Layouts kept to mutate.
+ */
+#define CORPUS_SIZE 8
+
+/*
+ * Range of the layouts: event starts and the time within SPAN_MS of the start of
+ * the calendar, lengths, leads and slacks up to their maximums.
+ */
+#define SPAN_MS 600000U
+#define MAX_LENGTH_MS 120000U
+#define MAX_LEAD_MS 10000U
+#define MAX_SLACK_S 60U
+
+/*
+ * Mutations applied to a layout.
+ */
+typedef enum {
+	MUTATE_START,
+	MUTATE_NUDGE,
+	MUTATE_LENGTH,
+	MUTATE_LEAD,
+	MUTATE_SLACK,
+	MUTATE_SWAP,
+	MUTATE_ADD,
+	MUTATE_DROP,
+	MUTATE_ALIGN,
+	MUTATE_AT,
+	MUTATE_TARGET,
+	NUM_MUTATIONS
+} Mutation;
+
+
+/*
+ * Corpus of the worst layouts, and the work they reached.
+ */
+static WcetLayout _corpus[CORPUS_SIZE];
+static uint32_t _visits[CORPUS_SIZE];
+static uint64_t _state;
+
+
+/* _random
+ *
+ * Gets the next number of a fixed pseudo-random sequence.
+ */
+static uint32_t _random(void)
+{
+	_state = (_state * 6364136223846793005ULL) + 1442695040888963407ULL;
+
+	return (uint32_t)(_state >> 32);
+}
+
+
+/* _randomEvent
+ *
+ * Gets an event anywhere in the range of the layouts.
+ */
+static WcetEvent _randomEvent(void)
+{
+	WcetEvent event = {
+		.start = _random() % SPAN_MS,
+		.length = (_random() % 4U == 0U) ? 0U : (_random() % MAX_LENGTH_MS),
+		.lead = (_random() % 2U == 0U) ? 0U : (uint16_t)(_random() % MAX_LEAD_MS),
+		.slack = (_random() % 2U == 0U) ? 0U : (uint16_t)(_random() % MAX_SLACK_S),
+	};
+
+	return event;
+}
+
+
+/* _randomLayout
+ *
+ * Gets a layout of random events, to seed the corpus.
+ */
+static void _randomLayout(const WcetOperation operation, WcetLayout* const layout)
+{
+	int i;
+
+	layout->operation = operation;
+	layout->count = 1 + (int)(_random() % MAX_NUM_EVENTS);
+	for (i = 0; i < layout->count; i++)
+		layout->events[i] = _randomEvent();
+	layout->at = _random() % (SPAN_MS + MAX_LENGTH_MS);
+	layout->target = (int)(_random() % (uint32_t)layout->count);
+}
+
+
+/* _mutate
+ *
+ * Applies a random mutation to a layout.
+ */
+static void _mutate(WcetLayout* const layout)
+{
+	WcetEvent* event = &(layout->events[_random() % (uint32_t)layout->count]);
+	WcetEvent swapped;
+	int i;
+	int j;
+
+	switch ((Mutation)(_random() % NUM_MUTATIONS))
+	{
+	case MUTATE_START:
+		event->start = _random() % SPAN_MS;
+		break;
+	case MUTATE_NUDGE:
+		event->start = (event->start + SPAN_MS + (_random() % 2001U) - 1000U) % SPAN_MS;
+		break;
+	case MUTATE_LENGTH:
+		event->length = (_random() % 4U == 0U) ? 0U : (_random() % MAX_LENGTH_MS);
+		break;
+	case MUTATE_LEAD:
+		event->lead = (_random() % 2U == 0U) ? 0U : (uint16_t)(_random() % MAX_LEAD_MS);
+		break;
+	case MUTATE_SLACK:
+		event->slack = (_random() % 2U == 0U) ? 0U : (uint16_t)(_random() % MAX_SLACK_S);
+		break;
+	case MUTATE_SWAP:
+		i = (int)(_random() % (uint32_t)layout->count);
+		j = (int)(_random() % (uint32_t)layout->count);
+		swapped = layout->events[i];
+		layout->events[i] = layout->events[j];
+		layout->events[j] = swapped;
+		break;
+	case MUTATE_ADD:
+		if (layout->count < MAX_NUM_EVENTS)
+		{
+			// a copy of an event nearby, or a new one
+			layout->events[layout->count] = *event;
+			layout->events[layout->count].start = (event->start + (_random() % 1000U)) % SPAN_MS;
+			if (_random() % 2U == 0U)
+				layout->events[layout->count] = _randomEvent();
+			layout->count++;
+		}
+		break;
+	case MUTATE_DROP:
+		if (layout->count > 1)
+		{
+			*event = layout->events[layout->count - 1];
+			layout->count--;
+		}
+		break;
+	case MUTATE_ALIGN:
+		// start at another event's start or end, where transitions share an instant
+		swapped = layout->events[_random() % (uint32_t)layout->count];
+		event->start = (swapped.start + ((_random() % 2U == 0U) ? 0U : swapped.length)) % SPAN_MS;
+		break;
+	case MUTATE_AT:
+		layout->at = (_random() % 2U == 0U) ? (_random() % (SPAN_MS + MAX_LENGTH_MS))
+				: (event->start + event->length);
+		break;
+	default:
+		layout->target = (int)(_random() % (uint32_t)layout->count);
+		break;
+	}
+
+	if (layout->target >= layout->count)
+		layout->target = layout->count - 1;
+}
+
+
+/* _leastIdx
+ *
+ * Gets the index of the corpus layout that reached the least work.
+ */
+static int _leastIdx(void)
+{
+	int least = 0;
+	int i;
+
+	for (i = 1; i < CORPUS_SIZE; i++)
+	{
+		if (_visits[i] < _visits[least])
+			least = i;
+	}
+
+	return least;
+}
+
+
+/* _search
+ *
+ * Searches for the worst layout of an operation.
+ */
+static void _search(const WcetOperation operation, const long iterations, WcetLayout* const worst,
+		uint32_t* const bound, long* const foundAt)
+{
+	WcetLayout mutant;
+	uint32_t visits;
+	long n;
+	int i;
+
+	_state = 2023U + (uint64_t)operation;
+	*bound = 0;
+	*foundAt = 0;
+
+	for (i = 0; i < CORPUS_SIZE; i++)
+	{
+		_randomLayout(operation, &(_corpus[i]));
+		_visits[i] = wcetFixture_measure(&(_corpus[i]));
+		if (i == 0 || _visits[i] > *bound)
+		{
+			*worst = _corpus[i];
+			*bound = _visits[i];
+		}
+	}
+
+	for (n = 1; n <= iterations; n++)
+	{
+		// mutate a layout of the corpus a few times over
+		mutant = _corpus[_random() % CORPUS_SIZE];
+		for (i = 1 + (int)(_random() % 3U); i > 0; i--)
+			_mutate(&mutant);
+
+		// keep it if it does no less work than the least of the corpus, ties
+		// letting the search move across plateaus
+		visits = wcetFixture_measure(&mutant);
+		i = _leastIdx();
+		if (visits >= _visits[i])
+		{
+			_corpus[i] = mutant;
+			_visits[i] = visits;
+		}
+
+		if (visits > *bound)
+		{
+			*worst = mutant;
+			*bound = visits;
+			*foundAt = n;
+		}
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	const char* dir = (argc > 1) ? argv[1] : WCET_FIXTURE_DIR;
+	long iterations = (argc > 2) ? strtol(argv[2], NULL, 10) : ITERATIONS;
+	WcetLayout worst;
+	uint32_t bound;
+	long foundAt;
+	char path[256];
+	int operation;
+
+	printf("# operation  events bound found at  fixture\n");
+	for (operation = 0; operation < WCET_NUM_OPERATIONS; operation++)
+	{
+		_search((WcetOperation)operation, iterations, &worst, &bound, &foundAt);
+
+		// measured again from the fixture's own layout, as the tests replay it
+		bound = wcetFixture_measure(&worst);
+		wcetFixture_path(dir, (WcetOperation)operation, path, sizeof(path));
+		if (!wcetFixture_write(path, &worst, bound))
+		{
+			printf("could not write %s\n", path);
+			return 1;
+		}
+
+		printf("%-11s %7d %5u %8ld  %s\n", WCET_OPERATION_NAMES[operation], worst.count, bound,
+				foundAt, path);
+	}
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+#
+# Author:  Kevin Imlay
+# Date:  September, 2023
+#
+# Purpose:
+#	Decodes a Calendar Trace (calendar_trace.h) into a timeline.  Takes either a
+#	memory dump of the trace buffer taken with a debugger, or a
+#	stream of records read with calendarTrace_read() and sent as their raw bytes,
+#	for example over a UART.
+#
+# Usage:
+#	calendar_trace_decode.py trace.bin
+#
+#	Dumping the buffer with GDB, with the calendar built with CALENDAR_TRACE:
+#		dump binary value trace.bin _trace
+#
+
+import argparse
+import datetime
+import struct
+import sys
+
+
+# matches CALENDAR_TRACE_MAGIC and the CalendarTrace and CalendarTraceRecord
+# structures, little endian
+TRACE_MAGIC = 0x43545243
+HEADER = struct.Struct("<IHHI")
+RECORD = struct.Struct("<IIIHH")
+
+# matches CalendarTraceType
+ALARMS = ("A", "B")
+TYPES = {
+	1: ("ALARM_FIRED", lambda arg: "alarm " + _alarm(arg)),
+	2: ("ALARM_ARMED", lambda arg: "alarm " + _alarm(arg)),
+	3: ("ALARM_HOP_ARMED", lambda arg: "alarm " + _alarm(arg)),
+	4: ("ALARM_REARMED", lambda arg: "alarm " + _alarm(arg)),
+	5: ("ALARM_DISARMED", lambda arg: "alarm " + _alarm(arg)),
+	6: ("EVENT_EXITED", lambda arg: "event %d" % arg),
+	7: ("EVENT_ENTERED", lambda arg: "event %d" % arg),
+	8: ("TRIGGER", lambda arg: "event %d" % arg),
+	9: ("PREPARE", lambda arg: "event %d" % arg),
+	10: ("PAUSED", None),
+	11: ("STARTED", None),
+	12: ("TIME_SET", None),
+	13: ("STORM", lambda arg: "%d fires" % arg),
+	14: ("MISMATCH", None),
+}
+
+# calendar seconds count from the start of the century
+EPOCH = datetime.datetime(2000, 1, 1)
+
+
+def _alarm(arg):
+	return ALARMS[arg] if arg < len(ALARMS) else str(arg)
+
+
+def read_records(data):
+	"""Returns the complete records of a buffer dump or a record stream, oldest
+	first."""
+	records = []
+
+	# a buffer dump starts with its header
+	if len(data) >= HEADER.size and struct.unpack_from("<I", data)[0] == TRACE_MAGIC:
+		_, size, recordSize, head = HEADER.unpack_from(data)
+		if recordSize != RECORD.size:
+			raise ValueError("record size %d, expected %d" % (recordSize, RECORD.size))
+		data = data[HEADER.size:HEADER.size + (size * recordSize)]
+
+	for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+		sequence, seconds, tick, kind, arg = RECORD.unpack_from(data, offset)
+
+		# empty, or being written when dumped
+		if sequence == 0:
+			continue
+		records.append((sequence, seconds, tick, kind, arg))
+
+	records.sort()
+	return records
+
+
+def format_timeline(records):
+	"""Formats records as lines of a timeline, with the time since the previous
+	record from the HAL tick."""
+	lines = []
+	lastSequence = None
+	lastTick = None
+
+	for sequence, seconds, tick, kind, arg in records:
+		if lastSequence is not None and sequence != lastSequence + 1:
+			lines.append("... %d records lost" % (sequence - lastSequence - 1))
+
+		name, describe = TYPES.get(kind, ("UNKNOWN(%d)" % kind, lambda arg: str(arg)))
+		when = EPOCH + datetime.timedelta(seconds=seconds)
+		delta = "" if lastTick is None else "+%dms" % ((tick - lastTick) & 0xFFFFFFFF)
+
+		lines.append("%8d  %s  %10d  %9s  %-16s %s" % (sequence,
+				when.strftime("%y/%m/%d %H:%M:%S"), tick, delta, name,
+				describe(arg) if describe else ""))
+
+		lastSequence = sequence
+		lastTick = tick
+
+	return lines
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Decode a calendar scheduler trace.")
+	parser.add_argument("dump", help="buffer dump or record stream, - for stdin")
+	args = parser.parse_args()
+
+	if args.dump == "-":
+		data = sys.stdin.buffer.read()
+	else:
+		with open(args.dump, "rb") as file:
+			data = file.read()
+
+	for line in format_timeline(read_records(data)):
+		print(line.rstrip())
+
+
+if __name__ == "__main__":
+	main()